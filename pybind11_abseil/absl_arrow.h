@@ -0,0 +1,694 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Conversion of C++ columns to and from the Arrow C data interface
+// (https://arrow.apache.org/docs/format/CDataInterface.html), through the Arrow
+// PyCapsule interface (__arrow_c_schema__ and __arrow_c_array__) implemented by
+// pyarrow, polars, DuckDB etc. There is no build or runtime dependency on
+// Arrow.
+//
+// Exporting: ToArrowArray() returns an object implementing the interface, e.g.
+// for pyarrow.array(obj):
+//
+//   m.def("get_prices", [](const Book& b) {
+//     return pybind11::google::ToArrowArray(b.Prices());
+//   });
+//
+// The element types and their Arrow types are:
+// - arithmetic types: (u)int8 to (u)int64, float32, float64 and boolean.
+// - std::string and absl::string_view: utf8, or binary with
+//   ArrowStringType::kBinary (large_utf8 or large_binary beyond 2 GiB).
+// - absl::Time: timestamp[ns, tz=UTC]. absl::Duration: duration[ns].
+// - absl::StatusOr of one of the above: the non-ok elements are nulls.
+//
+// Containers of arithmetic types (std::vector, absl::InlinedVector,
+// absl::FixedArray, ...) passed as rvalues are moved into the exported array,
+// not copied. So is the memory of a span exported with the python object owning
+// it: ToArrowArray(span, owner). Other element types are converted.
+//
+// Importing: ArrowColumn<T> parameters accept any object implementing
+// __arrow_c_array__ with an Arrow type matching T. The data are not copied:
+// the ArrowColumn owns the imported array.
+//
+//   m.def("total", [](const pybind11::google::ArrowColumn<double>& prices) {
+//     return absl::c_accumulate(prices.values(), 0.0);
+//   });
+
+#ifndef PYBIND11_ABSEIL_ABSL_ARROW_H_
+#define PYBIND11_ABSEIL_ABSL_ARROW_H_
+
+#include <Python.h>
+#include <pybind11/pybind11.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "pybind11_abseil/absl_casters.h"
+#include "pybind11_abseil/dlpack.h"  // PyObjectOwner
+
+// The structs of the Arrow C data interface, as in arrow/c/abi.h.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace pybind11 {
+namespace google {
+
+enum class ArrowStringType { kUtf8, kBinary };
+
+namespace internal {
+
+// The Arrow format of arithmetic type T, or nullptr.
+template <typename T>
+constexpr const char* ArrowArithmeticFormat() {
+  return std::is_same<T, bool>::value ? "b"
+         : std::is_floating_point<T>::value
+             ? (sizeof(T) == 4 ? "f" : sizeof(T) == 8 ? "g" : nullptr)
+         : sizeof(T) == 1 ? (std::is_signed<T>::value ? "c" : "C")
+         : sizeof(T) == 2 ? (std::is_signed<T>::value ? "s" : "S")
+         : sizeof(T) == 4 ? (std::is_signed<T>::value ? "i" : "I")
+         : sizeof(T) == 8 ? (std::is_signed<T>::value ? "l" : "L")
+                          : nullptr;
+}
+
+template <typename T>
+constexpr bool IsArrowPrimitive() {
+  return std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+}
+
+template <typename T>
+struct IsStatusOr : std::false_type {};
+template <typename T>
+struct IsStatusOr<absl::StatusOr<T>> : std::true_type {};
+
+// What an exported array is made of. Immutable once exported: shared by the
+// ArrowSchema and ArrowArray structs exported from it.
+struct ArrowExportState {
+  std::string format;
+  int64_t length = 0;
+  int64_t null_count = 0;
+  int64_t offset = 0;
+  // buffers[0] is the validity bitmap, or nullptr if there are no nulls.
+  std::vector<const void*> buffers;
+  // Own the memory of the buffers.
+  std::vector<std::shared_ptr<const void>> owners;
+};
+
+using ArrowExportStatePtr = std::shared_ptr<const ArrowExportState>;
+
+inline void ReleaseArrowSchema(ArrowSchema* schema) {
+  delete static_cast<ArrowExportStatePtr*>(schema->private_data);
+  schema->release = nullptr;
+}
+
+inline void ReleaseArrowArray(ArrowArray* array) {
+  delete static_cast<ArrowExportStatePtr*>(array->private_data);
+  array->release = nullptr;
+}
+
+// Capsule destructors: release the struct unless a consumer moved it.
+inline void DeleteArrowSchemaCapsule(PyObject* capsule) {
+  auto* schema =
+      static_cast<ArrowSchema*>(PyCapsule_GetPointer(capsule, "arrow_schema"));
+  if (schema == nullptr) {
+    PyErr_Clear();
+    return;
+  }
+  if (schema->release != nullptr) schema->release(schema);
+  delete schema;
+}
+
+inline void DeleteArrowArrayCapsule(PyObject* capsule) {
+  auto* array =
+      static_cast<ArrowArray*>(PyCapsule_GetPointer(capsule, "arrow_array"));
+  if (array == nullptr) {
+    PyErr_Clear();
+    return;
+  }
+  if (array->release != nullptr) array->release(array);
+  delete array;
+}
+
+// Returns a new reference, or nullptr with a python error.
+inline PyObject* NewArrowSchemaCapsule(const ArrowExportStatePtr& state) {
+  auto* schema = new ArrowSchema{state->format.c_str(),
+                                 "",
+                                 nullptr,
+                                 ARROW_FLAG_NULLABLE,
+                                 0,
+                                 nullptr,
+                                 nullptr,
+                                 &ReleaseArrowSchema,
+                                 new ArrowExportStatePtr(state)};
+  PyObject* capsule =
+      PyCapsule_New(schema, "arrow_schema", &DeleteArrowSchemaCapsule);
+  if (capsule == nullptr) {
+    schema->release(schema);
+    delete schema;
+  }
+  return capsule;
+}
+
+// Returns a new reference, or nullptr with a python error.
+inline PyObject* NewArrowArrayCapsule(const ArrowExportStatePtr& state) {
+  auto* array = new ArrowArray{
+      state->length,
+      state->null_count,
+      state->offset,
+      static_cast<int64_t>(state->buffers.size()),
+      0,
+      const_cast<const void**>(state->buffers.data()),
+      nullptr,
+      nullptr,
+      &ReleaseArrowArray,
+      new ArrowExportStatePtr(state)};
+  PyObject* capsule =
+      PyCapsule_New(array, "arrow_array", &DeleteArrowArrayCapsule);
+  if (capsule == nullptr) {
+    array->release(array);
+    delete array;
+  }
+  return capsule;
+}
+
+// The python objects returned by ToArrowArray().
+struct ArrowExportObject {
+  PyObject_HEAD
+  ArrowExportStatePtr* state;
+};
+
+inline const ArrowExportStatePtr& ArrowExportStateOf(PyObject* self) {
+  return *reinterpret_cast<ArrowExportObject*>(self)->state;
+}
+
+inline PyObject* ArrowExportSchemaMethod(PyObject* self, PyObject*) {
+  try {
+    return NewArrowSchemaCapsule(ArrowExportStateOf(self));
+  } catch (const std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
+}
+
+inline PyObject* ArrowExportArrayMethod(PyObject* self, PyObject* args,
+                                        PyObject* kwargs) {
+  static const char* keywords[] = {"requested_schema", nullptr};
+  PyObject* requested_schema = Py_None;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:__arrow_c_array__",
+                                   const_cast<char**>(keywords),
+                                   &requested_schema)) {
+    return nullptr;
+  }
+  // requested_schema is a request, not a requirement: no casts are
+  // implemented, the array is always exported with its own type.
+  try {
+    const ArrowExportStatePtr& state = ArrowExportStateOf(self);
+    PyObject* schema = NewArrowSchemaCapsule(state);
+    if (schema == nullptr) return nullptr;
+    PyObject* array = NewArrowArrayCapsule(state);
+    if (array == nullptr) {
+      Py_DECREF(schema);
+      return nullptr;
+    }
+    return Py_BuildValue("(NN)", schema, array);
+  } catch (const std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
+}
+
+inline Py_ssize_t ArrowExportLength(PyObject* self) {
+  return static_cast<Py_ssize_t>(ArrowExportStateOf(self)->length);
+}
+
+inline void ArrowExportDealloc(PyObject* self) {
+  delete reinterpret_cast<ArrowExportObject*>(self)->state;
+  PyTypeObject* type = Py_TYPE(self);
+  type->tp_free(self);
+  Py_DECREF(type);
+}
+
+// The type of the objects returned by ToArrowArray(), shared by all the
+// extension modules. Intentionally leaked.
+inline PyTypeObject* ArrowExportType() {
+  auto& type = detail::get_or_create_shared_data<PyTypeObject*>(
+      "_pybind11_abseil_arrow_export_type_v1");
+  if (type != nullptr) return type;
+  static PyMethodDef methods[] = {
+      {"__arrow_c_schema__", ArrowExportSchemaMethod, METH_NOARGS,
+       "__arrow_c_schema__($self, /)\n--\n\n"},
+      {"__arrow_c_array__",
+       reinterpret_cast<PyCFunction>(
+           reinterpret_cast<void (*)()>(ArrowExportArrayMethod)),
+       METH_VARARGS | METH_KEYWORDS,
+       "__arrow_c_array__($self, /, requested_schema=None)\n--\n\n"},
+      {nullptr, nullptr, 0, nullptr}};
+  static PyType_Slot slots[] = {
+      {Py_tp_dealloc, reinterpret_cast<void*>(ArrowExportDealloc)},
+      {Py_tp_methods, methods},
+      {Py_sq_length, reinterpret_cast<void*>(ArrowExportLength)},
+      {Py_tp_doc,
+       const_cast<char*>("An array exported with the Arrow PyCapsule "
+                         "interface.")},
+      {0, nullptr}};
+  static PyType_Spec spec = {"pybind11_abseil.ArrowArrayExport",
+                             static_cast<int>(sizeof(ArrowExportObject)), 0,
+                             Py_TPFLAGS_DEFAULT, slots};
+  PyObject* created = PyType_FromSpec(&spec);
+  if (created == nullptr) throw error_already_set();
+  type = reinterpret_cast<PyTypeObject*>(created);
+  return type;
+}
+
+inline object NewArrowExport(ArrowExportStatePtr state) {
+  PyTypeObject* type = ArrowExportType();
+  auto self = reinterpret_steal<object>(type->tp_alloc(type, 0));
+  if (!self) throw error_already_set();
+  reinterpret_cast<ArrowExportObject*>(self.ptr())->state =
+      new ArrowExportStatePtr(std::move(state));
+  return self;
+}
+
+inline std::shared_ptr<std::vector<uint8_t>> NewBitmap(std::size_t size) {
+  return std::make_shared<std::vector<uint8_t>>((size + 7) / 8, 0);
+}
+
+inline void SetBit(std::vector<uint8_t>& bitmap, std::size_t i) {
+  bitmap[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+}
+
+inline bool GetBit(const void* bitmap, std::size_t i) {
+  return (static_cast<const uint8_t*>(bitmap)[i / 8] >> (i % 8)) & 1;
+}
+
+template <typename Container>
+using ArrowValueType =
+    std::remove_cv_t<typename std::decay_t<Container>::value_type>;
+
+// The FillArrowExport() overloads set the format, length and buffers of state
+// from values, by element type.
+
+// Arithmetic types: values are moved into state.
+template <typename Container, typename T = ArrowValueType<Container>,
+          std::enable_if_t<IsArrowPrimitive<T>(), int> = 0>
+void FillArrowExport(Container&& values, ArrowStringType,
+                     ArrowExportState* state) {
+  static_assert(!detail::is_absl_span<std::decay_t<Container>>::value,
+                "Use ToArrowArray(span, owner) to export a span.");
+  static_assert(ArrowArithmeticFormat<T>() != nullptr,
+                "No Arrow type for this arithmetic type.");
+  auto owned = std::make_shared<std::decay_t<Container>>(
+      std::forward<Container>(values));
+  state->format = ArrowArithmeticFormat<T>();
+  state->length = static_cast<int64_t>(owned->size());
+  state->buffers = {nullptr, owned->data()};
+  state->owners.push_back(std::move(owned));
+}
+
+// bool: Arrow booleans are bits.
+template <typename Container, typename T = ArrowValueType<Container>,
+          std::enable_if_t<std::is_same<T, bool>::value, int> = 0>
+void FillArrowExport(Container&& values, ArrowStringType,
+                     ArrowExportState* state) {
+  auto bits = NewBitmap(values.size());
+  std::size_t i = 0;
+  for (bool value : values) {
+    if (value) SetBit(*bits, i);
+    ++i;
+  }
+  state->format = "b";
+  state->length = static_cast<int64_t>(i);
+  state->buffers = {nullptr, bits->data()};
+  state->owners.push_back(std::move(bits));
+}
+
+template <typename Offset, typename Container>
+void FillArrowStrings(const Container& values, std::size_t num_bytes,
+                      ArrowExportState* state) {
+  auto offsets = std::make_shared<std::vector<Offset>>();
+  offsets->reserve(values.size() + 1);
+  auto data = std::make_shared<std::string>();
+  data->reserve(num_bytes);
+  offsets->push_back(0);
+  for (const auto& value : values) {
+    data->append(value.data(), value.size());
+    offsets->push_back(static_cast<Offset>(data->size()));
+  }
+  state->length = static_cast<int64_t>(values.size());
+  state->buffers = {nullptr, offsets->data(), data->data()};
+  state->owners.push_back(std::move(offsets));
+  state->owners.push_back(std::move(data));
+}
+
+// Strings: copied into an offsets and a data buffer.
+template <typename Container, typename T = ArrowValueType<Container>,
+          std::enable_if_t<std::is_same<T, std::string>::value ||
+                               std::is_same<T, absl::string_view>::value,
+                           int> = 0>
+void FillArrowExport(Container&& values, ArrowStringType string_type,
+                     ArrowExportState* state) {
+  std::size_t num_bytes = 0;
+  for (const auto& value : values) num_bytes += value.size();
+  bool utf8 = string_type == ArrowStringType::kUtf8;
+  if (num_bytes <= static_cast<std::size_t>(INT32_MAX)) {
+    state->format = utf8 ? "u" : "z";
+    FillArrowStrings<int32_t>(values, num_bytes, state);
+  } else {
+    state->format = utf8 ? "U" : "Z";
+    FillArrowStrings<int64_t>(values, num_bytes, state);
+  }
+}
+
+inline int64_t ArrowNanos(absl::Time time) { return absl::ToUnixNanos(time); }
+inline int64_t ArrowNanos(absl::Duration duration) {
+  return absl::ToInt64Nanoseconds(duration);
+}
+
+// absl::Time and absl::Duration: converted to int64 nanoseconds.
+template <typename Container, typename T = ArrowValueType<Container>,
+          std::enable_if_t<std::is_same<T, absl::Time>::value ||
+                               std::is_same<T, absl::Duration>::value,
+                           int> = 0>
+void FillArrowExport(Container&& values, ArrowStringType string_type,
+                     ArrowExportState* state) {
+  std::vector<int64_t> nanos;
+  nanos.reserve(values.size());
+  for (const T& value : values) nanos.push_back(ArrowNanos(value));
+  FillArrowExport(std::move(nanos), string_type, state);
+  state->format = std::is_same<T, absl::Time>::value ? "tsn:UTC" : "tDn";
+}
+
+// absl::StatusOr: the values and a validity bitmap.
+template <typename Container, typename T = ArrowValueType<Container>,
+          std::enable_if_t<IsStatusOr<T>::value, int> = 0>
+void FillArrowExport(Container&& values, ArrowStringType string_type,
+                     ArrowExportState* state) {
+  using Value = typename T::value_type;
+  std::vector<Value> ok_values;
+  ok_values.reserve(values.size());
+  auto validity = NewBitmap(values.size());
+  int64_t null_count = 0;
+  for (auto&& value : values) {
+    if (value.ok()) {
+      SetBit(*validity, ok_values.size());
+      ok_values.push_back(std::move(*value));
+    } else {
+      ok_values.emplace_back();
+      ++null_count;
+    }
+  }
+  FillArrowExport(std::move(ok_values), string_type, state);
+  if (null_count != 0) {
+    state->buffers[0] = validity->data();
+    state->null_count = null_count;
+    state->owners.push_back(std::move(validity));
+  }
+}
+
+}  // namespace internal
+
+// Returns an object implementing the Arrow PyCapsule interface
+// (__arrow_c_schema__ and __arrow_c_array__), and len(), for the elements of
+// values. See the top of this file for the supported types.
+template <typename Container>
+object ToArrowArray(Container values,
+                    ArrowStringType string_type = ArrowStringType::kUtf8) {
+  auto state = std::make_shared<internal::ArrowExportState>();
+  internal::FillArrowExport(std::move(values), string_type, state.get());
+  return internal::NewArrowExport(std::move(state));
+}
+
+// Same as above, without copying: the memory of values is owned by owner (e.g.
+// a numpy array), which the exported array keeps alive.
+template <typename T>
+object ToArrowArray(absl::Span<const T> values, handle owner) {
+  static_assert(internal::IsArrowPrimitive<T>(),
+                "Only spans of arithmetic types (except bool) are supported.");
+  auto state = std::make_shared<internal::ArrowExportState>();
+  state->format = internal::ArrowArithmeticFormat<T>();
+  state->length = static_cast<int64_t>(values.size());
+  state->buffers = {nullptr, values.data()};
+  state->owners.push_back(internal::PyObjectOwner(owner));
+  return internal::NewArrowExport(std::move(state));
+}
+
+// An array imported with the Arrow PyCapsule interface, with elements of type
+// T: an arithmetic type, absl::string_view or std::string (utf8 or binary),
+// absl::Time (timestamp, any unit; timestamps without a time zone are read as
+// UTC) or absl::Duration (duration, any unit).
+template <typename T>
+class ArrowColumn {
+ public:
+  ArrowColumn() = default;
+
+  // Imports src.__arrow_c_array__(). Returns false if src does not implement
+  // the interface, or if its Arrow type does not match T.
+  bool Load(handle src) {
+    if (!hasattr(src, "__arrow_c_array__")) return false;
+    object capsules;
+    try {
+      capsules = src.attr("__arrow_c_array__")();
+    } catch (error_already_set&) {
+      return false;
+    }
+    if (!isinstance<tuple>(capsules) || len(capsules) != 2) return false;
+    auto* schema = static_cast<ArrowSchema*>(
+        PyCapsule_GetPointer(capsules[0].ptr(), "arrow_schema"));
+    auto* array = static_cast<ArrowArray*>(
+        PyCapsule_GetPointer(capsules[1].ptr(), "arrow_array"));
+    if (schema == nullptr || array == nullptr) {
+      PyErr_Clear();
+      return false;
+    }
+    if (schema->n_children != 0 || schema->dictionary != nullptr ||
+        array->release == nullptr || !MatchFormat(schema->format, Tag<T>()) ||
+        array->n_buffers != NumBuffers(Tag<T>())) {
+      return false;
+    }
+    format_ = schema->format;
+    // Move the array out of the capsule, which then no longer releases it.
+    array_ = std::shared_ptr<ArrowArray>(new ArrowArray(*array),
+                                         [](ArrowArray* moved) {
+                                           if (moved->release != nullptr) {
+                                             moved->release(moved);
+                                           }
+                                           delete moved;
+                                         });
+    array->release = nullptr;
+    return true;
+  }
+
+  std::size_t size() const {
+    return array_ ? static_cast<std::size_t>(array_->length) : 0;
+  }
+
+  std::size_t null_count() const {
+    if (!array_ || array_->buffers[0] == nullptr) return 0;
+    if (array_->null_count >= 0) {
+      return static_cast<std::size_t>(array_->null_count);
+    }
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size(); ++i) count += !is_valid(i);
+    return count;
+  }
+
+  bool is_valid(std::size_t i) const {
+    return array_->buffers[0] == nullptr ||
+           internal::GetBit(array_->buffers[0], Index(i));
+  }
+
+  // The value of element i, unspecified if it is null.
+  T operator[](std::size_t i) const { return Get(i, Tag<T>()); }
+
+  // The values, referencing the imported array.
+  template <typename U = T,
+            std::enable_if_t<internal::IsArrowPrimitive<U>(), int> = 0>
+  absl::Span<const T> values() const {
+    if (!array_) return {};
+    return absl::MakeConstSpan(
+        static_cast<const T*>(array_->buffers[1]) + array_->offset, size());
+  }
+
+  // A copy of the values. Throws value_error if there are nulls.
+  std::vector<T> ToVector() const {
+    if (null_count() != 0) {
+      throw value_error("ArrowColumn::ToVector: the array has nulls.");
+    }
+    std::vector<T> result;
+    result.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) result.push_back((*this)[i]);
+    return result;
+  }
+
+  // Exports the imported array again, without copying it.
+  object ToArrowArray() const {
+    auto state = std::make_shared<internal::ArrowExportState>();
+    state->format = format_;
+    if (array_) {
+      state->length = array_->length;
+      state->null_count = array_->null_count;
+      state->offset = array_->offset;
+      state->buffers.assign(array_->buffers,
+                            array_->buffers + array_->n_buffers);
+      state->owners.push_back(array_);
+    } else {
+      state->format = internal::ArrowArithmeticFormat<int8_t>();
+      state->buffers = {nullptr, nullptr};
+    }
+    return internal::NewArrowExport(std::move(state));
+  }
+
+ private:
+  template <typename U>
+  struct Tag {};
+
+  std::size_t Index(std::size_t i) const {
+    return static_cast<std::size_t>(array_->offset) + i;
+  }
+
+  static bool IsUnit(char unit) {
+    return unit == 's' || unit == 'm' || unit == 'u' || unit == 'n';
+  }
+
+  template <typename U,
+            std::enable_if_t<std::is_arithmetic<U>::value, int> = 0>
+  static bool MatchFormat(absl::string_view format, Tag<U>) {
+    return format == internal::ArrowArithmeticFormat<U>();
+  }
+  static bool MatchFormat(absl::string_view format, Tag<absl::string_view>) {
+    return format == "u" || format == "z" || format == "U" || format == "Z";
+  }
+  static bool MatchFormat(absl::string_view format, Tag<std::string>) {
+    return MatchFormat(format, Tag<absl::string_view>());
+  }
+  static bool MatchFormat(absl::string_view format, Tag<absl::Time>) {
+    return format.size() >= 4 && format.substr(0, 2) == "ts" &&
+           IsUnit(format[2]) && format[3] == ':';
+  }
+  static bool MatchFormat(absl::string_view format, Tag<absl::Duration>) {
+    return format.size() == 3 && format.substr(0, 2) == "tD" &&
+           IsUnit(format[2]);
+  }
+
+  template <typename U>
+  static int64_t NumBuffers(Tag<U>) {
+    return 2;
+  }
+  static int64_t NumBuffers(Tag<absl::string_view>) { return 3; }
+  static int64_t NumBuffers(Tag<std::string>) { return 3; }
+
+  template <typename U,
+            std::enable_if_t<internal::IsArrowPrimitive<U>(), int> = 0>
+  U Get(std::size_t i, Tag<U>) const {
+    return static_cast<const U*>(array_->buffers[1])[Index(i)];
+  }
+  bool Get(std::size_t i, Tag<bool>) const {
+    return internal::GetBit(array_->buffers[1], Index(i));
+  }
+  absl::string_view Get(std::size_t i, Tag<absl::string_view>) const {
+    int64_t begin;
+    int64_t end;
+    if (format_[0] == 'U' || format_[0] == 'Z') {
+      const auto* offsets = static_cast<const int64_t*>(array_->buffers[1]);
+      begin = offsets[Index(i)];
+      end = offsets[Index(i) + 1];
+    } else {
+      const auto* offsets = static_cast<const int32_t*>(array_->buffers[1]);
+      begin = offsets[Index(i)];
+      end = offsets[Index(i) + 1];
+    }
+    return absl::string_view(
+        static_cast<const char*>(array_->buffers[2]) + begin,
+        static_cast<std::size_t>(end - begin));
+  }
+  std::string Get(std::size_t i, Tag<std::string>) const {
+    return std::string(Get(i, Tag<absl::string_view>()));
+  }
+  absl::Duration Get(std::size_t i, Tag<absl::Duration>) const {
+    int64_t value = static_cast<const int64_t*>(array_->buffers[1])[Index(i)];
+    switch (format_[2]) {
+      case 's':
+        return absl::Seconds(value);
+      case 'm':
+        return absl::Milliseconds(value);
+      case 'u':
+        return absl::Microseconds(value);
+      default:
+        return absl::Nanoseconds(value);
+    }
+  }
+  absl::Time Get(std::size_t i, Tag<absl::Time>) const {
+    return absl::UnixEpoch() + Get(i, Tag<absl::Duration>());
+  }
+
+  std::shared_ptr<ArrowArray> array_;
+  std::string format_;
+};
+
+}  // namespace google
+
+namespace detail {
+
+template <typename T>
+struct type_caster<google::ArrowColumn<T>> {
+  PYBIND11_TYPE_CASTER(google::ArrowColumn<T>, const_name("ArrowArray"));
+
+  bool load(handle src, bool /*convert*/) { return value.Load(src); }
+
+  static handle cast(const google::ArrowColumn<T>& src,
+                     return_value_policy /*policy*/, handle /*parent*/) {
+    return src.ToArrowArray().release();
+  }
+};
+
+}  // namespace detail
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_ABSL_ARROW_H_
@@ -14,14 +14,24 @@
 // - absl::CivilTime- converted to/from python datetime.datetime and from date.
 // - absl::Time- converted to/from python datetime.datetime and from date.
 // - absl::TimeZone- converted to/from python str and from int.
-// - absl::Span- converted to python sequences and from python buffers,
-//               opaque std::vectors and/or sequences.
-// - absl::string_view
+// - absl::Span- converted to python sequences and from python buffers
+//               (including numpy structured arrays, see span_buffer_struct),
+//               DLPack tensors, opaque std::vectors and/or sequences.
+// - absl::string_view- converted from python str, bytes and bytearray.
+// - google::BytesView- converted from python str and any buffer of bytes (e.g.
+//                      memoryview, mmap).
 // - absl::optional- converts absl::nullopt to/from python None, otherwise
 //   converts the contained value.
 // - absl::flat_hash_map- converts to/from python dict.
 // - absl::flat_hash_set- converst to/from python set.
 // - absl::btree_map- converts to/from python dict.
+// - absl::btree_set- converts to/from python set.
+// - absl::btree_multiset- converts to python list, from python set/sequence.
+// - absl::btree_multimap- converts to python list of (key, value) tuples, from
+//   python dict/sequence of pairs.
+// - absl::InlinedVector and absl::FixedArray- convert to python list (or to a
+//   memoryview when returned by reference_internal), from python buffers
+//   and/or sequences.
 //
 // For details, see the README.md.
 //
@@ -39,18 +49,25 @@
 // Must NOT appear before at least one pybind11 include.
 #include <datetime.h>  // Python datetime builtin.
 
+#include <algorithm>
 #include <cmath>
 #include <complex>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
-#include "absl/cleanup/cleanup.h"
 #include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
+#include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/strings/cord.h"
@@ -59,8 +76,35 @@
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "pybind11_abseil/caster_stats.h"
+#include "pybind11_abseil/dlpack.h"
 
 namespace pybind11 {
+
+// Defined in pybind11/numpy.h (see google::span_buffer_struct).
+class dtype;
+
+namespace google {
+
+// Specialize as std::true_type to load absl::Span<T> of a standard-layout,
+// trivially copyable struct T without copying, from buffers (e.g. numpy
+// structured arrays) with items equivalent to T:
+//
+//   struct Point3f { float x, y, z; };
+//
+//   namespace pybind11::google {
+//   template <>
+//   struct span_buffer_struct<Point3f> : std::true_type {};
+//   }  // namespace pybind11::google
+//
+// The numpy dtype of T must be registered with PYBIND11_NUMPY_DTYPE (from
+// pybind11/numpy.h, which must be included).
+template <typename T>
+struct span_buffer_struct : std::false_type {};
+
+}  // namespace google
+
 namespace detail {
 
 // Helper function to get an int64_t attribute.
@@ -398,39 +442,317 @@ static constexpr bool is_buffer_interface_compatible_type =
     detail::is_same_ignoring_cvref<T, PyObject*>::value ||
     std::is_arithmetic<std::remove_cv_t<T>>::value ||
     std::is_same<T, std::complex<float>>::value ||
-    std::is_same<T, std::complex<double>>::value;
+    std::is_same<T, std::complex<double>>::value ||
+    google::span_buffer_struct<std::remove_cv_t<T>>::value;
+
+// Spans of bytes are loaded from any C-contiguous buffer with items of size 1,
+// whatever their format.
+template <typename T>
+static constexpr bool is_byte_type =
+    std::is_same<std::remove_cv_t<T>, char>::value ||
+    std::is_same<std::remove_cv_t<T>, signed char>::value ||
+    std::is_same<std::remove_cv_t<T>, unsigned char>::value ||
+    std::is_same<std::remove_cv_t<T>, std::byte>::value;
+
+}  // namespace internal
+
+namespace internal {
+
+// Owns a Py_buffer obtained with PyObject_GetBuffer.
+class PyBufferView {
+ public:
+  PyBufferView() = default;
+  PyBufferView(const PyBufferView&) = delete;
+  PyBufferView& operator=(const PyBufferView&) = delete;
+  ~PyBufferView() { Release(); }
+
+  // Returns false (with the python error cleared) if src does not export a
+  // buffer compatible with flags.
+  bool Get(handle src, int flags) {
+    Release();
+    if (PyObject_GetBuffer(src.ptr(), &view_, flags) != 0) {
+      PyErr_Clear();
+      return false;
+    }
+    acquired_ = true;
+    return true;
+  }
+
+  void Release() {
+    if (acquired_) {
+      PyBuffer_Release(&view_);
+      acquired_ = false;
+    }
+  }
+
+  Py_buffer* view() { return &view_; }
+
+ private:
+  Py_buffer view_;
+  bool acquired_ = false;
+};
+
+// A vector leased from a per-thread pool, so that casters converting into a
+// vector on every call do not allocate once the pool holds vectors of enough
+// capacity. Cleared and returned to the pool on destruction. Nested calls on a
+// thread lease different vectors.
+template <typename V>
+class ScratchVector {
+ public:
+  ScratchVector() : vector_(Acquire()) {}
+  ScratchVector(const ScratchVector& other) : vector_(Acquire()) {
+    *vector_ = *other.vector_;
+  }
+  ScratchVector(ScratchVector&& other) noexcept
+      : vector_(std::move(other.vector_)) {}
+  ScratchVector& operator=(const ScratchVector& other) {
+    if (this == &other) return *this;
+    if (vector_ == nullptr) vector_ = Acquire();
+    *vector_ = *other.vector_;
+    return *this;
+  }
+  ScratchVector& operator=(ScratchVector&& other) noexcept {
+    Release();
+    vector_ = std::move(other.vector_);
+    return *this;
+  }
+  ~ScratchVector() { Release(); }
+
+  std::vector<V>& operator*() { return *vector_; }
+
+ private:
+  // Larger vectors are freed rather than kept for the lifetime of the thread.
+  static constexpr std::size_t kMaxPooledCapacity = std::size_t{1} << 20;
+  static constexpr std::size_t kMaxPooled = 4;
+
+  using Pool = std::vector<std::unique_ptr<std::vector<V>>>;
+
+  static Pool& ThisThreadPool() {
+    static thread_local Pool pool;
+    return pool;
+  }
+
+  static std::unique_ptr<std::vector<V>> Acquire() {
+    Pool& pool = ThisThreadPool();
+    if (pool.empty()) return std::make_unique<std::vector<V>>();
+    std::unique_ptr<std::vector<V>> vector = std::move(pool.back());
+    pool.pop_back();
+    return vector;
+  }
+
+  void Release() {
+    if (vector_ == nullptr) return;
+    Pool& pool = ThisThreadPool();
+    if (pool.size() < kMaxPooled && vector_->capacity() <= kMaxPooledCapacity) {
+      vector_->clear();
+      pool.push_back(std::move(vector_));
+    }
+    vector_.reset();
+  }
+
+  std::unique_ptr<std::vector<V>> vector_;
+};
+
+// Returns true if src exports a C-contiguous buffer with items of size 1,
+// writable if requested, which is then held by buffer.
+inline bool GetBytesBuffer(handle src, bool writable, PyBufferView* buffer) {
+  int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+  if (writable) flags |= PyBUF_WRITABLE;
+  return buffer->Get(src, flags) && buffer->view()->itemsize == 1;
+}
+
+// Returns true if the items of view are of type T, an arithmetic, complex or
+// PyObject* type.
+template <typename T, typename std::enable_if<
+                          !google::span_buffer_struct<T>::value, int>::type = 0>
+bool BufferItemsAre(Py_buffer* view) {
+  return buffer_info(view, /*ownview=*/false).item_type_is_equivalent_to<T>();
+}
+
+// Returns true if the items of view are of type T, a struct opted in with
+// google::span_buffer_struct: if the dtype described by the format of view is
+// equivalent to the registered dtype of T.
+template <typename T, typename Dtype = dtype,
+          typename std::enable_if<google::span_buffer_struct<T>::value,
+                                  int>::type = 0>
+bool BufferItemsAre(Py_buffer* view) {
+  static_assert(std::is_standard_layout<T>::value &&
+                    std::is_trivially_copyable<T>::value,
+                "span_buffer_struct types must be standard-layout and "
+                "trivially copyable.");
+  if (view->itemsize != static_cast<ssize_t>(sizeof(T))) return false;
+  // The formats found equivalent to T: comparing a format with the dtype of T
+  // calls into numpy. Guarded by the GIL. Intentionally leaked.
+  static auto* equivalent_formats = new std::vector<std::string>();
+  const char* format = view->format != nullptr ? view->format : "B";
+  if (std::find(equivalent_formats->begin(), equivalent_formats->end(),
+                format) != equivalent_formats->end()) {
+    return true;
+  }
+  try {
+    if (!Dtype(buffer_info(view, /*ownview=*/false))
+             .equal(Dtype::template of<T>())) {
+      return false;
+    }
+  } catch (error_already_set&) {
+    return false;  // The format is not a numpy dtype.
+  }
+  equivalent_formats->emplace_back(format);
+  return true;
+}
+
+// Returns {true, a span over the items of view} if view (obtained with at least
+// PyBUF_STRIDES | PyBUF_FORMAT) is a 1-D contiguous buffer of T. Otherwise
+// returns {false, an empty span}.
+template <typename T>
+std::tuple<bool, absl::Span<T>> SpanOfBufferView(Py_buffer* view) {
+  if (view->ndim == 1 && view->strides[0] == sizeof(T) &&
+      BufferItemsAre<std::remove_cv_t<T>>(view)) {
+    return {true, absl::MakeSpan(static_cast<T*>(view->buf), view->shape[0])};
+  }
+  return {false, absl::Span<T>()};
+}
 
 }  // namespace internal
 
 // Returns {true, a span referencing the data contained by src} without copying
 // or converting the data if possible. Otherwise returns {false, an empty span}.
 template <typename T, typename std::enable_if<
-                          internal::is_buffer_interface_compatible_type<T>,
+                          internal::is_buffer_interface_compatible_type<T> &&
+                              !internal::is_byte_type<T>,
                           bool>::type = true>
 std::tuple<bool, absl::Span<T>> LoadSpanFromBuffer(handle src) {
-  Py_buffer view;
+  internal::PyBufferView buffer;
   int flags = PyBUF_STRIDES | PyBUF_FORMAT;
   if (!std::is_const<T>::value) flags |= PyBUF_WRITABLE;
-  if (PyObject_GetBuffer(src.ptr(), &view, flags) == 0) {
-    auto cleanup = absl::MakeCleanup([&view] { PyBuffer_Release(&view); });
-    if (view.ndim == 1 && view.strides[0] == sizeof(T) &&
-        buffer_info(&view, /*ownview=*/false)
-            .item_type_is_equivalent_to<std::remove_cv_t<T>>()) {
-      return {true, absl::MakeSpan(static_cast<T*>(view.buf), view.shape[0])};
-    }
-  } else {
-    // Clear the buffer error (failure is reported in the return value).
-    PyErr_Clear();
+  if (buffer.Get(src, flags)) {
+    return internal::SpanOfBufferView<T>(buffer.view());
+  }
+  return {false, absl::Span<T>()};
+}
+template <typename T, typename std::enable_if<internal::is_byte_type<T>,
+                                              bool>::type = true>
+std::tuple<bool, absl::Span<T>> LoadSpanFromBuffer(handle src) {
+  internal::PyBufferView buffer;
+  if (internal::GetBytesBuffer(src, !std::is_const<T>::value, &buffer)) {
+    return {true, absl::MakeSpan(static_cast<T*>(buffer.view()->buf),
+                                 static_cast<size_t>(buffer.view()->len))};
   }
   return {false, absl::Span<T>()};
 }
 template <typename T, typename std::enable_if<
-                          !internal::is_buffer_interface_compatible_type<T>,
+                          !internal::is_buffer_interface_compatible_type<T> &&
+                              !internal::is_byte_type<T>,
                           bool>::type = true>
 constexpr std::tuple<bool, absl::Span<T>> LoadSpanFromBuffer(handle /*src*/) {
   return {false, absl::Span<T>()};
 }
 
+// Returns {true, a span over the items of src} if src is an exact list or
+// tuple, without copying the item pointers. The caller must keep a reference to
+// src, which must not be modified while the span is used. Otherwise returns
+// {false, an empty span}.
+template <typename T,
+          typename std::enable_if<std::is_same<T, PyObject* const>::value,
+                                  bool>::type = true>
+std::tuple<bool, absl::Span<T>> LoadSpanFromSequenceItems(handle src) {
+  PyObject* o = src.ptr();
+  if (PyList_CheckExact(o) || PyTuple_CheckExact(o)) {
+    return {true, absl::MakeConstSpan(
+                      PySequence_Fast_ITEMS(o),
+                      static_cast<size_t>(PySequence_Fast_GET_SIZE(o)))};
+  }
+  return {false, absl::Span<T>()};
+}
+template <typename T,
+          typename std::enable_if<!std::is_same<T, PyObject* const>::value,
+                                  bool>::type = true>
+constexpr std::tuple<bool, absl::Span<T>> LoadSpanFromSequenceItems(
+    handle /*src*/) {
+  return {false, absl::Span<T>()};
+}
+
+// Returns {true, a span over views of the items of src} if src is an exact list
+// or tuple of exact bytes and str objects. The views are stored in a vector
+// leased into *scratch, and reference the data of the items: the characters of
+// ASCII str objects, or the UTF-8 representation cached by other str objects
+// (created if needed). The caller must keep a reference to src, which must not
+// be modified while the span is used. Otherwise returns {false, an empty span}.
+template <typename T,
+          typename std::enable_if<
+              std::is_same<T, const absl::string_view>::value, bool>::type =
+              true>
+std::tuple<bool, absl::Span<T>> LoadSpanOfStringViews(
+    handle src,
+    absl::optional<internal::ScratchVector<absl::string_view>>* scratch) {
+  PyObject* o = src.ptr();
+  if (!PyList_CheckExact(o) && !PyTuple_CheckExact(o)) {
+    return {false, absl::Span<T>()};
+  }
+  Py_ssize_t size = PySequence_Fast_GET_SIZE(o);
+  PyObject** items = PySequence_Fast_ITEMS(o);
+  scratch->emplace();
+  std::vector<absl::string_view>& views = **scratch;
+  views.reserve(static_cast<size_t>(size));
+  for (Py_ssize_t i = 0; i < size; ++i) {
+    PyObject* item = items[i];
+    if (PyBytes_CheckExact(item)) {
+      views.emplace_back(PyBytes_AS_STRING(item),
+                         static_cast<size_t>(PyBytes_GET_SIZE(item)));
+    } else if (PyUnicode_CheckExact(item) && PyUnicode_IS_COMPACT_ASCII(item)) {
+      views.emplace_back(static_cast<const char*>(PyUnicode_DATA(item)),
+                         static_cast<size_t>(PyUnicode_GET_LENGTH(item)));
+    } else if (PyUnicode_CheckExact(item)) {
+      Py_ssize_t item_size = 0;
+      const char* data = PyUnicode_AsUTF8AndSize(item, &item_size);
+      if (data == nullptr) {
+        PyErr_Clear();
+        scratch->reset();
+        return {false, absl::Span<T>()};
+      }
+      views.emplace_back(data, static_cast<size_t>(item_size));
+    } else {
+      scratch->reset();
+      return {false, absl::Span<T>()};
+    }
+  }
+  return {true, absl::MakeConstSpan(views)};
+}
+template <typename T,
+          typename std::enable_if<
+              !std::is_same<T, const absl::string_view>::value, bool>::type =
+              true>
+constexpr std::tuple<bool, absl::Span<T>> LoadSpanOfStringViews(
+    handle /*src*/,
+    absl::optional<internal::ScratchVector<absl::string_view>>* /*scratch*/) {
+  return {false, absl::Span<T>()};
+}
+
+// Returns {true, a span referencing the data of the DLPack tensor exported by
+// src} if possible, with *owner set to the capsule owning the tensor. Otherwise
+// returns {false, an empty span}.
+template <typename T,
+          typename std::enable_if<
+              google::internal::IsDLPackCompatible<std::remove_cv_t<T>>(),
+              bool>::type = true>
+std::tuple<bool, absl::Span<T>> LoadSpanFromDLPack(handle src, object* owner) {
+  google::internal::DLPackImport imported;
+  if (!google::internal::ImportDLPack(src, &imported)) {
+    return {false, absl::Span<T>()};
+  }
+  auto result = google::internal::SpanOfDLPack<T>(imported);
+  if (std::get<0>(result)) *owner = std::move(imported.capsule);
+  return result;
+}
+template <typename T,
+          typename std::enable_if<
+              !google::internal::IsDLPackCompatible<std::remove_cv_t<T>>(),
+              bool>::type = true>
+constexpr std::tuple<bool, absl::Span<T>> LoadSpanFromDLPack(
+    handle /*src*/, object* /*owner*/) {
+  return {false, absl::Span<T>()};
+}
+
 template <typename T,
           typename std::enable_if<
               !std::is_same<std::remove_cv_t<T>, bool>::value, int>::type = 0>
@@ -484,13 +806,21 @@ struct type_caster<absl::Span<T>> {
   template <typename U>
   type_caster& operator=(const type_caster<absl::Span<U>>& other) {
     list_caster_ = other.list_caster_;
-    value_ = list_caster_ ? get_value(*list_caster_) : other.value_;
+    string_views_ = other.string_views_;
+    owner_ = other.owner_;
+    value_ = list_caster_     ? get_value(*list_caster_)
+             : string_views_ ? get_string_views_value(**string_views_)
+                             : other.value_;
     return *this;
   }
   template <typename U>
   type_caster& operator=(type_caster<absl::Span<U>>&& other) {
     list_caster_ = std::move(other.list_caster_);
-    value_ = list_caster_ ? get_value(*list_caster_) : other.value_;
+    string_views_ = std::move(other.string_views_);
+    owner_ = std::move(other.owner_);
+    value_ = list_caster_     ? get_value(*list_caster_)
+             : string_views_ ? get_string_views_value(**string_views_)
+                             : other.value_;
     return *this;
   }
 
@@ -507,13 +837,33 @@ struct type_caster<absl::Span<T>> {
   using cast_op_type = cast_op_type<T_>;
 
   bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kSpan, kCalls, 1);
     // Attempt to reference a buffer, including np.ndarray and array.arrays.
     bool loaded;
     std::tie(loaded, value_) = LoadSpanFromBuffer<T>(src);
-    if (loaded) return true;
+    // Then a DLPack tensor, e.g. torch and JAX CPU arrays.
+    if (!loaded) {
+      std::tie(loaded, value_) = LoadSpanFromDLPack<T>(src, &owner_);
+    }
+    if (!loaded) std::tie(loaded, value_) = LoadSpanOpaqueVector<T>(src);
+    if (loaded) {
+      PYBIND11_ABSEIL_CASTER_STAT(kSpan, kFastPath, 1);
+      PYBIND11_ABSEIL_CASTER_STAT(kSpan, kElements, value_.size());
+      return true;
+    }
 
-    std::tie(loaded, value_) = LoadSpanOpaqueVector<T>(src);
-    if (loaded) return true;
+    // Reference the items of a list or tuple (PyObject* const). Nothing is
+    // copied, but a list is not a sequence of PyObject* in python: as for the
+    // other native sequences, this is a conversion.
+    if (convert) {
+      std::tie(loaded, value_) = LoadSpanFromSequenceItems<T>(src);
+      if (loaded) {
+        owner_ = reinterpret_borrow<object>(src);
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kFastPath, 1);
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kElements, value_.size());
+        return true;
+      }
+    }
 
     // Attempt to convert a native sequence. If the is_base_of check passes,
     // the elements do not require converting and pointers do not reference a
@@ -525,9 +875,22 @@ struct type_caster<absl::Span<T>> {
         !std::is_same<T, const bool>::value &&
         (!std::is_pointer<T>::value ||
          std::is_base_of<type_caster_generic, make_caster<T>>::value)) {
+      // Views of bytes and str items reference the data of the items: only the
+      // views are stored, in a vector reused across calls.
+      std::tie(loaded, value_) = LoadSpanOfStringViews<T>(src, &string_views_);
+      if (loaded) {
+        owner_ = reinterpret_borrow<object>(src);
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kFallback, 1);
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kElements, value_.size());
+        return true;
+      }
       list_caster_.emplace();
       if (list_caster_->load(src, convert)) {
         value_ = get_value(*list_caster_);
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kFallback, 1);
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kElements, value_.size());
+        PYBIND11_ABSEIL_CASTER_STAT(kSpan, kBytesCopied,
+                                    value_.size() * sizeof(value_type));
         return true;
       } else {
         list_caster_.reset();
@@ -539,6 +902,8 @@ struct type_caster<absl::Span<T>> {
 
   template <typename CType>
   static handle cast(CType&& src, return_value_policy policy, handle parent) {
+    PYBIND11_ABSEIL_CASTER_STAT(kSpan, kCalls, 1);
+    PYBIND11_ABSEIL_CASTER_STAT(kSpan, kElements, src.size());
     return ListCaster::cast(src, policy, parent);
   }
 
@@ -564,39 +929,719 @@ struct type_caster<absl::Span<T>> {
     throw std::runtime_error("Expected to be unreachable.");
   }
 
+  template <typename VT = value_type,
+            typename std::enable_if<std::is_same<VT, absl::string_view>::value,
+                                    int>::type = 0>
+  absl::Span<T> get_string_views_value(std::vector<absl::string_view>& views) {
+    return absl::MakeSpan(views);
+  }
+
+  // Only string_view spans load string_views_: unreachable otherwise.
+  template <typename VT = value_type,
+            typename std::enable_if<
+                !std::is_same<VT, absl::string_view>::value, int>::type = 0>
+  absl::Span<T> get_string_views_value(std::vector<absl::string_view>&) {
+    throw std::runtime_error("Expected to be unreachable.");
+  }
+
   using ListCaster = list_caster<ephemeral_storage_type, value_type>;
   absl::optional<ListCaster> list_caster_;
+  // The views referenced by value_, for LoadSpanOfStringViews().
+  absl::optional<internal::ScratchVector<absl::string_view>> string_views_;
+  // Owns the list or tuple, or the DLPack tensor, referenced by value_, if any.
+  object owner_;
   absl::Span<T> value_;
 };
 
+namespace internal {
+
+// Loads a T from a python object. For exact builtin types this skips the
+// generic make_caster<T> dispatch; everything else is delegated to
+// make_caster<T>, which also decides how non-exact types are handled.
+template <typename T, typename SFINAE = void>
+class FastLoader {
+ public:
+  bool Load(handle src, bool convert) { return conv_.load(src, convert); }
+  decltype(auto) Get() { return cast_op<T&&>(std::move(conv_)); }
+
+ private:
+  make_caster<T> conv_;
+};
+
+template <>
+class FastLoader<int64_t> {
+ public:
+  bool Load(handle src, bool convert) {
+    if (PyLong_CheckExact(src.ptr())) {
+      int overflow = 0;
+      long long v = PyLong_AsLongLongAndOverflow(src.ptr(), &overflow);
+      if (overflow != 0 || (v == -1 && PyErr_Occurred())) {
+        PyErr_Clear();
+        return false;
+      }
+      value_ = static_cast<int64_t>(v);
+      return true;
+    }
+    make_caster<int64_t> conv;
+    if (!conv.load(src, convert)) {
+      return false;
+    }
+    value_ = cast_op<int64_t>(conv);
+    return true;
+  }
+  int64_t Get() const { return value_; }
+
+ private:
+  int64_t value_ = 0;
+};
+
+template <>
+class FastLoader<double> {
+ public:
+  bool Load(handle src, bool convert) {
+    if (PyFloat_CheckExact(src.ptr())) {
+      value_ = PyFloat_AS_DOUBLE(src.ptr());
+      return true;
+    }
+    make_caster<double> conv;
+    if (!conv.load(src, convert)) {
+      return false;
+    }
+    value_ = cast_op<double>(conv);
+    return true;
+  }
+  double Get() const { return value_; }
+
+ private:
+  double value_ = 0;
+};
+
+// std::string and absl::string_view. Like the pybind11 string caster, a
+// string_view points into the UTF-8 buffer cached by the str object, or into
+// the bytes object.
+template <typename T>
+class FastLoader<T, typename std::enable_if<
+                        std::is_same<T, std::string>::value ||
+                        std::is_same<T, absl::string_view>::value>::type> {
+ public:
+  bool Load(handle src, bool convert) {
+    PyObject* o = src.ptr();
+    if (PyUnicode_CheckExact(o)) {
+      Py_ssize_t size = 0;
+      const char* data = PyUnicode_AsUTF8AndSize(o, &size);
+      if (data == nullptr) {
+        PyErr_Clear();
+        return false;
+      }
+      value_ = T(data, static_cast<size_t>(size));
+      return true;
+    }
+    if (PyBytes_CheckExact(o)) {
+      value_ =
+          T(PyBytes_AS_STRING(o), static_cast<size_t>(PyBytes_GET_SIZE(o)));
+      return true;
+    }
+    make_caster<T> conv;
+    if (!conv.load(src, convert)) {
+      return false;
+    }
+    value_ = cast_op<T&&>(std::move(conv));
+    return true;
+  }
+  T&& Get() { return std::move(value_); }
+
+ private:
+  T value_;
+};
+
+// Maps with at least this many entries are loaded from columns with the GIL
+// released.
+constexpr std::size_t kColumnarLoadReleaseGilMinSize = 1 << 14;
+
+template <typename Container>
+auto ReserveIfSupported(Container& c, std::size_t n, int)
+    -> decltype(c.reserve(n)) {
+  return c.reserve(n);
+}
+template <typename Container>
+void ReserveIfSupported(Container& /*c*/, std::size_t /*n*/, long) {}
+
+// Duplicate keys are resolved like dict(zip(keys, values)): the last one wins.
+template <typename Map, typename Key, typename Value>
+void InsertOrAssignColumnEntry(Map& map, const Key& key, const Value& value) {
+  map.insert_or_assign(key, value);
+}
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void InsertOrAssignColumnEntry(absl::btree_map<Key, Value, Compare, Alloc>& map,
+                               const Key& key, const Value& value) {
+  // Sorted keys are appended in O(1) (see the btree casters below).
+  map.insert_or_assign(map.end(), key, value);
+}
+
+template <typename T>
+static constexpr bool is_column_type =
+    std::is_arithmetic<T>::value && !std::is_const<T>::value;
+
+// Loads map from a (keys, values) tuple of 1-D buffers of the same length, e.g.
+// two numpy arrays. Returns false if src is not such a tuple, or if the buffer
+// item types are not exactly Key and Value.
+template <typename Map, typename Key, typename Value,
+          typename std::enable_if<is_column_type<Key> && is_column_type<Value>,
+                                  int>::type = 0>
+bool LoadMapFromColumns(handle src, Map& map) {
+  if (!isinstance<tuple>(src) || PyTuple_GET_SIZE(src.ptr()) != 2) {
+    return false;
+  }
+  constexpr int kFlags = PyBUF_STRIDES | PyBUF_FORMAT;
+  PyBufferView keys_buffer;
+  PyBufferView values_buffer;
+  if (!keys_buffer.Get(PyTuple_GET_ITEM(src.ptr(), 0), kFlags) ||
+      !values_buffer.Get(PyTuple_GET_ITEM(src.ptr(), 1), kFlags)) {
+    return false;
+  }
+  bool keys_ok = false;
+  bool values_ok = false;
+  absl::Span<const Key> keys;
+  absl::Span<const Value> values;
+  std::tie(keys_ok, keys) = SpanOfBufferView<const Key>(keys_buffer.view());
+  std::tie(values_ok, values) =
+      SpanOfBufferView<const Value>(values_buffer.view());
+  if (!keys_ok || !values_ok || keys.size() != values.size()) {
+    return false;
+  }
+  map.clear();
+  // The buffers stay exported (so they cannot be resized) until the end of
+  // this function.
+  absl::optional<gil_scoped_release> release_gil;
+  if (keys.size() >= kColumnarLoadReleaseGilMinSize) {
+    release_gil.emplace();
+  }
+  ReserveIfSupported(map, keys.size(), 0);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    InsertOrAssignColumnEntry(map, keys[i], values[i]);
+  }
+  return true;
+}
+template <typename Map, typename Key, typename Value,
+          typename std::enable_if<
+              !(is_column_type<Key> && is_column_type<Value>), int>::type = 0>
+bool LoadMapFromColumns(handle /*src*/, Map& /*map*/) {
+  return false;
+}
+
+}  // namespace internal
+
+// Like map_caster, but reserves the full size up front, iterates the dict with
+// PyDict_Next and uses internal::FastLoader for the keys and values. In convert
+// mode, also loads from a (keys, values) tuple of buffers (see
+// internal::LoadMapFromColumns).
+template <typename Type, typename Key, typename Value>
+struct absl_hash_map_caster : map_caster<Type, Key, Value> {
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kHashMap, kCalls, 1);
+    if (!isinstance<dict>(src)) {
+      if (!convert || !internal::LoadMapFromColumns<Type, Key, Value>(
+                          src, this->value)) {
+        return false;
+      }
+      PYBIND11_ABSEIL_CASTER_STAT(kHashMap, kFastPath, 1);
+      PYBIND11_ABSEIL_CASTER_STAT(kHashMap, kElements, this->value.size());
+      return true;
+    }
+    internal::FastLoader<Key> kconv;
+    internal::FastLoader<Value> vconv;
+    this->value.clear();
+    this->value.reserve(static_cast<size_t>(PyDict_Size(src.ptr())));
+    Py_ssize_t pos = 0;
+    PyObject* key = nullptr;
+    PyObject* val = nullptr;
+    while (PyDict_Next(src.ptr(), &pos, &key, &val)) {
+      if (!kconv.Load(key, convert) || !vconv.Load(val, convert)) {
+        return false;
+      }
+      this->value.emplace(kconv.Get(), vconv.Get());
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kHashMap, kElements, this->value.size());
+    return true;
+  }
+};
+
+// Like set_caster, but reserves the full size up front and uses
+// internal::FastLoader for the keys.
+template <typename Type, typename Key>
+struct absl_hash_set_caster : set_caster<Type, Key> {
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kHashSet, kCalls, 1);
+    if (!isinstance<anyset>(src)) {
+      return false;
+    }
+    auto s = reinterpret_borrow<anyset>(src);
+    internal::FastLoader<Key> conv;
+    this->value.clear();
+    this->value.reserve(s.size());
+    for (auto entry : s) {
+      if (!conv.Load(entry, convert)) {
+        return false;
+      }
+      this->value.emplace(conv.Get());
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kHashSet, kElements, this->value.size());
+    return true;
+  }
+};
+
 // Convert between absl::flat_hash_map and python dict.
 template <typename Key, typename Value, typename Hash, typename Equal,
           typename Alloc>
 struct type_caster<absl::flat_hash_map<Key, Value, Hash, Equal, Alloc>>
-    : map_caster<absl::flat_hash_map<Key, Value, Hash, Equal, Alloc>, Key,
-                 Value> {};
+    : absl_hash_map_caster<absl::flat_hash_map<Key, Value, Hash, Equal, Alloc>,
+                           Key, Value> {};
 
-// Convert between absl::flat_hash_map and python dict.
+// Convert between absl::node_hash_map and python dict.
 template <typename Key, typename Value, typename Hash, typename Equal,
           typename Alloc>
 struct type_caster<absl::node_hash_map<Key, Value, Hash, Equal, Alloc>>
-    : map_caster<absl::node_hash_map<Key, Value, Hash, Equal, Alloc>, Key,
-                 Value> {};
+    : absl_hash_map_caster<absl::node_hash_map<Key, Value, Hash, Equal, Alloc>,
+                           Key, Value> {};
 
 // Convert between absl::flat_hash_set and python set.
 template <typename Key, typename Hash, typename Equal, typename Alloc>
 struct type_caster<absl::flat_hash_set<Key, Hash, Equal, Alloc>>
-    : set_caster<absl::flat_hash_set<Key, Hash, Equal, Alloc>, Key> {};
+    : absl_hash_set_caster<absl::flat_hash_set<Key, Hash, Equal, Alloc>, Key> {
+};
+
+// Convert between absl::node_hash_set and python set.
+template <typename Key, typename Hash, typename Equal, typename Alloc>
+struct type_caster<absl::node_hash_set<Key, Hash, Equal, Alloc>>
+    : absl_hash_set_caster<absl::node_hash_set<Key, Hash, Equal, Alloc>, Key> {
+};
+
+// The absl btree casters below load with emplace_hint(value.end(), ...).
+// absl btrees check the hint in O(1) and fall back to a regular insertion if it
+// is wrong, so already-sorted input (e.g. a dict built in key order) is bulk
+// loaded in O(n) rather than O(n log n), and unsorted input costs the same as
+// before.
+
+// Like map_caster, but with hinted insertion. Like absl_hash_map_caster, also
+// loads from a (keys, values) tuple of buffers in convert mode.
+template <typename Type, typename Key, typename Value>
+struct absl_btree_map_caster : map_caster<Type, Key, Value> {
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kCalls, 1);
+    if (!isinstance<dict>(src)) {
+      if (!convert || !internal::LoadMapFromColumns<Type, Key, Value>(
+                          src, this->value)) {
+        return false;
+      }
+      PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kFastPath, 1);
+      PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kElements, this->value.size());
+      return true;
+    }
+    auto d = reinterpret_borrow<dict>(src);
+    make_caster<Key> kconv;
+    make_caster<Value> vconv;
+    this->value.clear();
+    for (auto it : d) {
+      if (!kconv.load(it.first.ptr(), convert) ||
+          !vconv.load(it.second.ptr(), convert)) {
+        return false;
+      }
+      this->value.emplace_hint(this->value.end(),
+                               cast_op<Key&&>(std::move(kconv)),
+                               cast_op<Value&&>(std::move(vconv)));
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kElements, this->value.size());
+    return true;
+  }
+};
+
+// Like set_caster, but with hinted insertion.
+template <typename Type, typename Key>
+struct absl_btree_set_caster : set_caster<Type, Key> {
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeSet, kCalls, 1);
+    if (!isinstance<anyset>(src)) {
+      return false;
+    }
+    auto s = reinterpret_borrow<anyset>(src);
+    make_caster<Key> conv;
+    this->value.clear();
+    for (auto entry : s) {
+      if (!conv.load(entry, convert)) {
+        return false;
+      }
+      this->value.emplace_hint(this->value.end(),
+                               cast_op<Key&&>(std::move(conv)));
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeSet, kElements, this->value.size());
+    return true;
+  }
+};
+
+// Converts to a python list (in sorted order) and from a python set or
+// sequence.
+template <typename Type, typename Key>
+struct absl_btree_multiset_caster {
+  using key_conv = make_caster<Key>;
+
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeSet, kCalls, 1);
+    if (!isinstance<anyset>(src) &&
+        (!isinstance<sequence>(src) || isinstance<bytes>(src) ||
+         isinstance<str>(src))) {
+      return false;
+    }
+    key_conv conv;
+    value.clear();
+    for (auto entry : reinterpret_borrow<iterable>(src)) {
+      if (!conv.load(entry, convert)) {
+        return false;
+      }
+      value.emplace_hint(value.end(), cast_op<Key&&>(std::move(conv)));
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeSet, kElements, value.size());
+    return true;
+  }
+
+  template <typename T>
+  static handle cast(T&& src, return_value_policy policy, handle parent) {
+    if (!std::is_lvalue_reference<T>::value) {
+      policy = return_value_policy_override<Key>::policy(policy);
+    }
+    list l(src.size());
+    ssize_t index = 0;
+    for (auto&& entry : src) {
+      auto entry_ = reinterpret_steal<object>(
+          key_conv::cast(detail::forward_like<T>(entry), policy, parent));
+      if (!entry_) {
+        return handle();
+      }
+      PyList_SET_ITEM(l.ptr(), index++, entry_.release().ptr());
+    }
+    return l.release();
+  }
+
+  PYBIND11_TYPE_CASTER(Type,
+                       const_name("list[") + key_conv::name + const_name("]"));
+};
+
+// Converts to a python list of (key, value) tuples (in sorted order) and from
+// a python dict or a sequence of pairs.
+template <typename Type, typename Key, typename Value>
+struct absl_btree_multimap_caster {
+  using key_conv = make_caster<Key>;
+  using value_conv = make_caster<Value>;
+  using pair_conv = make_caster<std::pair<Key, Value>>;
+
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kCalls, 1);
+    value.clear();
+    if (isinstance<dict>(src)) {
+      key_conv kconv;
+      value_conv vconv;
+      for (auto it : reinterpret_borrow<dict>(src)) {
+        if (!kconv.load(it.first.ptr(), convert) ||
+            !vconv.load(it.second.ptr(), convert)) {
+          return false;
+        }
+        value.emplace_hint(value.end(), cast_op<Key&&>(std::move(kconv)),
+                           cast_op<Value&&>(std::move(vconv)));
+      }
+      PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kElements, value.size());
+      return true;
+    }
+    if (!isinstance<sequence>(src) || isinstance<bytes>(src) ||
+        isinstance<str>(src)) {
+      return false;
+    }
+    pair_conv conv;
+    for (auto entry : reinterpret_borrow<sequence>(src)) {
+      if (!conv.load(entry, convert)) {
+        return false;
+      }
+      value.emplace_hint(value.end(),
+                         cast_op<std::pair<Key, Value>&&>(std::move(conv)));
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kBtreeMap, kElements, value.size());
+    return true;
+  }
+
+  template <typename T>
+  static handle cast(T&& src, return_value_policy policy, handle parent) {
+    return_value_policy policy_key = policy;
+    return_value_policy policy_value = policy;
+    if (!std::is_lvalue_reference<T>::value) {
+      policy_key = return_value_policy_override<Key>::policy(policy_key);
+      policy_value = return_value_policy_override<Value>::policy(policy_value);
+    }
+    list l(src.size());
+    ssize_t index = 0;
+    for (auto&& kv : src) {
+      auto key = reinterpret_steal<object>(key_conv::cast(
+          detail::forward_like<T>(kv.first), policy_key, parent));
+      auto val = reinterpret_steal<object>(value_conv::cast(
+          detail::forward_like<T>(kv.second), policy_value, parent));
+      if (!key || !val) {
+        return handle();
+      }
+      PyList_SET_ITEM(l.ptr(), index++,
+                      make_tuple(std::move(key), std::move(val))
+                          .release()
+                          .ptr());
+    }
+    return l.release();
+  }
+
+  PYBIND11_TYPE_CASTER(Type, const_name("list[tuple[") + key_conv::name +
+                                 const_name(", ") + value_conv::name +
+                                 const_name("]]"));
+};
 
 // Convert between absl::btree_map and python dict.
 template <typename Key, typename Value, typename Compare, typename Alloc>
 struct type_caster<absl::btree_map<Key, Value, Compare, Alloc>>
-    : map_caster<absl::btree_map<Key, Value, Compare, Alloc>, Key, Value> {};
+    : absl_btree_map_caster<absl::btree_map<Key, Value, Compare, Alloc>, Key,
+                            Value> {};
+
+// Convert between absl::btree_set and python set.
+template <typename Key, typename Compare, typename Alloc>
+struct type_caster<absl::btree_set<Key, Compare, Alloc>>
+    : absl_btree_set_caster<absl::btree_set<Key, Compare, Alloc>, Key> {};
+
+// Convert absl::btree_multiset to python list, and from python set/sequence.
+template <typename Key, typename Compare, typename Alloc>
+struct type_caster<absl::btree_multiset<Key, Compare, Alloc>>
+    : absl_btree_multiset_caster<absl::btree_multiset<Key, Compare, Alloc>,
+                                 Key> {};
+
+// Convert absl::btree_multimap to python list of (key, value) tuples, and from
+// python dict/sequence of pairs.
+template <typename Key, typename Value, typename Compare, typename Alloc>
+struct type_caster<absl::btree_multimap<Key, Value, Compare, Alloc>>
+    : absl_btree_multimap_caster<
+          absl::btree_multimap<Key, Value, Compare, Alloc>, Key, Value> {};
 
-// Convert between absl::node_hash_set and python set.
-template <typename Key, typename Hash, typename Equal, typename Alloc>
-struct type_caster<absl::node_hash_set<Key, Hash, Equal, Alloc>>
-    : set_caster<absl::node_hash_set<Key, Hash, Equal, Alloc>, Key> {};
+namespace internal {
+
+// Arrays of these types are loaded from buffers (see ItemsOfBuffer()).
+template <typename T>
+static constexpr bool is_array_buffer_type =
+    (is_buffer_interface_compatible_type<T> &&
+     !std::is_same<T, PyObject*>::value) ||
+    is_byte_type<T>;
+
+// Arrays of these types are returned by reference_internal as memoryviews (see
+// google::ToMemoryView(), which requires Python >= 3.9).
+template <typename T>
+static constexpr bool is_array_view_type =
+    PY_VERSION_HEX >= 0x03090000 && google::internal::IsDLPackCompatible<T>();
+
+// Returns {true, a span over the items of the buffer exported by src, which is
+// then held by *buffer} if src exports a 1-D contiguous buffer of T, or any
+// C-contiguous buffer with items of size 1 for byte types. Otherwise returns
+// {false, an empty span}.
+template <typename T,
+          typename std::enable_if<!is_byte_type<T>, bool>::type = true>
+std::tuple<bool, absl::Span<const T>> ItemsOfBuffer(handle src,
+                                                    PyBufferView* buffer) {
+  if (!buffer->Get(src, PyBUF_STRIDES | PyBUF_FORMAT)) {
+    return {false, absl::Span<const T>()};
+  }
+  return SpanOfBufferView<const T>(buffer->view());
+}
+template <typename T,
+          typename std::enable_if<is_byte_type<T>, bool>::type = true>
+std::tuple<bool, absl::Span<const T>> ItemsOfBuffer(handle src,
+                                                    PyBufferView* buffer) {
+  if (!GetBytesBuffer(src, /*writable=*/false, buffer)) {
+    return {false, absl::Span<const T>()};
+  }
+  return {true, absl::MakeConstSpan(static_cast<const T*>(buffer->view()->buf),
+                                    static_cast<size_t>(buffer->view()->len))};
+}
+
+// Loads *value (an absl::InlinedVector or absl::FixedArray of T) with a copy of
+// the items of src if src exports a buffer of T (see ItemsOfBuffer()): the
+// array is sized once and the items are copied with a single memcpy.
+template <typename Array, typename T,
+          typename std::enable_if<is_array_buffer_type<T>, bool>::type = true>
+bool LoadArrayFromBuffer(handle src, absl::optional<Array>* value) {
+  PyBufferView buffer;
+  bool loaded;
+  absl::Span<const T> items;
+  std::tie(loaded, items) = ItemsOfBuffer<T>(src, &buffer);
+  if (!loaded) return false;
+  value->emplace(items.size());
+  if (!items.empty()) {
+    std::memcpy((*value)->data(), items.data(), items.size() * sizeof(T));
+  }
+  return true;
+}
+template <typename Array, typename T,
+          typename std::enable_if<!is_array_buffer_type<T>, bool>::type = true>
+constexpr bool LoadArrayFromBuffer(handle /*src*/,
+                                   absl::optional<Array>* /*value*/) {
+  return false;
+}
+
+// Sizes *value for n items, which are then set in order with SetArrayItem().
+// Neither allocates if n is at most the inline capacity.
+template <typename T, std::size_t N, typename A>
+void StartArray(absl::optional<absl::InlinedVector<T, N, A>>* value,
+                std::size_t n) {
+  value->emplace();
+  (*value)->reserve(n);
+}
+template <typename T, std::size_t N, typename A, typename U>
+void SetArrayItem(absl::InlinedVector<T, N, A>& array, std::size_t /*i*/,
+                  U&& item) {
+  array.push_back(std::forward<U>(item));
+}
+template <typename T, std::size_t N, typename A>
+void StartArray(absl::optional<absl::FixedArray<T, N, A>>* value,
+                std::size_t n) {
+  value->emplace(n);
+}
+template <typename T, std::size_t N, typename A, typename U>
+void SetArrayItem(absl::FixedArray<T, N, A>& array, std::size_t i, U&& item) {
+  array[i] = std::forward<U>(item);
+}
+
+// Loads *value from the items of src, a sequence other than str and bytes, with
+// internal::FastLoader. The array is sized once from the length of src.
+template <typename Array, typename T>
+bool LoadArrayFromSequence(handle src, bool convert,
+                           absl::optional<Array>* value) {
+  if (!isinstance<sequence>(src) || isinstance<bytes>(src) ||
+      isinstance<str>(src)) {
+    return false;
+  }
+  // src itself if it is a list or tuple, else a list of its items.
+  auto items = reinterpret_steal<object>(PySequence_Fast(src.ptr(), ""));
+  if (!items) {
+    PyErr_Clear();
+    return false;
+  }
+  Py_ssize_t size = PySequence_Fast_GET_SIZE(items.ptr());
+  FastLoader<T> conv;
+  StartArray(value, static_cast<std::size_t>(size));
+  for (Py_ssize_t i = 0; i < size; ++i) {
+    // Loading an item may run python code, which may modify a list.
+    if (PySequence_Fast_GET_SIZE(items.ptr()) != size) {
+      value->reset();
+      return false;
+    }
+    auto item =
+        reinterpret_borrow<object>(PySequence_Fast_GET_ITEM(items.ptr(), i));
+    if (!conv.Load(item, convert)) {
+      value->reset();
+      return false;
+    }
+    SetArrayItem(**value, static_cast<std::size_t>(i), conv.Get());
+  }
+  return true;
+}
+
+}  // namespace internal
+
+// Converts absl::InlinedVector and absl::FixedArray to a python list, and from
+// a python buffer (like the absl::Span caster, but copied with a single memcpy)
+// or sequence (sized once). Neither allocates if the number of items is at most
+// the inline capacity.
+//
+// Arrays of arithmetic and complex types returned by reference with the
+// reference_internal policy (e.g. with def_readonly or def_property_readonly)
+// are converted to a memoryview of their items instead, which keeps the parent
+// alive and is writable unless the array is const. Like pybind11 does for
+// Eigen, the view is not copied: it must not be used after the array is
+// resized or destroyed.
+template <typename Type, typename T>
+struct absl_array_caster {
+  using value_conv = make_caster<T>;
+
+  bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kArray, kCalls, 1);
+    if (internal::LoadArrayFromBuffer<Type, T>(src, &value)) {
+      PYBIND11_ABSEIL_CASTER_STAT(kArray, kFastPath, 1);
+      PYBIND11_ABSEIL_CASTER_STAT(kArray, kElements, value->size());
+      PYBIND11_ABSEIL_CASTER_STAT(kArray, kBytesCopied,
+                                  value->size() * sizeof(T));
+      return true;
+    }
+    if (!internal::LoadArrayFromSequence<Type, T>(src, convert, &value)) {
+      return false;
+    }
+    PYBIND11_ABSEIL_CASTER_STAT(kArray, kFallback, 1);
+    PYBIND11_ABSEIL_CASTER_STAT(kArray, kElements, value->size());
+    return true;
+  }
+
+  template <typename CType>
+  static handle cast(CType&& src, return_value_policy policy, handle parent) {
+    PYBIND11_ABSEIL_CASTER_STAT(kArray, kCalls, 1);
+    PYBIND11_ABSEIL_CASTER_STAT(kArray, kElements, src.size());
+    if (internal::is_array_view_type<T> &&
+        std::is_lvalue_reference<CType>::value &&
+        policy == return_value_policy::reference_internal && parent) {
+      PYBIND11_ABSEIL_CASTER_STAT(kArray, kFastPath, 1);
+      return view_of(src, parent).release();
+    }
+    return list_caster<Type, T>::cast(std::forward<CType>(src), policy,
+                                      parent);
+  }
+
+  template <typename CType,
+            typename std::enable_if<
+                std::is_same<Type, std::remove_cv_t<CType>>::value, int>::type =
+                0>
+  static handle cast(CType* src, return_value_policy policy, handle parent) {
+    if (!src) return none().release();
+    if (policy == return_value_policy::take_ownership) {
+      auto h = cast(std::move(*src), policy, parent);
+      delete src;
+      return h;
+    }
+    return cast(*src, policy, parent);
+  }
+
+  static constexpr auto name =
+      const_name("list[") + value_conv::name + const_name("]");
+
+  operator Type*() { return &*value; }
+  operator Type&() { return *value; }
+  operator Type&&() && { return std::move(*value); }
+  template <typename T_>
+  using cast_op_type = movable_cast_op_type<T_>;
+
+ private:
+  template <typename Array, typename VT = T,
+            typename std::enable_if<internal::is_array_view_type<VT>,
+                                    int>::type = 0>
+  static object view_of(Array& src, handle parent) {
+    return google::ToMemoryView(absl::MakeSpan(src), parent);
+  }
+
+  // Unreachable: cast() only returns views of is_array_view_type arrays.
+  template <typename Array, typename VT = T,
+            typename std::enable_if<!internal::is_array_view_type<VT>,
+                                    int>::type = 0>
+  static object view_of(Array&, handle) {
+    throw std::runtime_error("Expected to be unreachable.");
+  }
+
+  // Empty until loaded: absl::FixedArray is not default constructible.
+  absl::optional<Type> value;
+};
+
+// Convert between absl::InlinedVector and python list.
+template <typename T, std::size_t N, typename A>
+struct type_caster<absl::InlinedVector<T, N, A>>
+    : absl_array_caster<absl::InlinedVector<T, N, A>, T> {};
+
+// Convert between absl::FixedArray and python list.
+template <typename T, std::size_t N, typename A>
+struct type_caster<absl::FixedArray<T, N, A>>
+    : absl_array_caster<absl::FixedArray<T, N, A>, T> {};
 
 // Convert between absl::string_view and python.
 //
@@ -610,6 +1655,64 @@ struct type_caster<absl::string_view> : string_caster<absl::string_view, true> {
 };
 #endif
 
+}  // namespace detail
+
+namespace google {
+
+// The bytes of a python str (UTF-8) or of any C-contiguous buffer with items
+// of size 1 (bytes, bytearray, memoryview, mmap, ...), referenced without
+// copying. Bindings opt in to loading buffers by taking a BytesView instead of
+// an absl::string_view, which only loads str, bytes and bytearray (like
+// std::string_view). The buffer is held, so that it cannot be resized or
+// closed while the view is used: destroy with the GIL held.
+class BytesView {
+ public:
+  BytesView() = default;
+  BytesView(absl::string_view view,
+            std::shared_ptr<detail::internal::PyBufferView> buffer)
+      : view_(view), buffer_(std::move(buffer)) {}
+
+  absl::string_view view() const { return view_; }
+  operator absl::string_view() const { return view_; }
+
+ private:
+  absl::string_view view_;
+  std::shared_ptr<detail::internal::PyBufferView> buffer_;
+};
+
+}  // namespace google
+
+namespace detail {
+
+template <>
+struct type_caster<google::BytesView> {
+  PYBIND11_TYPE_CASTER(google::BytesView, const_name("Union[str, Buffer]"));
+
+  bool load(handle src, bool convert) {
+    if (PyUnicode_Check(src.ptr())) {
+      make_caster<absl::string_view> str_caster;
+      if (!str_caster.load(src, convert)) return false;
+      value = google::BytesView(cast_op<absl::string_view>(str_caster),
+                                nullptr);
+      return true;
+    }
+    if (!PyObject_CheckBuffer(src.ptr())) return false;
+    auto buffer = std::make_shared<internal::PyBufferView>();
+    if (!internal::GetBytesBuffer(src, /*writable=*/false, buffer.get())) {
+      return false;
+    }
+    absl::string_view view(static_cast<const char*>(buffer->view()->buf),
+                           static_cast<size_t>(buffer->view()->len));
+    value = google::BytesView(view, std::move(buffer));
+    return true;
+  }
+
+  static handle cast(const google::BytesView& src,
+                     return_value_policy /*policy*/, handle /*parent*/) {
+    return bytes(src.view().data(), src.view().size()).release();
+  }
+};
+
 template <>
 struct type_caster<absl::Cord> {
  public:
@@ -618,10 +1721,12 @@ struct type_caster<absl::Cord> {
 
   // Conversion part 1 (Python->C++)
   bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kCord, kCalls, 1);
     auto caster = StringViewCaster();
     if (caster.load(src, convert)) {
       absl::string_view view = cast_op<absl::string_view>(std::move(caster));
       value = view;
+      PYBIND11_ABSEIL_CASTER_STAT(kCord, kBytesCopied, view.size());
       return true;
     }
     return false;
@@ -630,6 +1735,8 @@ struct type_caster<absl::Cord> {
   // Conversion part 2 (C++ -> Python)
   static handle cast(const absl::Cord& src, return_value_policy policy,
                      handle /*parent*/) {
+    PYBIND11_ABSEIL_CASTER_STAT(kCord, kCalls, 1);
+    PYBIND11_ABSEIL_CASTER_STAT(kCord, kBytesCopied, src.size());
 #if defined(PYBIND11_HAS_RETURN_VALUE_POLICY_CLIF_AUTOMATIC)
     if (policy == return_value_policy::_clif_automatic) {
       return str(std::string(src)).release();
@@ -660,12 +1767,221 @@ template <>
 struct type_caster<absl::nullopt_t> : public void_caster<absl::nullopt_t> {};
 #endif
 
+namespace internal {
+
+// Whether a failed make_caster<T>::load(src, convert) implies that the load
+// fails for every object of the exact type of src. This must only depend on
+// the type of src (not on its value), because it decides what
+// type_cached_variant_caster may cache per type. The default (false) is always
+// safe; it only disables caching of the alternatives after T.
+template <typename T, typename SFINAE = void>
+struct variant_alternative_failure_is_type_determined {
+  static bool Check(handle /*src*/, bool /*convert*/) { return false; }
+};
+
+// Integer casters reject floats, and objects that are not numbers. Other
+// numbers can fail depending on their value (e.g. out of range).
+template <typename T>
+struct variant_alternative_failure_is_type_determined<
+    T, typename std::enable_if<std::is_integral<T>::value &&
+                               !std::is_same<T, bool>::value>::type> {
+  static bool Check(handle src, bool /*convert*/) {
+    return PyFloat_Check(src.ptr()) || !PyNumber_Check(src.ptr());
+  }
+};
+
+template <typename T>
+struct variant_alternative_failure_is_type_determined<
+    T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static bool Check(handle src, bool convert) {
+    return !convert || !PyNumber_Check(src.ptr());
+  }
+};
+
+template <>
+struct variant_alternative_failure_is_type_determined<bool> {
+  static bool Check(handle src, bool convert) {
+    PyNumberMethods* as_number = Py_TYPE(src.ptr())->tp_as_number;
+    return !convert || as_number == nullptr || as_number->nb_bool == nullptr;
+  }
+};
+
+// String casters fail for str objects that cannot be encoded as UTF-8, and
+// always load bytes and bytearray.
+template <typename T>
+struct variant_alternative_failure_is_type_determined<
+    T, typename std::enable_if<
+           std::is_same<T, std::string>::value ||
+           std::is_same<T, absl::string_view>::value ||
+           std::is_same<T, absl::TimeZone>::value>::type> {
+  static bool Check(handle src, bool /*convert*/) {
+    return !PyUnicode_Check(src.ptr());
+  }
+};
+
+// BytesView fails for buffers that are not C-contiguous or have items of
+// another size: only for objects without the buffer protocol (other than str)
+// does the failure not depend on the value.
+template <>
+struct variant_alternative_failure_is_type_determined<google::BytesView> {
+  static bool Check(handle src, bool /*convert*/) {
+    return !PyUnicode_Check(src.ptr()) && !PyObject_CheckBuffer(src.ptr());
+  }
+};
+
+// Bound classes fail depending only on the type of src, unless they have
+// implicit conversions (which run other casters in convert mode).
+template <typename T>
+struct variant_alternative_failure_is_type_determined<
+    T, typename std::enable_if<
+           std::is_base_of<type_caster_generic, make_caster<T>>::value>::type> {
+  static bool Check(handle /*src*/, bool convert) {
+    if (!convert) {
+      return true;
+    }
+    const type_info* tinfo = get_type_info(typeid(intrinsic_t<T>));
+    return tinfo == nullptr || tinfo->implicit_conversions.empty();
+  }
+};
+
+// These casters fail depending only on Py_TYPE(src); conversion errors are
+// raised as exceptions rather than reported as a failed load. (The
+// absl::Duration and absl::Civil* casters are not included: they also load
+// any object with some attributes, which depends on the value.)
+template <typename T>
+struct variant_alternative_failure_is_type_determined<
+    T, typename std::enable_if<std::is_same<T, absl::Time>::value ||
+                               std::is_same<T, absl::monostate>::value>::type> {
+  static bool Check(handle /*src*/, bool /*convert*/) { return true; }
+};
+
+// A small direct-mapped cache from python type to the index of the variant
+// alternative that loaded the last object of that type. Entries hold a
+// reference to the type, so that a freed type cannot alias a new one. Must
+// only be used with the GIL held.
+class VariantDispatchCache {
+ public:
+  bool Lookup(PyTypeObject* type, std::size_t* index) const {
+#if defined(Py_GIL_DISABLED)
+    return false;
+#else
+    const Entry& entry = entries_[Slot(type)];
+    if (entry.type != type) {
+      return false;
+    }
+    *index = entry.index;
+    return true;
+#endif
+  }
+
+  void Store(PyTypeObject* type, std::size_t index) {
+#if !defined(Py_GIL_DISABLED)
+    Entry& entry = entries_[Slot(type)];
+    if (entry.type == type) {
+      // Keep the first alternative that is known to work for this type.
+      entry.index = std::min(entry.index, index);
+      return;
+    }
+    Py_INCREF(reinterpret_cast<PyObject*>(type));
+    PyTypeObject* evicted = entry.type;
+    entry.type = type;
+    entry.index = index;
+    Py_XDECREF(reinterpret_cast<PyObject*>(evicted));
+#endif
+  }
+
+ private:
+  static constexpr std::size_t kSize = 8;
+
+  struct Entry {
+    PyTypeObject* type = nullptr;
+    std::size_t index = 0;
+  };
+
+  static std::size_t Slot(PyTypeObject* type) {
+    return (reinterpret_cast<std::uintptr_t>(type) >> 4) % kSize;
+  }
+
+  Entry entries_[kSize];
+};
+
+}  // namespace internal
+
+// Like variant_caster, but remembers for each python type which alternative
+// loaded it, and tries that alternative first for later objects of the same
+// type (falling back to trying all alternatives in order). The result is the
+// same as with variant_caster: an entry is only cached if all the alternatives
+// before it failed for reasons that only depend on the type of the object (see
+// internal::variant_alternative_failure_is_type_determined).
+//
+// This avoids constructing and failing up to two casters per alternative, e.g.
+// for the last alternative of a wide variant.
+template <typename Variant>
+struct type_cached_variant_caster;
+
+template <template <typename...> class V, typename... Ts>
+struct type_cached_variant_caster<V<Ts...>> : variant_caster<V<Ts...>> {
+  bool load(handle src, bool convert) {
+    // Same two passes as variant_caster::load().
+    if (convert && LoadPass(src, false)) {
+      return true;
+    }
+    return LoadPass(src, convert);
+  }
+
+ private:
+  static internal::VariantDispatchCache& Cache(bool convert) {
+    static internal::VariantDispatchCache caches[2];
+    return caches[convert ? 1 : 0];
+  }
+
+  bool LoadPass(handle src, bool convert) {
+    std::size_t index = 0;
+    if (Cache(convert).Lookup(Py_TYPE(src.ptr()), &index) &&
+        LoadIndex(src, convert, index, type_list<Ts...>{})) {
+      return true;
+    }
+    return Scan(src, convert, 0, /*cacheable=*/true, type_list<Ts...>{});
+  }
+
+  template <typename U, typename... Us>
+  bool LoadIndex(handle src, bool convert, std::size_t index,
+                 type_list<U, Us...>) {
+    if (index == 0) {
+      return this->load_alternative(src, convert, type_list<U>{});
+    }
+    return LoadIndex(src, convert, index - 1, type_list<Us...>{});
+  }
+  bool LoadIndex(handle, bool, std::size_t, type_list<>) { return false; }
+
+  template <typename U, typename... Us>
+  bool Scan(handle src, bool convert, std::size_t index, bool cacheable,
+            type_list<U, Us...>) {
+    if (this->load_alternative(src, convert, type_list<U>{})) {
+      if (cacheable) {
+        Cache(convert).Store(Py_TYPE(src.ptr()), index);
+      }
+      return true;
+    }
+    cacheable = cacheable &&
+                internal::variant_alternative_failure_is_type_determined<
+                    U>::Check(src, convert);
+    return Scan(src, convert, index + 1, cacheable, type_list<Us...>{});
+  }
+  bool Scan(handle, bool, std::size_t, bool, type_list<>) { return false; }
+};
+
 // This is a simple port of the pybind11 std::variant type_caster, applied to
 // absl::variant. See pybind11 stl.h.
-#ifndef ABSL_HAVE_STD_VARIANT
+//
+// If absl::variant is an alias for std::variant (the default in C++17 builds),
+// pybind11 stl.h provides the caster, which does not cache: use
+// PYBIND11_ABSEIL_TYPE_CACHED_VARIANT_CASTER below to opt specific types in.
+// (absl::optional needs no such cache: it has a single alternative.)
+#ifndef ABSL_USES_STD_VARIANT
 template <typename... Ts>
 struct type_caster<absl::variant<Ts...>>
-    : variant_caster<absl::variant<Ts...>> {};
+    : type_cached_variant_caster<absl::variant<Ts...>> {};
 
 template <>
 struct type_caster<absl::monostate>
@@ -676,4 +1992,22 @@ struct type_caster<absl::monostate>
 
 }  // namespace pybind11
 
+// Uses type_cached_variant_caster for the given std::variant (or absl::variant)
+// type. This is only needed for std::variant, including absl::variant when it
+// is an alias for std::variant. Like PYBIND11_MAKE_OPAQUE, this must appear at
+// global scope before any use of the type in the translation unit.
+//
+// This is an explicit specialization of type_caster: every translation unit
+// that converts the type must use it (e.g. from a header shared by all of
+// them). A translation unit converting the type without it uses the
+// std::variant caster instead, which violates the one definition rule.
+#define PYBIND11_ABSEIL_TYPE_CACHED_VARIANT_CASTER(...)                   \
+  namespace pybind11 {                                                    \
+  namespace detail {                                                      \
+  template <>                                                             \
+  struct type_caster<__VA_ARGS__>                                         \
+      : type_cached_variant_caster<__VA_ARGS__> {};                       \
+  }                                                                       \
+  }
+
 #endif  // PYBIND11_ABSEIL_ABSL_CASTERS_H_
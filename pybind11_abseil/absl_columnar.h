@@ -0,0 +1,89 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Conversion of absl maps with arithmetic keys and values to and from numpy
+// columns (a 1-D array of keys and a 1-D array of values).
+//
+// The map casters in absl_casters.h already load such maps from a
+// (keys, values) tuple of buffers whose item types match exactly. The helpers
+// below cover the other direction, and explicit loads that convert the dtypes:
+//
+//   m.def("get_counts", [](const Counter& c) {
+//     return pybind11::google::MapToColumns(c.counts());  // (keys, values)
+//   });
+//
+// Unlike absl_casters.h, this header depends on numpy at runtime.
+
+#ifndef PYBIND11_ABSEIL_ABSL_COLUMNAR_H_
+#define PYBIND11_ABSEIL_ABSL_COLUMNAR_H_
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <cstddef>
+#include <type_traits>
+
+#include "absl/types/optional.h"
+#include "pybind11_abseil/absl_casters.h"
+
+namespace pybind11 {
+namespace google {
+
+// Returns the entries of map as a tuple of two 1-D numpy arrays, (keys,
+// values), in the iteration order of the map (i.e. sorted for absl::btree_map).
+template <typename Map>
+tuple MapToColumns(const Map& map) {
+  using Key = typename Map::key_type;
+  using Value = typename Map::mapped_type;
+  static_assert(std::is_arithmetic<Key>::value &&
+                    std::is_arithmetic<Value>::value,
+                "MapToColumns requires arithmetic keys and values.");
+  array_t<Key> keys(static_cast<ssize_t>(map.size()));
+  array_t<Value> values(static_cast<ssize_t>(map.size()));
+  Key* key_out = keys.mutable_data();
+  Value* value_out = values.mutable_data();
+  for (const auto& kv : map) {
+    *key_out++ = kv.first;
+    *value_out++ = kv.second;
+  }
+  return make_tuple(std::move(keys), std::move(values));
+}
+
+// Builds a Map from two 1-D arrays of the same length, converting their dtypes
+// if needed. As for dict(zip(keys, values)), the last of duplicate keys wins.
+// The GIL is released while inserting into large maps.
+template <typename Map>
+Map MapFromColumns(
+    const array_t<typename Map::key_type, array::c_style | array::forcecast>&
+        keys,
+    const array_t<typename Map::mapped_type,
+                  array::c_style | array::forcecast>& values) {
+  if (keys.ndim() != 1 || values.ndim() != 1) {
+    throw value_error("MapFromColumns: keys and values must be 1-D arrays.");
+  }
+  if (keys.size() != values.size()) {
+    throw value_error(
+        "MapFromColumns: keys and values must have the same length.");
+  }
+  auto n = static_cast<std::size_t>(keys.size());
+  const auto* key_data = keys.data();
+  const auto* value_data = values.data();
+  Map map;
+  absl::optional<gil_scoped_release> release_gil;
+  if (n >= detail::internal::kColumnarLoadReleaseGilMinSize) {
+    release_gil.emplace();
+  }
+  detail::internal::ReserveIfSupported(map, n, 0);
+  for (std::size_t i = 0; i < n; ++i) {
+    detail::internal::InsertOrAssignColumnEntry(map, key_data[i],
+                                                value_data[i]);
+  }
+  return map;
+}
+
+}  // namespace google
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_ABSL_COLUMNAR_H_
@@ -0,0 +1,733 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Opaque (non-converting) bindings for absl containers, in the spirit of
+// pybind11/stl_bind.h.
+//
+// The casters in absl_casters.h convert absl containers to and from Python
+// dict/set objects on every call, which is O(n) in the size of the container.
+// The helpers in this file instead expose the C++ container itself as a Python
+// object, so that functions can take it by reference without any conversion.
+//
+// Usage:
+//
+//   PYBIND11_MAKE_OPAQUE(absl::flat_hash_map<std::string, double>);
+//
+//   PYBIND11_MODULE(my_module, m) {
+//     pybind11::google::bind_flat_hash_map<
+//         absl::flat_hash_map<std::string, double>>(m, "StringToDoubleMap");
+//   }
+//
+// PYBIND11_MAKE_OPAQUE is required (as for pybind11::bind_map) to override
+// the converting casters in absl_casters.h, and has to appear before any use
+// of the container type in the translation unit.
+//
+// Supported binders:
+// - bind_flat_hash_map, bind_node_hash_map: bound as collections.abc
+//   MutableMapping.
+// - bind_flat_hash_set, bind_node_hash_set: bound as collections.abc
+//   MutableSet.
+// - bind_btree_map: bound as an ordered collections.abc MutableMapping, with
+//   range queries.
+//
+// The bound types implement the whole collections.abc interface (including
+// update(), setdefault(), popitem() and == for the maps, and the comparisons,
+// the set operators and pop() for the sets).
+//
+// absl::flat_hash_map, absl::flat_hash_set and absl::btree_map move their
+// elements on insertion (rehash, rebalancing), so their keys and values are
+// returned by copy. absl::node_hash_map and absl::node_hash_set return them by
+// reference (reference_internal), like pybind11::bind_map.
+//
+// Containers keyed by std::string with transparent hash and equality functors
+// (the absl defaults) additionally accept str and bytes keys for lookups
+// without materializing a temporary std::string.
+
+#ifndef PYBIND11_ABSEIL_ABSL_CONTAINER_BIND_H_
+#define PYBIND11_ABSEIL_ABSL_CONTAINER_BIND_H_
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl_bind.h>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "absl/meta/type_traits.h"
+#include "absl/strings/string_view.h"
+#include "pybind11_abseil/absl_casters.h"
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+// True if the container supports heterogeneous lookup of its std::string keys
+// with an absl::string_view (i.e. the hash and equality functors, or the
+// comparator, are transparent; this is the absl default for std::string).
+template <typename Container, typename = void>
+struct supports_string_view_lookup : std::false_type {};
+template <typename Container>
+struct supports_string_view_lookup<
+    Container, absl::void_t<decltype(std::declval<const Container&>().find(
+                   std::declval<absl::string_view>()))>>
+    : std::is_same<typename Container::key_type, std::string> {};
+
+inline object CollectionsAbc(const char* name) {
+  return module_::import("collections.abc").attr(name);
+}
+
+inline void RegisterWithCollectionsAbc(handle cls, const char* abc_name) {
+  CollectionsAbc(abc_name).attr("register")(cls);
+}
+
+inline object NotImplemented() {
+  return reinterpret_borrow<object>(Py_NotImplemented);
+}
+
+// Converts h to an element of type T of a container, raising TypeError (as
+// the python containers do) if it cannot.
+template <typename T>
+T CastElementFrom(handle h) {
+  detail::make_caster<T> caster;
+  if (!caster.load(h, /*convert=*/true)) {
+    throw type_error("Unable to convert " + std::string(repr(h)) +
+                     " to C++ type " + type_id<T>());
+  }
+  return T(detail::cast_op<T>(std::move(caster)));
+}
+
+// Returns value, an element of the container self, with Policy.
+template <return_value_policy Policy, typename T>
+object CastElement(T& value, handle self) {
+  return reinterpret_steal<object>(
+      detail::make_caster<T>::cast(value, Policy, self));
+}
+
+// Defines __getitem__(), get() and pop() for lookups with LookupKey (the
+// key_type itself, or absl::string_view for heterogeneous lookup), returning
+// the values with Policy. __getitem__() is prepended to the overloads of
+// pybind11::bind_map. extra is forwarded to def().
+template <typename Map, return_value_policy Policy, typename LookupKey,
+          typename Class_, typename... Extra>
+void def_map_lookups(Class_& cl, const Extra&... extra) {
+  cl.def(
+      "__getitem__",
+      [](const object& self, LookupKey k) {
+        auto& m = cast<Map&>(self);
+        auto it = m.find(k);
+        if (it == m.end()) {
+          throw key_error();
+        }
+        return CastElement<Policy>(it->second, self);
+      },
+      prepend());
+  cl.def(
+      "get",
+      [](const object& self, LookupKey k, const object& default_value) {
+        auto& m = cast<Map&>(self);
+        auto it = m.find(k);
+        if (it == m.end()) {
+          return default_value;
+        }
+        return CastElement<Policy>(it->second, self);
+      },
+      arg("key"), arg("default") = none(), extra...);
+  cl.def(
+      "pop",
+      [](Map& m, LookupKey k) {
+        auto it = m.find(k);
+        if (it == m.end()) {
+          throw key_error();
+        }
+        object result = cast(std::move(it->second));
+        m.erase(it);
+        return result;
+      },
+      arg("key"), extra...);
+  cl.def(
+      "pop",
+      [](Map& m, LookupKey k, const object& default_value) {
+        auto it = m.find(k);
+        if (it == m.end()) {
+          return default_value;
+        }
+        object result = cast(std::move(it->second));
+        m.erase(it);
+        return result;
+      },
+      arg("key"), arg("default"), extra...);
+}
+
+// Heterogeneous lookups. These are prepended to the overload chain, so that
+// str and bytes keys never reach the std::string overloads.
+template <typename Map, return_value_policy Policy, typename Class_,
+          typename std::enable_if<
+              supports_string_view_lookup<Map>::value, int>::type = 0>
+void def_map_string_view_lookups(Class_& cl) {
+  cl.def(
+      "__contains__",
+      [](const Map& m, absl::string_view k) { return m.contains(k); },
+      prepend());
+  cl.def(
+      "__delitem__",
+      [](Map& m, absl::string_view k) {
+        auto it = m.find(k);
+        if (it == m.end()) {
+          throw key_error();
+        }
+        m.erase(it);
+      },
+      prepend());
+  def_map_lookups<Map, Policy, absl::string_view>(cl, prepend());
+}
+
+template <typename Map, return_value_policy Policy, typename Class_,
+          typename std::enable_if<
+              !supports_string_view_lookup<Map>::value, int>::type = 0>
+void def_map_string_view_lookups(Class_& /*cl*/) {}
+
+// The MutableMapping methods that pybind11::bind_map does not define, with
+// the same semantics as for dict.
+template <typename Map, return_value_policy Policy, typename Class_>
+void def_map_mixins(Class_& cl) {
+  using KeyType = typename Map::key_type;
+  using MappedType = typename Map::mapped_type;
+  cl.def(
+      "setdefault",
+      [](const object& self, const KeyType& k, const object& default_value) {
+        auto& m = cast<Map&>(self);
+        auto it = m.find(k);
+        if (it == m.end()) {
+          it = m.emplace(k, CastElementFrom<MappedType>(default_value)).first;
+        }
+        return CastElement<Policy>(it->second, self);
+      },
+      arg("key"), arg("default") = none());
+  cl.def("popitem", [](Map& m) {
+    if (m.empty()) {
+      throw key_error("popitem(): the map is empty");
+    }
+    auto it = m.begin();
+    tuple item = make_tuple(it->first, std::move(it->second));
+    m.erase(it);
+    return item;
+  });
+  // update(mapping_or_pairs=None, **kwargs).
+  cl.def(
+      "update",
+      [](Map& m, const object& other, const kwargs& kw) {
+        if (hasattr(other, "keys")) {
+          for (handle k : other.attr("keys")()) {
+            m.insert_or_assign(CastElementFrom<KeyType>(k),
+                               CastElementFrom<MappedType>(other[k]));
+          }
+        } else if (!other.is_none()) {
+          for (handle item : other) {
+            auto kvp = CastElementFrom<std::pair<KeyType, MappedType>>(item);
+            m.insert_or_assign(std::move(kvp.first), std::move(kvp.second));
+          }
+        }
+        for (auto kvp : kw) {
+          m.insert_or_assign(CastElementFrom<KeyType>(kvp.first),
+                             CastElementFrom<MappedType>(kvp.second));
+        }
+      },
+      arg("other") = none());
+  // Equal to any Mapping with the same items (also defines !=, and makes the
+  // map unhashable).
+  cl.def("__eq__", [](const object& self, const object& other) -> object {
+    if (!isinstance(other, CollectionsAbc("Mapping"))) {
+      return NotImplemented();
+    }
+    return bool_(dict(self).equal(dict(other)));
+  });
+}
+
+// Replaces the iterator and the keys(), values() and items() views of
+// pybind11::bind_map, which return references to the keys and values, with
+// ones returning copies: the collections.abc views, which look the values up
+// with __getitem__.
+template <typename Map, typename Class_>
+void def_map_copying_views(Class_& cl) {
+  cl.def(
+      "__iter__",
+      [](Map& m) {
+        return make_key_iterator<return_value_policy::copy>(m.begin(),
+                                                            m.end());
+      },
+      keep_alive<0, 1>(), prepend());
+  cl.def(
+      "keys",
+      [](const object& self) { return CollectionsAbc("KeysView")(self); },
+      prepend());
+  cl.def(
+      "values",
+      [](const object& self) { return CollectionsAbc("ValuesView")(self); },
+      prepend());
+  cl.def(
+      "items",
+      [](const object& self) { return CollectionsAbc("ItemsView")(self); },
+      prepend());
+}
+
+// Policy is how the keys and values are returned: by copy if the container
+// moves its elements (absl::flat_hash_map and absl::btree_map, on rehash or
+// rebalancing), since a reference would dangle after the next insertion, or
+// by reference_internal if it does not (absl::node_hash_map).
+template <typename Map, return_value_policy Policy, typename holder_type,
+          typename... Args>
+class_<Map, holder_type> bind_absl_map(handle scope, const std::string& name,
+                                       Args&&... args) {
+  using KeyType = typename Map::key_type;
+  // pybind11::bind_map provides the mapping protocol (including the keys(),
+  // values() and items() views) for any map-like container.
+  auto cl =
+      bind_map<Map, holder_type>(scope, name, std::forward<Args>(args)...);
+  if (Policy != return_value_policy::reference_internal) {
+    def_map_copying_views<Map>(cl);
+  }
+  def_map_lookups<Map, Policy, const KeyType&>(cl);
+  def_map_string_view_lookups<Map, Policy>(cl);
+  def_map_mixins<Map, Policy>(cl);
+  cl.def("clear", [](Map& m) { m.clear(); });
+  RegisterWithCollectionsAbc(cl, "MutableMapping");
+  return cl;
+}
+
+template <typename Map, return_value_policy Policy, typename holder_type,
+          typename... Args>
+class_<Map, holder_type> bind_absl_hash_map(handle scope,
+                                            const std::string& name,
+                                            Args&&... args) {
+  auto cl = bind_absl_map<Map, Policy, holder_type>(
+      scope, name, std::forward<Args>(args)...);
+  cl.def(
+      "reserve", [](Map& m, std::size_t n) { m.reserve(n); }, arg("n"));
+  return cl;
+}
+
+// Returns the iterators delimiting the keys k with lo <= k < hi. None bounds
+// are unbounded; the range is empty if hi <= lo.
+template <typename Map>
+std::pair<typename Map::iterator, typename Map::iterator> BtreeKeyRange(
+    Map& m, const object& lo, const object& hi) {
+  using KeyType = typename Map::key_type;
+  auto first = lo.is_none() ? m.begin() : m.lower_bound(lo.cast<KeyType>());
+  auto last = hi.is_none() ? m.end() : m.lower_bound(hi.cast<KeyType>());
+  if (last != m.end() &&
+      (first == m.end() || m.key_comp()(last->first, first->first))) {
+    last = first;
+  }
+  return {first, last};
+}
+
+template <typename Map, typename holder_type, typename... Args>
+class_<Map, holder_type> bind_absl_btree_map(handle scope,
+                                             const std::string& name,
+                                             Args&&... args) {
+  using KeyType = typename Map::key_type;
+  constexpr auto kCopy = return_value_policy::copy;
+  // The btree is iterated in order, without copying it.
+  auto cl = bind_absl_map<Map, kCopy, holder_type>(
+      scope, name, std::forward<Args>(args)...);
+  cl.def(
+      "__reversed__",
+      [](Map& m) { return make_key_iterator<kCopy>(m.rbegin(), m.rend()); },
+      keep_alive<0, 1>());
+  cl.def(
+      "irange",
+      [](Map& m, const object& lo, const object& hi, bool reverse) {
+        auto range = BtreeKeyRange(m, lo, hi);
+        if (reverse) {
+          return make_key_iterator<kCopy>(
+              std::make_reverse_iterator(range.second),
+              std::make_reverse_iterator(range.first));
+        }
+        return make_key_iterator<kCopy>(range.first, range.second);
+      },
+      arg("lo") = none(), arg("hi") = none(), arg("reverse") = false,
+      keep_alive<0, 1>(),
+      "Iterates over the keys k with lo <= k < hi, in order (or in reverse "
+      "order if reverse is True). None bounds are unbounded.");
+  cl.def(
+      "lower_bound",
+      [](const Map& m, const KeyType& k) -> object {
+        auto it = m.lower_bound(k);
+        if (it == m.end()) {
+          return none();
+        }
+        return cast(it->first);
+      },
+      arg("key"), "Returns the first key >= key, or None.");
+  cl.def(
+      "upper_bound",
+      [](const Map& m, const KeyType& k) -> object {
+        auto it = m.upper_bound(k);
+        if (it == m.end()) {
+          return none();
+        }
+        return cast(it->first);
+      },
+      arg("key"), "Returns the first key > key, or None.");
+  cl.def(
+      "items_range",
+      [](Map& m, const object& lo, const object& hi, bool reverse) {
+        auto range = BtreeKeyRange(m, lo, hi);
+        if (reverse) {
+          return make_iterator<kCopy>(std::make_reverse_iterator(range.second),
+                                      std::make_reverse_iterator(range.first));
+        }
+        return make_iterator<kCopy>(range.first, range.second);
+      },
+      arg("lo") = none(), arg("hi") = none(), arg("reverse") = false,
+      keep_alive<0, 1>(),
+      "Iterates over the (key, value) items with lo <= key < hi, in key order "
+      "(or in reverse order if reverse is True). None bounds are unbounded.");
+  return cl;
+}
+
+template <typename Set, typename LookupKey, typename Class_, typename... Extra>
+void def_set_lookups(Class_& cl, const Extra&... extra) {
+  cl.def(
+      "__contains__",
+      [](const Set& s, LookupKey k) { return s.contains(k); }, extra...);
+  cl.def(
+      "discard", [](Set& s, LookupKey k) { s.erase(k); }, arg("key"),
+      extra...);
+  cl.def(
+      "remove",
+      [](Set& s, LookupKey k) {
+        auto it = s.find(k);
+        if (it == s.end()) {
+          throw key_error();
+        }
+        s.erase(it);
+      },
+      arg("key"), extra...);
+}
+
+template <typename Set, typename Class_,
+          typename std::enable_if<
+              supports_string_view_lookup<Set>::value, int>::type = 0>
+void def_set_string_view_lookups(Class_& cl) {
+  def_set_lookups<Set, absl::string_view>(cl, prepend());
+}
+
+template <typename Set, typename Class_,
+          typename std::enable_if<
+              !supports_string_view_lookup<Set>::value, int>::type = 0>
+void def_set_string_view_lookups(Class_& /*cl*/) {}
+
+// Whether the python container (or bound Set) other contains the key k.
+template <typename Set>
+bool ContainerContains(const object& other, const typename Set::key_type& k) {
+  if (isinstance<Set>(other)) {
+    return cast<const Set&>(other).contains(k);
+  }
+  return other.contains(cast(k));
+}
+
+// Whether every key of s is in other.
+template <typename Set>
+bool IsSubset(const Set& s, const object& other) {
+  for (const auto& k : s) {
+    if (!ContainerContains<Set>(other, k)) return false;
+  }
+  return true;
+}
+
+// Whether every element of other is in the set self.
+inline bool IsSuperset(const object& self, const object& other) {
+  for (handle value : other) {
+    if (!self.contains(value)) return false;
+  }
+  return true;
+}
+
+// other itself if it is a collections.abc.Set, else a set of its elements.
+inline object AsPySet(const object& other) {
+  if (isinstance(other, CollectionsAbc("Set"))) {
+    return other;
+  }
+  return set(other);
+}
+
+// The keys of s not in other_set (see AsPySet()).
+template <typename Set>
+Set Difference(const Set& s, const object& other_set) {
+  Set result;
+  for (const auto& k : s) {
+    if (!ContainerContains<Set>(other_set, k)) result.insert(k);
+  }
+  return result;
+}
+
+// The MutableSet methods, with the same semantics as for set. The binary
+// operators take any iterable (returning NotImplemented otherwise) and return
+// a new Set, the comparisons take any collections.abc.Set.
+template <typename Set, typename Class_>
+void def_set_mixins(Class_& cl) {
+  using KeyType = typename Set::key_type;
+  // op(self, other) for the comparisons: <, <=, ==, >=, >.
+  auto compare = [](bool (*size_ok)(std::size_t, std::size_t),
+                    bool superset) {
+    return [size_ok, superset](const object& self,
+                               const object& other) -> object {
+      if (!isinstance(other, CollectionsAbc("Set"))) {
+        return NotImplemented();
+      }
+      const Set& s = cast<const Set&>(self);
+      if (!size_ok(s.size(), len(other))) return bool_(false);
+      return bool_(superset ? IsSuperset(self, other) : IsSubset(s, other));
+    };
+  };
+  cl.def("__eq__", compare(
+                       [](std::size_t a, std::size_t b) { return a == b; },
+                       /*superset=*/false));
+  cl.def("__le__", compare(
+                       [](std::size_t a, std::size_t b) { return a <= b; },
+                       /*superset=*/false));
+  cl.def("__lt__", compare(
+                       [](std::size_t a, std::size_t b) { return a < b; },
+                       /*superset=*/false));
+  cl.def("__ge__", compare(
+                       [](std::size_t a, std::size_t b) { return a >= b; },
+                       /*superset=*/true));
+  cl.def("__gt__", compare(
+                       [](std::size_t a, std::size_t b) { return a > b; },
+                       /*superset=*/true));
+  cl.def(
+      "isdisjoint",
+      [](const object& self, const iterable& other) {
+        for (handle value : other) {
+          if (self.contains(value)) return false;
+        }
+        return true;
+      },
+      arg("other"));
+
+  auto union_ = [](const Set& s, const iterable& other) {
+    Set result = s;
+    for (handle value : other) {
+      result.insert(CastElementFrom<KeyType>(value));
+    }
+    return result;
+  };
+  auto intersection = [](const object& self, const iterable& other) {
+    Set result;
+    for (handle value : other) {
+      if (self.contains(value)) result.insert(value.cast<KeyType>());
+    }
+    return result;
+  };
+  auto difference = [](const Set& s, const iterable& other) {
+    return Difference(s, AsPySet(other));
+  };
+  auto symmetric_difference = [](const object& self, const iterable& other) {
+    object o = AsPySet(other);
+    Set result = Difference(cast<const Set&>(self), o);
+    for (handle value : o) {
+      if (!self.contains(value)) result.insert(CastElementFrom<KeyType>(value));
+    }
+    return result;
+  };
+  cl.def("__or__", union_, is_operator());
+  cl.def("__ror__", union_, is_operator());
+  cl.def("__and__", intersection, is_operator());
+  cl.def("__rand__", intersection, is_operator());
+  cl.def("__sub__", difference, is_operator());
+  cl.def(
+      "__rsub__",
+      [](const object& self, const iterable& other) {
+        Set result;
+        for (handle value : other) {
+          if (!self.contains(value)) {
+            result.insert(CastElementFrom<KeyType>(value));
+          }
+        }
+        return result;
+      },
+      is_operator());
+  cl.def("__xor__", symmetric_difference, is_operator());
+  cl.def("__rxor__", symmetric_difference, is_operator());
+
+  cl.def(
+      "__ior__",
+      [](const object& self, const iterable& other) {
+        Set& s = cast<Set&>(self);
+        for (handle value : other) {
+          s.insert(CastElementFrom<KeyType>(value));
+        }
+        return self;
+      },
+      is_operator());
+  cl.def(
+      "__iand__",
+      [](const object& self, const iterable& other) {
+        Set& s = cast<Set&>(self);
+        object o = AsPySet(other);
+        Set kept;
+        for (const auto& k : s) {
+          if (ContainerContains<Set>(o, k)) kept.insert(k);
+        }
+        s.swap(kept);
+        return self;
+      },
+      is_operator());
+  cl.def(
+      "__isub__",
+      [](const object& self, const iterable& other) {
+        Set& s = cast<Set&>(self);
+        if (other.is(self)) {
+          s.clear();
+          return self;
+        }
+        for (handle value : other) {
+          detail::make_caster<KeyType> key;
+          if (key.load(value, /*convert=*/true)) {
+            s.erase(detail::cast_op<const KeyType&>(key));
+          }
+        }
+        return self;
+      },
+      is_operator());
+  cl.def(
+      "__ixor__",
+      [](const object& self, const iterable& other) {
+        Set& s = cast<Set&>(self);
+        if (other.is(self)) {
+          s.clear();
+          return self;
+        }
+        for (handle value : AsPySet(other)) {
+          auto k = CastElementFrom<KeyType>(value);
+          auto it = s.find(k);
+          if (it != s.end()) {
+            s.erase(it);
+          } else {
+            s.insert(std::move(k));
+          }
+        }
+        return self;
+      },
+      is_operator());
+  cl.def("pop", [](Set& s) {
+    if (s.empty()) {
+      throw key_error("pop(): the set is empty");
+    }
+    auto it = s.begin();
+    object result = cast(*it);
+    s.erase(it);
+    return result;
+  });
+}
+
+// Policy is how the keys are returned, as for bind_absl_map().
+template <typename Set, return_value_policy Policy, typename holder_type,
+          typename... Args>
+class_<Set, holder_type> bind_absl_hash_set(handle scope,
+                                            const std::string& name,
+                                            Args&&... args) {
+  using KeyType = typename Set::key_type;
+  using Class_ = class_<Set, holder_type>;
+
+  // Same module_local policy as pybind11::bind_vector: if the key type is a
+  // non-module-local bound type, the set binding is non-local as well.
+  auto* tinfo = detail::get_type_info(typeid(KeyType));
+  bool local = !tinfo || tinfo->module_local;
+
+  Class_ cl(scope, name.c_str(), module_local(local),
+            std::forward<Args>(args)...);
+  cl.def(init<>());
+  cl.def(init([](const iterable& it) {
+           Set s;
+           for (handle h : it) {
+             s.insert(h.cast<KeyType>());
+           }
+           return s;
+         }),
+         arg("iterable"));
+  cl.def("__bool__", [](const Set& s) { return !s.empty(); });
+  cl.def("__len__", [](const Set& s) { return s.size(); });
+  cl.def(
+      "__iter__",
+      [](Set& s) { return make_iterator<Policy>(s.begin(), s.end()); },
+      keep_alive<0, 1>());
+  def_set_lookups<Set, const KeyType&>(cl);
+  // Fallback for when the object is not of the key type.
+  cl.def("__contains__", [](const Set&, const object&) { return false; });
+  def_set_string_view_lookups<Set>(cl);
+  def_set_mixins<Set>(cl);
+  cl.def(
+      "add", [](Set& s, const KeyType& k) { s.insert(k); }, arg("key"));
+  cl.def("clear", [](Set& s) { s.clear(); });
+  cl.def(
+      "reserve", [](Set& s, std::size_t n) { s.reserve(n); }, arg("n"));
+  RegisterWithCollectionsAbc(cl, "MutableSet");
+  return cl;
+}
+
+}  // namespace internal
+
+// Binds an absl::flat_hash_map as a Python MutableMapping.
+template <typename Map, typename holder_type = std::unique_ptr<Map>,
+          typename... Args>
+class_<Map, holder_type> bind_flat_hash_map(handle scope,
+                                            const std::string& name,
+                                            Args&&... args) {
+  return internal::bind_absl_hash_map<Map, return_value_policy::copy,
+                                      holder_type>(
+      scope, name, std::forward<Args>(args)...);
+}
+
+// Binds an absl::node_hash_map as a Python MutableMapping.
+template <typename Map, typename holder_type = std::unique_ptr<Map>,
+          typename... Args>
+class_<Map, holder_type> bind_node_hash_map(handle scope,
+                                            const std::string& name,
+                                            Args&&... args) {
+  return internal::bind_absl_hash_map<
+      Map, return_value_policy::reference_internal, holder_type>(
+      scope, name, std::forward<Args>(args)...);
+}
+
+// Binds an absl::btree_map as an ordered Python MutableMapping, with range
+// queries (irange(), items_range(), lower_bound() and upper_bound()).
+template <typename Map, typename holder_type = std::unique_ptr<Map>,
+          typename... Args>
+class_<Map, holder_type> bind_btree_map(handle scope, const std::string& name,
+                                        Args&&... args) {
+  return internal::bind_absl_btree_map<Map, holder_type>(
+      scope, name, std::forward<Args>(args)...);
+}
+
+// Binds an absl::flat_hash_set as a Python MutableSet.
+template <typename Set, typename holder_type = std::unique_ptr<Set>,
+          typename... Args>
+class_<Set, holder_type> bind_flat_hash_set(handle scope,
+                                            const std::string& name,
+                                            Args&&... args) {
+  return internal::bind_absl_hash_set<Set, return_value_policy::copy,
+                                      holder_type>(
+      scope, name, std::forward<Args>(args)...);
+}
+
+// Binds an absl::node_hash_set as a Python MutableSet.
+template <typename Set, typename holder_type = std::unique_ptr<Set>,
+          typename... Args>
+class_<Set, holder_type> bind_node_hash_set(handle scope,
+                                            const std::string& name,
+                                            Args&&... args) {
+  return internal::bind_absl_hash_set<
+      Set, return_value_policy::reference_internal, holder_type>(
+      scope, name, std::forward<Args>(args)...);
+}
+
+}  // namespace google
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_ABSL_CONTAINER_BIND_H_
@@ -0,0 +1,242 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Bindings used by absl_casters_benchmark_main.py.
+//
+// Each load_* function takes its argument by const reference, so that the only
+// work done is the conversion from python. Each cast_* function returns a value
+// owned by a CastFixture, so that the only work done is the conversion to
+// python. noop() and noop_arg() measure the call overhead. The baseline_*
+// variants use types that are bound with the stock pybind11 casters for
+// comparison (map_caster/set_caster for containers with a distinct hasher,
+// variant_caster for a variant with an extra, never matching, alternative).
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
+#include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/civil_time.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "pybind11_abseil/absl_casters.h"
+
+namespace pybind11 {
+namespace benchmarks {
+
+template <typename T>
+struct BaselineHash : absl::Hash<T> {};
+
+template <typename T>
+struct BaselineEq : std::equal_to<T> {};
+
+template <typename Key, typename Value>
+using BaselineFlatHashMap =
+    absl::flat_hash_map<Key, Value, BaselineHash<Key>, BaselineEq<Key>>;
+
+template <typename Key>
+using BaselineFlatHashSet =
+    absl::flat_hash_set<Key, BaselineHash<Key>, BaselineEq<Key>>;
+
+using WideVariant = absl::variant<int64_t, double, std::string, absl::Time,
+                                  absl::Duration, std::vector<float>>;
+
+// Not bound, so never loaded.
+struct BaselineMarker {};
+
+using BaselineWideVariant =
+    absl::variant<int64_t, double, std::string, absl::Time, absl::Duration,
+                  std::vector<float>, BaselineMarker>;
+
+}  // namespace benchmarks
+
+namespace detail {
+
+template <typename Key, typename Value, typename Alloc>
+struct type_caster<absl::flat_hash_map<Key, Value,
+                                       benchmarks::BaselineHash<Key>,
+                                       benchmarks::BaselineEq<Key>, Alloc>>
+    : map_caster<absl::flat_hash_map<Key, Value, benchmarks::BaselineHash<Key>,
+                                     benchmarks::BaselineEq<Key>, Alloc>,
+                 Key, Value> {};
+
+template <typename Key, typename Alloc>
+struct type_caster<absl::flat_hash_set<Key, benchmarks::BaselineHash<Key>,
+                                       benchmarks::BaselineEq<Key>, Alloc>>
+    : set_caster<absl::flat_hash_set<Key, benchmarks::BaselineHash<Key>,
+                                     benchmarks::BaselineEq<Key>, Alloc>,
+                 Key> {};
+
+// Explicit specializations, so that the comparison does not depend on whether
+// absl::variant is an alias for std::variant.
+template <>
+struct type_caster<benchmarks::WideVariant>
+    : type_cached_variant_caster<benchmarks::WideVariant> {};
+
+template <>
+struct type_caster<benchmarks::BaselineWideVariant>
+    : variant_caster<benchmarks::BaselineWideVariant> {};
+
+}  // namespace detail
+
+namespace benchmarks {
+
+template <typename Container>
+void DefLoad(module_& m, const char* name) {
+  m.def(
+      name, [](const Container& c) { return c.size(); }, arg("container"));
+}
+
+template <typename Key>
+void DefLoadsForKey(module_& m, const std::string& key_name) {
+  std::string map_name = "flat_hash_map_" + key_name + "_double";
+  std::string set_name = "flat_hash_set_" + key_name;
+  DefLoad<absl::flat_hash_map<Key, double>>(m, ("load_" + map_name).c_str());
+  DefLoad<BaselineFlatHashMap<Key, double>>(
+      m, ("load_baseline_" + map_name).c_str());
+  DefLoad<absl::flat_hash_set<Key>>(m, ("load_" + set_name).c_str());
+  DefLoad<BaselineFlatHashSet<Key>>(m, ("load_baseline_" + set_name).c_str());
+}
+
+template <typename T>
+void DefLoadOnly(module_& m, const char* name) {
+  m.def(
+      name, [](const T&) {}, arg("value"));
+}
+
+// The values returned by the cast_* functions, for a given container size.
+struct CastFixture {
+  explicit CastFixture(int size)
+      : doubles(static_cast<std::size_t>(size), 1.5),
+        inlined_doubles(static_cast<std::size_t>(size), 1.5),
+        bytes(static_cast<std::size_t>(size), 'x') {
+    for (int i = 0; i < size; ++i) {
+      hash_map[i] = i;
+      btree_map[i] = i;
+      hash_set.insert(i);
+      btree_set.insert(i);
+    }
+    // A multi-chunk cord.
+    for (int i = 0; i < size; i += 64) {
+      cord.Append(absl::string_view(bytes).substr(i, 64));
+    }
+  }
+
+  std::vector<double> doubles;
+  absl::InlinedVector<double, 8> inlined_doubles;
+  std::string bytes;
+  absl::Cord cord;
+  absl::flat_hash_map<int64_t, double> hash_map;
+  absl::btree_map<int64_t, double> btree_map;
+  absl::flat_hash_set<int64_t> hash_set;
+  absl::btree_set<int64_t> btree_set;
+};
+
+PYBIND11_MODULE(absl_casters_benchmark, m) {
+  m.def("noop", []() {});
+  m.def(
+      "noop_arg", [](const object&) {}, arg("value"));
+
+  // Loads.
+  DefLoadsForKey<int64_t>(m, "int64");
+  DefLoadsForKey<std::string>(m, "str");
+  DefLoadsForKey<double>(m, "double");
+  DefLoad<absl::node_hash_map<int64_t, double>>(
+      m, "load_node_hash_map_int64_double");
+  DefLoad<absl::btree_map<int64_t, double>>(m, "load_btree_map_int64_double");
+  DefLoad<absl::btree_set<int64_t>>(m, "load_btree_set_int64");
+  DefLoadOnly<absl::Duration>(m, "load_duration");
+  DefLoadOnly<absl::Time>(m, "load_time");
+  DefLoadOnly<absl::TimeZone>(m, "load_timezone");
+  DefLoadOnly<absl::CivilSecond>(m, "load_civil_second");
+  DefLoadOnly<absl::CivilDay>(m, "load_civil_day");
+  DefLoadOnly<absl::Span<const double>>(m, "load_span_double");
+  DefLoadOnly<absl::Span<const int64_t>>(m, "load_span_int64");
+  DefLoadOnly<absl::Span<PyObject* const>>(m, "load_span_pyobject");
+  // The inline capacity is 8: smaller inputs are loaded without allocating.
+  DefLoadOnly<absl::InlinedVector<double, 8>>(m, "load_inlined_vector_double");
+  DefLoadOnly<absl::FixedArray<double, 8>>(m, "load_fixed_array_double");
+  DefLoadOnly<std::vector<double>>(m, "load_baseline_vector_double");
+  DefLoadOnly<absl::Span<const absl::string_view>>(m,
+                                                   "load_span_string_view");
+  DefLoadOnly<absl::string_view>(m, "load_string_view");
+  DefLoadOnly<absl::Cord>(m, "load_cord");
+  DefLoadOnly<absl::optional<int64_t>>(m, "load_optional_int64");
+
+  // Casts.
+  class_<CastFixture>(m, "CastFixture")
+      .def(init<int>(), arg("size"))
+      .def("cast_span_double",
+           [](const CastFixture& f) {
+             return absl::Span<const double>(f.doubles);
+           })
+      .def("cast_inlined_vector_double",
+           [](const CastFixture& f) -> const absl::InlinedVector<double, 8>& {
+             return f.inlined_doubles;
+           })
+      .def(
+          "cast_inlined_vector_double_view",
+          [](const CastFixture& f) -> const absl::InlinedVector<double, 8>& {
+            return f.inlined_doubles;
+          },
+          return_value_policy::reference_internal)
+      .def("cast_string_view",
+           [](const CastFixture& f) { return absl::string_view(f.bytes); })
+      .def("cast_cord", [](const CastFixture& f) { return f.cord; })
+      .def("cast_flat_hash_map_int64_double",
+           [](const CastFixture& f) -> const absl::flat_hash_map<int64_t,
+                                                                 double>& {
+             return f.hash_map;
+           })
+      .def("cast_btree_map_int64_double",
+           [](const CastFixture& f) -> const absl::btree_map<int64_t, double>& {
+             return f.btree_map;
+           })
+      .def("cast_flat_hash_set_int64",
+           [](const CastFixture& f) -> const absl::flat_hash_set<int64_t>& {
+             return f.hash_set;
+           })
+      .def("cast_btree_set_int64",
+           [](const CastFixture& f) -> const absl::btree_set<int64_t>& {
+             return f.btree_set;
+           });
+  m.def("cast_duration", []() { return absl::Seconds(1.5); });
+  m.def("cast_time", []() { return absl::FromUnixSeconds(1700000000); });
+  m.def("cast_timezone", []() { return absl::UTCTimeZone(); });
+  m.def("cast_civil_second",
+        []() { return absl::CivilSecond(2024, 1, 2, 3, 4, 5); });
+  m.def("cast_civil_day", []() { return absl::CivilDay(2024, 1, 2); });
+  m.def("cast_optional_int64_value",
+        []() { return absl::optional<int64_t>(1); });
+  m.def("cast_optional_int64_none",
+        []() { return absl::optional<int64_t>(); });
+  m.def("cast_wide_variant_string",
+        []() { return WideVariant(std::string("abc")); });
+  m.def(
+      "load_wide_variant",
+      [](const WideVariant& v) { return v.index(); }, arg("variant"));
+  m.def(
+      "load_baseline_wide_variant",
+      [](const BaselineWideVariant& v) { return v.index(); }, arg("variant"));
+}
+
+}  // namespace benchmarks
+}  // namespace pybind11
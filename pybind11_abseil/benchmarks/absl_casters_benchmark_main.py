@@ -0,0 +1,225 @@
+# Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Benchmarks for the casters in absl_casters.h.
+
+Compares the absl_casters.h casters ("absl") with the stock pybind11 casters
+("baseline") for:
+- loading python dicts and sets into absl::flat_hash_map/set, for each key
+  type and container size.
+- loading each alternative of a wide absl::variant.
+
+Also measures, with loads and casts timed separately, every other caster in
+absl_casters.h, for each kind of input it accepts (exact type, subclass,
+buffer, generic sequence) and container size. call/noop* is the overhead of a
+bound call, to be subtracted from the other timings.
+
+absl::InlinedVector and absl::FixedArray (inline capacity 8) are also loaded
+from inputs around their inline capacity, compared with std::vector
+("baseline_vector_double"), which always allocates.
+"""
+
+import array
+import datetime
+import functools
+
+import numpy as np
+
+from pybind11_abseil.benchmarks import absl_casters_benchmark
+from pybind11_abseil.benchmarks import benchmark_harness
+
+_SIZES = (10, 1_000, 100_000)
+
+_KEY_FACTORIES = {
+    'int64': lambda n: list(range(n)),
+    'str': lambda n: [f'key{i}' for i in range(n)],
+    'double': lambda n: [i + 0.5 for i in range(n)],
+}
+
+
+def register(runner: benchmark_harness.Runner) -> None:
+  for key_type, make_keys in _KEY_FACTORIES.items():
+    for size in _SIZES:
+      keys = make_keys(size)
+      inputs = {
+          f'flat_hash_map_{key_type}_double': {k: 1.5 for k in keys},
+          f'flat_hash_set_{key_type}': set(keys),
+      }
+      for container, data in inputs.items():
+        for impl in ('absl', 'baseline'):
+          prefix = 'load_' if impl == 'absl' else 'load_baseline_'
+          fn = getattr(absl_casters_benchmark, prefix + container)
+          runner.run(
+              f'load/{container}/{impl}/{size}', functools.partial(fn, data)
+          )
+
+
+_WIDE_VARIANT_INPUTS = {
+    'int': 1,
+    'float': 1.5,
+    'str': 'abc',
+    'datetime': datetime.datetime(2024, 1, 1, tzinfo=datetime.timezone.utc),
+    'timedelta': datetime.timedelta(seconds=1),
+    'list': [1.5] * 8,
+}
+
+
+def register_variants(runner: benchmark_harness.Runner) -> None:
+  for kind, value in _WIDE_VARIANT_INPUTS.items():
+    for impl in ('absl', 'baseline'):
+      prefix = 'load_' if impl == 'absl' else 'load_baseline_'
+      fn = getattr(absl_casters_benchmark, prefix + 'wide_variant')
+      runner.run(
+          f'load/wide_variant/{kind}/{impl}', functools.partial(fn, value)
+      )
+
+
+class _ListSubclass(list):
+  pass
+
+
+class _StrSubclass(str):
+  pass
+
+
+def _load_inputs(size):
+  """Returns {(caster, input kind): value} for the load benchmarks."""
+  doubles = [1.5] * size
+  ints = list(range(size))
+  int_dict = {i: 1.5 for i in ints}
+  text = 'x' * size
+  words = [f'w{i}' for i in range(size)]
+  return {
+      ('span_double', 'numpy'): np.array(doubles, dtype=np.float64),
+      ('span_double', 'array'): array.array('d', doubles),
+      ('span_double', 'memoryview'): memoryview(array.array('d', doubles)),
+      ('span_double', 'list'): doubles,
+      ('span_double', 'tuple'): tuple(doubles),
+      ('span_double', 'list_subclass'): _ListSubclass(doubles),
+      ('span_int64', 'numpy'): np.array(ints, dtype=np.int64),
+      ('span_int64', 'list'): ints,
+      ('span_pyobject', 'list'): doubles,
+      ('span_pyobject', 'tuple'): tuple(doubles),
+      ('span_string_view', 'list_str'): words,
+      ('span_string_view', 'list_bytes'): [w.encode() for w in words],
+      ('inlined_vector_double', 'numpy'): np.array(doubles, dtype=np.float64),
+      ('inlined_vector_double', 'list'): doubles,
+      ('fixed_array_double', 'numpy'): np.array(doubles, dtype=np.float64),
+      ('fixed_array_double', 'list'): doubles,
+      ('string_view', 'str'): text,
+      ('string_view', 'bytes'): text.encode(),
+      ('string_view', 'str_subclass'): _StrSubclass(text),
+      ('cord', 'str'): text,
+      ('cord', 'bytes'): text.encode(),
+      ('node_hash_map_int64_double', 'dict'): int_dict,
+      ('btree_map_int64_double', 'dict'): int_dict,
+      ('btree_map_int64_double', 'columns'): (
+          np.array(ints, dtype=np.int64),
+          np.array(doubles, dtype=np.float64),
+      ),
+      ('btree_set_int64', 'set'): set(ints),
+      ('btree_set_int64', 'list'): ints,
+  }
+
+
+_SCALAR_LOAD_INPUTS = {
+    ('duration', 'timedelta'): datetime.timedelta(seconds=1.5),
+    ('duration', 'float'): 1.5,
+    ('time', 'datetime_utc'): datetime.datetime(
+        2024, 1, 1, tzinfo=datetime.timezone.utc
+    ),
+    ('time', 'datetime_naive'): datetime.datetime(2024, 1, 1),
+    ('time', 'float'): 1700000000.5,
+    ('timezone', 'str'): 'UTC',
+    ('civil_second', 'datetime'): datetime.datetime(2024, 1, 2, 3, 4, 5),
+    ('civil_day', 'date'): datetime.date(2024, 1, 2),
+    ('optional_int64', 'int'): 1,
+    ('optional_int64', 'none'): None,
+}
+
+
+def register_loads(runner: benchmark_harness.Runner) -> None:
+  runner.run('call/noop', absl_casters_benchmark.noop)
+  runner.run(
+      'call/noop_arg', functools.partial(absl_casters_benchmark.noop_arg, 1)
+  )
+  for (caster, kind), value in _SCALAR_LOAD_INPUTS.items():
+    fn = getattr(absl_casters_benchmark, 'load_' + caster)
+    runner.run(f'load/{caster}/{kind}', functools.partial(fn, value))
+  for size in _SIZES:
+    for (caster, kind), value in _load_inputs(size).items():
+      fn = getattr(absl_casters_benchmark, 'load_' + caster)
+      runner.run(f'load/{caster}/{kind}/{size}', functools.partial(fn, value))
+
+
+# Around the inline capacity of the arrays (8).
+_SMALL_ARRAY_SIZES = (1, 4, 8, 9)
+
+_SMALL_ARRAY_CASTERS = (
+    'inlined_vector_double',
+    'fixed_array_double',
+    'baseline_vector_double',
+)
+
+
+def register_small_arrays(runner: benchmark_harness.Runner) -> None:
+  for size in _SMALL_ARRAY_SIZES:
+    doubles = [1.5] * size
+    inputs = {
+        'list': doubles,
+        'tuple': tuple(doubles),
+        'numpy': np.array(doubles, dtype=np.float64),
+    }
+    for caster in _SMALL_ARRAY_CASTERS:
+      fn = getattr(absl_casters_benchmark, 'load_' + caster)
+      for kind, value in inputs.items():
+        runner.run(
+            f'load/{caster}/{kind}/{size}', functools.partial(fn, value)
+        )
+
+
+_SIZED_CASTS = (
+    'span_double',
+    'inlined_vector_double',
+    'inlined_vector_double_view',
+    'string_view',
+    'cord',
+    'flat_hash_map_int64_double',
+    'btree_map_int64_double',
+    'flat_hash_set_int64',
+    'btree_set_int64',
+)
+
+_SCALAR_CASTS = (
+    'duration',
+    'time',
+    'timezone',
+    'civil_second',
+    'civil_day',
+    'optional_int64_value',
+    'optional_int64_none',
+    'wide_variant_string',
+)
+
+
+def register_casts(runner: benchmark_harness.Runner) -> None:
+  for caster in _SCALAR_CASTS:
+    fn = getattr(absl_casters_benchmark, 'cast_' + caster)
+    runner.run(f'cast/{caster}', fn)
+  for size in _SIZES:
+    fixture = absl_casters_benchmark.CastFixture(size)
+    for caster in _SIZED_CASTS:
+      runner.run(f'cast/{caster}/{size}', getattr(fixture, 'cast_' + caster))
+
+
+def register_all(runner: benchmark_harness.Runner) -> None:
+  register(runner)
+  register_variants(runner)
+  register_loads(runner)
+  register_small_arrays(runner)
+  register_casts(runner)
+
+
+if __name__ == '__main__':
+  benchmark_harness.run_main(register_all)
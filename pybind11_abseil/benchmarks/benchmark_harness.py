@@ -0,0 +1,114 @@
+# Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Minimal timing harness shared by the pybind11_abseil benchmarks.
+
+A benchmark binary defines a function that registers its benchmarks with a
+Runner, and passes it to run_main():
+
+  def register(runner):
+    runner.run('load/int64/1000', functools.partial(load, data))
+
+  if __name__ == '__main__':
+    benchmark_harness.run_main(register)
+
+Results are printed as a table and, with --benchmark_out, written as JSON. If
+register() returns a message, the binary exits with it as an error (e.g. when a
+result exceeds its target).
+"""
+
+import dataclasses
+import datetime
+import json
+import platform
+import re
+import sys
+import timeit
+from typing import Callable, List, Optional
+
+from absl import app
+from absl import flags
+
+_FILTER = flags.DEFINE_string(
+    'benchmark_filter', None, 'Regex selecting the benchmarks to run.'
+)
+_OUT = flags.DEFINE_string(
+    'benchmark_out', None, 'Path of the JSON report to write.'
+)
+_REPETITIONS = flags.DEFINE_integer(
+    'benchmark_repetitions',
+    5,
+    'Number of timed repetitions; the fastest one is reported.',
+)
+
+
+@dataclasses.dataclass(frozen=True)
+class Result:
+  name: str
+  ns_per_op: float
+  iterations: int
+
+
+class Runner:
+  """Times callables and collects the results."""
+
+  def __init__(
+      self, name_filter: Optional[str] = None, repetitions: int = 5
+  ) -> None:
+    self._filter = re.compile(name_filter) if name_filter else None
+    self._repetitions = repetitions
+    self.results: List[Result] = []
+
+  @property
+  def repetitions(self) -> int:
+    return self._repetitions
+
+  def run(self, name: str, fn: Callable[[], object]) -> Optional[Result]:
+    """Times fn(), unless name is excluded by the filter."""
+    if self._filter is not None and not self._filter.search(name):
+      return None
+    timer = timeit.Timer(fn)
+    iterations, _ = timer.autorange()
+    best = min(timer.repeat(repeat=self._repetitions, number=iterations))
+    return self.report(name, best / iterations * 1e9, iterations)
+
+  def report(
+      self, name: str, ns_per_op: float, iterations: int
+  ) -> Optional[Result]:
+    """Records a result measured by the caller, unless name is excluded."""
+    if self._filter is not None and not self._filter.search(name):
+      return None
+    result = Result(name, ns_per_op, iterations)
+    self.results.append(result)
+    print(f'{name:<72} {result.ns_per_op:>14.1f} ns/op', flush=True)
+    return result
+
+  def to_json(self) -> str:
+    return json.dumps(
+        {
+            'context': {
+                'date': datetime.datetime.now().isoformat(),
+                'python': sys.version,
+                'platform': platform.platform(),
+            },
+            'benchmarks': [dataclasses.asdict(r) for r in self.results],
+        },
+        indent=2,
+    )
+
+
+def run_main(register: Callable[[Runner], Optional[str]]) -> None:
+  """Runs the benchmarks registered by register(), as an absl app."""
+
+  def main(argv):
+    del argv  # Unused.
+    runner = Runner(_FILTER.value, _REPETITIONS.value)
+    failure = register(runner)
+    if _OUT.value:
+      with open(_OUT.value, 'w') as f:
+        f.write(runner.to_json())
+    if failure:
+      sys.exit(failure)
+
+  app.run(main)
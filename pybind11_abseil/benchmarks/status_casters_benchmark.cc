@@ -0,0 +1,160 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Bindings used by status_casters_benchmark_main.py.
+//
+// As in absl_casters_benchmark.cc, the load_* functions only convert their
+// argument from python, and the cast_* functions only convert their (prebuilt)
+// result to python. The cast_*_error functions raise StatusNotOk. The
+// instrumented_* functions are the same as the plain_* ones, wrapped with
+// google::Instrumented(), to measure the cost of the latency histograms. The
+// sum_* functions pull integers from python with the GIL released: per item
+// through a std::function, or in batches through a PyBatchedSource.
+
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "pybind11_abseil/instrumented_binding.h"
+#include "pybind11_abseil/py_batched_source.h"
+#include "pybind11_abseil/status_casters.h"
+
+namespace pybind11 {
+namespace benchmarks {
+
+// A status with a 4 KiB message and four 4 KiB payloads.
+absl::Status LargeErrorStatus() {
+  absl::Status status(absl::StatusCode::kInternal, std::string(4096, 'm'));
+  for (int i = 0; i < 4; ++i) {
+    status.SetPayload(absl::StrCat("type.googleapis.com/diagnostics", i),
+                      absl::Cord(std::string(4096, 'p')));
+  }
+  return status;
+}
+
+// The values returned by the cast_* functions, for a given payload size.
+struct StatusCastFixture {
+  explicit StatusCastFixture(int size)
+      : error(absl::StatusCode::kNotFound, "not found"),
+        large_error(LargeErrorStatus()),
+        ok_vector(std::vector<double>(static_cast<std::size_t>(size), 1.5)),
+        error_vector(error) {}
+
+  absl::Status ok;
+  absl::Status error;
+  absl::Status large_error;
+  absl::StatusOr<std::vector<double>> ok_vector;
+  absl::StatusOr<std::vector<double>> error_vector;
+};
+
+int Add(int a, int b) { return a + b; }
+
+absl::Status ReturnOkStatus() { return absl::OkStatus(); }
+
+absl::StatusOr<int> StatusOrInt(int value) { return value; }
+
+// The sum of the items returned by next, until nullopt.
+template <typename Next>
+absl::StatusOr<std::int64_t> Sum(Next& next) {
+  std::int64_t sum = 0;
+  while (true) {
+    absl::StatusOr<absl::optional<std::int64_t>> item = next();
+    if (!item.ok()) return item.status();
+    if (!item->has_value()) return sum;
+    sum += **item;
+  }
+}
+
+PYBIND11_MODULE(status_casters_benchmark, m) {
+  auto status_module = google::ImportStatusModule();
+  m.attr("StatusNotOk") = status_module.attr("StatusNotOk");
+
+  m.def("noop", []() {});
+
+  // Loads.
+  m.def(
+      "load_status", [](const absl::Status&) {}, arg("status"));
+  m.def(
+      "load_statusor_int", [](const absl::StatusOr<int>&) {}, arg("value"));
+
+  // Casts.
+  class_<StatusCastFixture>(m, "StatusCastFixture")
+      .def(init<int>(), arg("size"))
+      .def("cast_ok_status",
+           [](const StatusCastFixture& f) -> const absl::Status& {
+             return f.ok;
+           })
+      .def("cast_error_status",
+           [](const StatusCastFixture& f) -> const absl::Status& {
+             return f.error;
+           })
+      .def("cast_large_error_status",
+           [](const StatusCastFixture& f) -> const absl::Status& {
+             return f.large_error;
+           })
+      .def("cast_no_throw_ok_status",
+           [](const StatusCastFixture& f) {
+             return google::DoNotThrowStatus(f.ok);
+           })
+      .def("cast_no_throw_error_status",
+           [](const StatusCastFixture& f) {
+             return google::DoNotThrowStatus(f.error);
+           })
+      .def("cast_statusor_vector_ok",
+           [](const StatusCastFixture& f)
+               -> const absl::StatusOr<std::vector<double>>& {
+             return f.ok_vector;
+           })
+      .def("cast_statusor_vector_error",
+           [](const StatusCastFixture& f)
+               -> const absl::StatusOr<std::vector<double>>& {
+             return f.error_vector;
+           });
+  m.def("cast_statusor_int_ok", []() { return absl::StatusOr<int>(1); });
+  m.def("cast_statusor_int_error", []() {
+    return absl::StatusOr<int>(absl::NotFoundError("not found"));
+  });
+
+  // Calls.
+  m.def("plain_add", &Add);
+  m.def("instrumented_add", google::Instrumented("benchmark.add", &Add));
+  m.def("plain_ok_status", &ReturnOkStatus);
+  m.def("instrumented_ok_status",
+        google::Instrumented("benchmark.ok_status", &ReturnOkStatus));
+  m.def("plain_statusor_int", &StatusOrInt);
+  m.def("instrumented_statusor_int",
+        google::Instrumented("benchmark.statusor_int", &StatusOrInt));
+
+  // Sources.
+  m.def(
+      "sum_per_item",
+      [](std::function<absl::StatusOr<absl::optional<std::int64_t>>()> next) {
+        return Sum(next);
+      },
+      arg("next"), call_guard<gil_scoped_release>());
+  m.def(
+      "sum_batched",
+      [](handle iterable, std::size_t batch_size) {
+        google::PyBatchedSource<std::int64_t> source(iterable, batch_size);
+        gil_scoped_release release;
+        return Sum(source);
+      },
+      arg("iterable"), arg("batch_size"));
+}
+
+}  // namespace benchmarks
+}  // namespace pybind11
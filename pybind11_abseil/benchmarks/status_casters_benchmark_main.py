@@ -0,0 +1,237 @@
+# Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Benchmarks for the casters in status_caster.h and statusor_caster.h.
+
+Measures, separately:
+- loading absl::Status from a Status, a Status subclass and an object with an
+  as_absl_Status() method, and absl::StatusOr<int> from an int and a Status.
+- casting ok and error absl::Status (None or StatusNotOk, and
+  DoNotThrowStatus), and absl::StatusOr of an int and of a vector.
+- calling bindings with and without google::Instrumented()
+  (call/<name>/plain and call/<name>/instrumented); call/<name>/overhead is
+  the difference, the cost of recording the latency histograms.
+- the accessors of Status (access/status/...).
+- reading the payloads of a Status (payload/<accessor>/<payload size>):
+  get_payload() and payloads() do not copy large payloads, their cost does not
+  depend on the payload size, unlike AllPayloads().
+- the batch functions ok_mask, partition and raise_if_any, and the equivalent
+  python loops over is_ok(), for 1000 mixed values and errors
+  (batch/<function>/<implementation>).
+- pulling 100000 integers from python into C++ with the GIL released
+  (source/...): through a std::function called once per item (per_item), and
+  through a PyBatchedSource acquiring the GIL once per batch
+  (batched/<batch size>).
+
+The binary fails if an overhead exceeds --max_overhead_ns.
+"""
+
+import functools
+from typing import Optional
+
+from absl import flags
+
+from pybind11_abseil import status
+from pybind11_abseil.benchmarks import benchmark_harness
+from pybind11_abseil.benchmarks import status_casters_benchmark as scb
+
+_SIZES = (10, 1_000, 100_000)
+
+_MAX_OVERHEAD_NS = flags.DEFINE_integer(
+    'max_overhead_ns',
+    20,
+    'Target for the overhead of google::Instrumented() on a call, in '
+    'nanoseconds. 0 disables the check.',
+)
+
+
+class _StatusSubclass(status.Status):
+  pass
+
+
+class _HasAsAbslStatus:
+
+  def __init__(self, st):
+    self._status = st
+
+  def as_absl_Status(self):  # pylint: disable=invalid-name
+    return self._status.as_absl_Status()
+
+
+def _raising(fn):
+  def call():
+    try:
+      fn()
+    except scb.StatusNotOk:
+      pass
+
+  return call
+
+
+def register(runner: benchmark_harness.Runner) -> None:
+  runner.run('call/noop', scb.noop)
+
+  error = status.Status(status.StatusCode.NOT_FOUND, 'not found')
+  status_inputs = {
+      'ok': status.Status.OkStatus(),
+      'error': error,
+      'subclass': _StatusSubclass(status.StatusCode.NOT_FOUND, 'not found'),
+      'as_absl_Status': _HasAsAbslStatus(error),
+  }
+  for kind, value in status_inputs.items():
+    runner.run(
+        f'load/status/{kind}', functools.partial(scb.load_status, value)
+    )
+  for kind, value in (('int', 1), ('status', error)):
+    runner.run(
+        f'load/statusor_int/{kind}',
+        functools.partial(scb.load_statusor_int, value),
+    )
+
+  fixture = scb.StatusCastFixture(1)
+  runner.run('cast/status/ok', fixture.cast_ok_status)
+  runner.run('cast/status/error', _raising(fixture.cast_error_status))
+  # A 4 KiB message and four 4 KiB payloads.
+  runner.run(
+      'cast/status/large_error', _raising(fixture.cast_large_error_status)
+  )
+  runner.run('cast/no_throw_status/ok', fixture.cast_no_throw_ok_status)
+  runner.run('cast/no_throw_status/error', fixture.cast_no_throw_error_status)
+  runner.run('cast/statusor_int/ok', scb.cast_statusor_int_ok)
+  runner.run('cast/statusor_int/error', _raising(scb.cast_statusor_int_error))
+  for size in _SIZES:
+    fixture = scb.StatusCastFixture(size)
+    runner.run(
+        f'cast/statusor_vector/ok/{size}', fixture.cast_statusor_vector_ok
+    )
+  runner.run(
+      'cast/statusor_vector/error',
+      _raising(scb.StatusCastFixture(1).cast_statusor_vector_error),
+  )
+
+
+_INSTRUMENTED_CALLS = {
+    'add': (1, 2),
+    'ok_status': (),
+    'statusor_int': (1,),
+}
+
+
+def register_instrumented(runner: benchmark_harness.Runner) -> Optional[str]:
+  failures = []
+  for name, call_args in _INSTRUMENTED_CALLS.items():
+    results = {}
+    for impl in ('plain', 'instrumented'):
+      fn = getattr(scb, f'{impl}_{name}')
+      results[impl] = runner.run(
+          f'call/{name}/{impl}', functools.partial(fn, *call_args)
+      )
+    if results['plain'] is None or results['instrumented'] is None:
+      continue
+    overhead_ns = results['instrumented'].ns_per_op - results['plain'].ns_per_op
+    runner.report(
+        f'call/{name}/overhead',
+        overhead_ns,
+        min(r.iterations for r in results.values()),
+    )
+    if _MAX_OVERHEAD_NS.value and overhead_ns > _MAX_OVERHEAD_NS.value:
+      failures.append(
+          f'The overhead of google::Instrumented() on {name} '
+          f'({overhead_ns:.1f} ns) exceeds '
+          f'--max_overhead_ns={_MAX_OVERHEAD_NS.value}.'
+      )
+  return '\n'.join(failures) or None
+
+
+def register_accessors(runner: benchmark_harness.Runner) -> None:
+  error = status.Status(status.StatusCode.NOT_FOUND, 'not found')
+  for name in ('ok', 'code', 'code_int', 'raw_code', 'message', '__hash__'):
+    runner.run(f'access/status/{name}', getattr(error, name))
+  runner.run('access/status/hash', functools.partial(hash, error))
+  runner.run('access/status/str', functools.partial(str, error))
+
+
+def register_payloads(runner: benchmark_harness.Runner) -> None:
+  for size in (1 << 10, 1 << 20):
+    st = status.Status(status.StatusCode.INTERNAL, 'payloads')
+    st.SetPayload('type.googleapis.com/diagnostics', b'\x5a' * size)
+    runner.run(
+        f'payload/get_payload/{size}',
+        functools.partial(st.get_payload, 'type.googleapis.com/diagnostics'),
+    )
+    runner.run(
+        f'payload/payloads/{size}', lambda st=st: list(st.payloads())
+    )
+    runner.run(f'payload/AllPayloads/{size}', st.AllPayloads)
+
+
+def _py_ok_mask(results):
+  return bytes(status.is_ok(r) for r in results)
+
+
+def _py_partition(results):
+  values, indices, statuses = [], [], []
+  for i, r in enumerate(results):
+    if status.is_ok(r):
+      values.append(r)
+    else:
+      indices.append(i)
+      statuses.append(r)
+  return values, indices, statuses
+
+
+def _raise_if_any(results):
+  try:
+    status.raise_if_any(results)
+  except Exception:  # pylint: disable=broad-exception-caught
+    pass
+
+
+def _py_raise_if_any(results):
+  errors = [status.StatusNotOk(r) for r in results if not status.is_ok(r)]
+  if errors:
+    try:
+      raise errors[0]
+    except status.StatusNotOk:
+      pass
+
+
+def register_batch(runner: benchmark_harness.Runner) -> None:
+  error = status.Status(status.StatusCode.UNAVAILABLE, 'backend unavailable')
+  # One error in 10, as from a fan-out to 1000 backends.
+  results = [error if i % 10 == 0 else i for i in range(1000)]
+  for name, native, python in (
+      ('ok_mask', status.ok_mask, _py_ok_mask),
+      ('partition', status.partition, _py_partition),
+      ('raise_if_any', _raise_if_any, _py_raise_if_any),
+  ):
+    runner.run(f'batch/{name}/native', functools.partial(native, results))
+    runner.run(f'batch/{name}/python', functools.partial(python, results))
+
+
+def register_sources(runner: benchmark_harness.Runner) -> None:
+  data = list(range(100_000))
+  runner.run(
+      'source/per_item',
+      lambda: scb.sum_per_item(functools.partial(next, iter(data), None)),
+  )
+  for batch_size in (1, 16, 256, 4096):
+    runner.run(
+        f'source/batched/{batch_size}',
+        functools.partial(scb.sum_batched, data, batch_size),
+    )
+
+
+def register_all(runner: benchmark_harness.Runner) -> Optional[str]:
+  register(runner)
+  failure = register_instrumented(runner)
+  register_accessors(runner)
+  register_payloads(runner)
+  register_batch(runner)
+  register_sources(runner)
+  return failure
+
+
+if __name__ == '__main__':
+  benchmark_harness.run_main(register_all)
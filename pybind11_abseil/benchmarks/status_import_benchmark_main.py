@@ -0,0 +1,73 @@
+# Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Benchmark of the import time of pybind11_abseil.status.
+
+Each repetition imports the module in a new python process, with
+`python -X importtime`, and parses the time reported for the module:
+- self: loading the extension and RegisterStatusBindings(), the cost paid by
+  every extension calling ImportStatusModule().
+- cumulative: including the modules imported by pybind11_abseil.status.
+The fastest repetition is reported.
+
+The binary fails if the self time exceeds --max_self_us.
+"""
+
+import os
+import re
+import subprocess
+import sys
+from typing import Dict, Optional, Tuple
+
+from absl import flags
+
+from pybind11_abseil.benchmarks import benchmark_harness
+
+_MODULE = 'pybind11_abseil.status'
+
+_MAX_SELF_US = flags.DEFINE_integer(
+    'max_self_us',
+    3000,
+    f'Target for the self import time of {_MODULE}, in microseconds. 0 '
+    'disables the check.',
+)
+
+# e.g. "import time:       812 |       2140 |   pybind11_abseil.status"
+_IMPORT_TIME_LINE = re.compile(
+    r'import time:\s*(\d+)\s*\|\s*(\d+)\s*\|\s*(.*)'
+)
+
+
+def _import_times_us() -> Dict[str, Tuple[int, int]]:
+  """Returns {module: (self_us, cumulative_us)} for a cold import."""
+  process = subprocess.run(
+      [sys.executable, '-X', 'importtime', '-c', f'import {_MODULE}'],
+      stderr=subprocess.PIPE,
+      check=True,
+      env=dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path)),
+      text=True,
+  )
+  times = {}
+  for line in process.stderr.splitlines():
+    match = _IMPORT_TIME_LINE.match(line)
+    if match:
+      times[match.group(3).strip()] = (int(match.group(1)),
+                                       int(match.group(2)))
+  return times
+
+
+def register(runner: benchmark_harness.Runner) -> Optional[str]:
+  samples = [_import_times_us()[_MODULE] for _ in range(runner.repetitions)]
+  self_us = min(self_us for self_us, _ in samples)
+  cumulative_us = min(cumulative_us for _, cumulative_us in samples)
+  runner.report(f'import/{_MODULE}/self', self_us * 1e3, 1)
+  runner.report(f'import/{_MODULE}/cumulative', cumulative_us * 1e3, 1)
+  if _MAX_SELF_US.value and self_us > _MAX_SELF_US.value:
+    return (f'The self import time of {_MODULE} ({self_us} us) exceeds '
+            f'--max_self_us={_MAX_SELF_US.value}.')
+  return None
+
+
+if __name__ == '__main__':
+  benchmark_harness.run_main(register)
@@ -0,0 +1,107 @@
+# Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Benchmark of pickling pybind11_abseil.status.Status with large payloads.
+
+Benchmark names are <what>/<protocol>/<payload size>, with the protocols:
+- 4: the message and payloads are copied into the pickle.
+- 5: the message and payloads are exported as PickleBuffers, written in-band.
+- 5oob: the PickleBuffers are passed out-of-band (pickle buffer_callback), not
+  copied.
+
+`pickle/...` is dumps() then loads() in this process. `pipe/...` is a round
+trip through a multiprocessing.Pipe to a child process that loads the status
+and sends it back; out-of-band buffers are sent as separate messages.
+"""
+
+import functools
+import multiprocessing
+import pickle
+from typing import List, Optional, Tuple
+
+from pybind11_abseil.benchmarks import benchmark_harness
+from pybind11_abseil import status
+
+_PAYLOAD_SIZES = (1 << 10, 1 << 20, 16 << 20)
+_PROTOCOLS = ('4', '5', '5oob')
+
+
+def _make_status(payload_size: int) -> status.Status:
+  st = status.Status(status.StatusCode.INTERNAL, 'Diagnostics attached.')
+  st.SetPayload('type.googleapis.com/diagnostics', b'\x5a' * payload_size)
+  return st
+
+
+def _dumps(st: status.Status, protocol: str) -> Tuple[bytes, List[object]]:
+  if protocol == '5oob':
+    buffers = []
+    data = pickle.dumps(st, protocol=5, buffer_callback=buffers.append)
+    return data, [buffer.raw() for buffer in buffers]
+  return pickle.dumps(st, protocol=int(protocol)), []
+
+
+def _pickle_round_trip(st: status.Status, protocol: str) -> None:
+  data, buffers = _dumps(st, protocol)
+  pickle.loads(data, buffers=buffers)
+
+
+def _send(conn, st: status.Status, protocol: str) -> None:
+  data, buffers = _dumps(st, protocol)
+  conn.send((protocol, len(buffers)))
+  conn.send_bytes(data)
+  for buffer in buffers:
+    conn.send_bytes(buffer)
+
+
+def _recv(conn) -> Optional[Tuple[status.Status, str]]:
+  header = conn.recv()
+  if header is None:
+    return None
+  protocol, num_buffers = header
+  data = conn.recv_bytes()
+  buffers = [conn.recv_bytes() for _ in range(num_buffers)]
+  return pickle.loads(data, buffers=buffers), protocol
+
+
+def _echo(conn) -> None:
+  while True:
+    received = _recv(conn)
+    if received is None:
+      return
+    _send(conn, *received)
+
+
+def _pipe_round_trip(conn, st: status.Status, protocol: str) -> None:
+  _send(conn, st, protocol)
+  _recv(conn)
+
+
+def register(runner: benchmark_harness.Runner) -> None:
+  for size in _PAYLOAD_SIZES:
+    st = _make_status(size)
+    for protocol in _PROTOCOLS:
+      runner.run(
+          f'pickle/{protocol}/{size}',
+          functools.partial(_pickle_round_trip, st, protocol),
+      )
+
+  context = multiprocessing.get_context('spawn')
+  conn, child_conn = context.Pipe()
+  child = context.Process(target=_echo, args=(child_conn,), daemon=True)
+  child.start()
+  try:
+    for size in _PAYLOAD_SIZES:
+      st = _make_status(size)
+      for protocol in _PROTOCOLS:
+        runner.run(
+            f'pipe/{protocol}/{size}',
+            functools.partial(_pipe_round_trip, conn, st, protocol),
+        )
+  finally:
+    conn.send(None)
+    child.join()
+
+
+if __name__ == '__main__':
+  benchmark_harness.run_main(register)
@@ -0,0 +1,370 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// A timeline of the C++/Python boundary crossings, exported as Chrome trace
+// JSON (viewable in chrome://tracing or https://ui.perfetto.dev).
+//
+// The tracer records spans while tracing is started (StartBoundaryTracing(),
+// or pybind11_abseil.stats.start_tracing() in python):
+// - the phases (args, exec, result) of the bindings wrapped with
+//   google::Instrumented() (see instrumented_binding.h).
+// - with PYBIND11_ABSEIL_ENABLE_BOUNDARY_TRACER defined (Bazel:
+//   --define=pybind11_abseil_boundary_tracer=1, CMake:
+//   -DENABLE_BOUNDARY_TRACER=ON), in the Status and StatusOr func_wrapper
+//   specializations: GIL acquisition, the conversion of the arguments, the
+//   python call, the conversion of its result and the translation of a python
+//   exception to a Status; and the translation of StatusNotOk to a python
+//   exception.
+//
+// Each thread appends to its own fixed-size ring buffer (older spans are
+// overwritten), without locks. The buffer is shared by all the extension
+// modules, so that each thread has a single track in the trace. Trace JSON is
+// built on demand from a consistent copy of the buffers.
+
+#ifndef PYBIND11_ABSEIL_BOUNDARY_TRACER_H_
+#define PYBIND11_ABSEIL_BOUNDARY_TRACER_H_
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pybind11_abseil/tick_clock.h"
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+// A span of a thread. The fields are atomics because SnapshotTo() may read a
+// slot while its thread overwrites it; such slots are discarded.
+struct TraceEvent {
+  std::atomic<const char*> name{nullptr};
+  std::atomic<const char*> category{nullptr};
+  std::atomic<uint64_t> start{0};
+  std::atomic<uint64_t> end{0};
+};
+
+struct TraceRecord {
+  const char* name;
+  const char* category;
+  uint64_t start;
+  uint64_t end;
+  int tid;
+};
+
+// A single-producer ring buffer of spans.
+class TraceBuffer {
+ public:
+  // capacity must be a power of two.
+  TraceBuffer(std::size_t capacity, int tid, std::thread::id thread)
+      : events_(capacity), mask_(capacity - 1), tid_(tid), thread_(thread) {}
+
+  int tid() const { return tid_; }
+  std::thread::id thread() const { return thread_; }
+
+  // Only called by the thread owning the buffer.
+  void Append(const char* name, const char* category, uint64_t start,
+              uint64_t end) {
+    uint64_t index = head_.load(std::memory_order_relaxed);
+    TraceEvent& event = events_[index & mask_];
+    event.name.store(name, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    head_.store(index + 1, std::memory_order_release);
+  }
+
+  // Appends the spans recorded after the last Clear() and not overwritten.
+  void SnapshotTo(std::vector<TraceRecord>& out) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(first_, head > events_.size()
+                                          ? head - events_.size()
+                                          : uint64_t{0});
+    std::size_t out_begin = out.size();
+    for (uint64_t i = begin; i < head; ++i) {
+      const TraceEvent& event = events_[i & mask_];
+      out.push_back({event.name.load(std::memory_order_relaxed),
+                     event.category.load(std::memory_order_relaxed),
+                     event.start.load(std::memory_order_relaxed),
+                     event.end.load(std::memory_order_relaxed), tid_});
+    }
+    // Discard the slots that the thread may have overwritten during the copy,
+    // including the one of the append in progress (index head_after).
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t head_after = head_.load(std::memory_order_relaxed);
+    if (head_after + 1 > events_.size() + begin) {
+      auto overwritten = std::min<uint64_t>(
+          head_after + 1 - events_.size() - begin, head - begin);
+      out.erase(out.begin() + static_cast<std::ptrdiff_t>(out_begin),
+                out.begin() + static_cast<std::ptrdiff_t>(out_begin +
+                                                          overwritten));
+    }
+  }
+
+  // Called by readers only.
+  void Clear() { first_ = head_.load(std::memory_order_acquire); }
+
+  // The number of ThreadTraceBuffer objects (one per extension module) of the
+  // thread that use the buffer. 0 once the thread exited. Guarded by the
+  // registry mutex.
+  int users = 0;
+
+ private:
+  std::vector<TraceEvent> events_;
+  const uint64_t mask_;
+  const int tid_;
+  const std::thread::id thread_;
+  std::atomic<uint64_t> head_{0};
+  // The first index not cleared. Guarded by the registry mutex.
+  uint64_t first_ = 0;
+};
+
+struct TraceRegistry {
+  std::atomic<bool> enabled{false};
+  std::atomic<std::size_t> events_per_thread{std::size_t{1} << 14};
+
+  std::mutex mu;
+  // At most one buffer per live thread, see ThreadTraceBuffer.
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+  int next_tid = 1;
+  // Interned span names, see InternTraceName().
+  std::deque<std::string> names;
+  TickCalibration calibration;
+};
+
+// Shared by all the extension modules of the process (through the pybind11
+// internals), and never destroyed. The first call requires the GIL.
+inline TraceRegistry& GetTraceRegistry() {
+  static TraceRegistry* registry =
+      &detail::get_or_create_shared_data<TraceRegistry>(
+          "_pybind11_abseil_boundary_tracer_v1");
+  return *registry;
+}
+
+// Returns a pointer to a copy of name that lives as long as the process.
+inline const char* InternTraceName(TraceRegistry& registry,
+                                   const std::string& name) {
+  std::lock_guard<std::mutex> lock(registry.mu);
+  auto it = std::find(registry.names.begin(), registry.names.end(), name);
+  if (it != registry.names.end()) return it->c_str();
+  registry.names.push_back(name);
+  return registry.names.back().c_str();
+}
+
+// The buffer of the current thread, cached by an extension module. Extension
+// modules are built with hidden visibility, so each has its own thread_local
+// ThreadTraceBuffer: they find the buffer of the thread in the registry, by
+// thread id.
+class ThreadTraceBuffer {
+ public:
+  ThreadTraceBuffer() = default;
+  ThreadTraceBuffer(const ThreadTraceBuffer&) = delete;
+  ThreadTraceBuffer& operator=(const ThreadTraceBuffer&) = delete;
+
+  // The registry keeps the buffer, so that the spans of exited threads can
+  // still be exported, until ClearBoundaryTrace().
+  ~ThreadTraceBuffer() {
+    if (buffer_ == nullptr) return;
+    std::lock_guard<std::mutex> lock(registry_->mu);
+    --buffer_->users;
+  }
+
+  TraceBuffer& Get(TraceRegistry& registry) {
+    if (buffer_ != nullptr) return *buffer_;
+    std::thread::id thread = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(registry.mu);
+    // The buffers of exited threads have no users, even if a new thread
+    // reuses their id.
+    for (const auto& buffer : registry.buffers) {
+      if (buffer->thread() == thread && buffer->users > 0) {
+        buffer_ = buffer.get();
+        break;
+      }
+    }
+    if (buffer_ == nullptr) {
+      // Round up to a power of two.
+      std::size_t capacity = 1;
+      while (capacity <
+             registry.events_per_thread.load(std::memory_order_relaxed)) {
+        capacity <<= 1;
+      }
+      registry.buffers.push_back(std::make_unique<TraceBuffer>(
+          capacity, registry.next_tid++, thread));
+      buffer_ = registry.buffers.back().get();
+    }
+    ++buffer_->users;
+    registry_ = &registry;
+    return *buffer_;
+  }
+
+ private:
+  TraceRegistry* registry_ = nullptr;
+  TraceBuffer* buffer_ = nullptr;
+};
+
+// Does not require the GIL.
+inline void AppendTraceEvent(TraceRegistry& registry, const char* name,
+                             const char* category, uint64_t start,
+                             uint64_t end) {
+  if (!registry.enabled.load(std::memory_order_relaxed)) return;
+  static thread_local ThreadTraceBuffer buffer;
+  buffer.Get(registry).Append(name, category, start, end);
+}
+
+// Records a span from construction to End() (or destruction). name and
+// category must be string literals or interned names. End() requires the GIL,
+// unless the registry was already obtained by the caller's extension module.
+class TraceSpan {
+ public:
+  TraceSpan(const char* name, const char* category)
+      : name_(name), category_(category), start_(CpuTicks()) {}
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+  ~TraceSpan() { End(); }
+
+  void End() {
+    if (ended_) return;
+    ended_ = true;
+    AppendTraceEvent(GetTraceRegistry(), name_, category_, start_, CpuTicks());
+  }
+
+ private:
+  const char* name_;
+  const char* category_;
+  uint64_t start_;
+  bool ended_ = false;
+};
+
+inline void AppendJsonString(std::string& out, const char* text) {
+  out += '"';
+  for (const char* c = text; *c != '\0'; ++c) {
+    switch (*c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                        static_cast<unsigned>(static_cast<unsigned char>(*c)));
+          out += escaped;
+        } else {
+          out += *c;
+        }
+    }
+  }
+  out += '"';
+}
+
+}  // namespace internal
+
+// Starts recording spans. Buffers created from now on hold events_per_thread
+// spans (rounded up to a power of two). Requires the GIL.
+inline void StartBoundaryTracing(std::size_t events_per_thread = 1 << 14) {
+  auto& registry = internal::GetTraceRegistry();
+  registry.events_per_thread.store(std::max<std::size_t>(events_per_thread, 1),
+                                   std::memory_order_relaxed);
+  registry.enabled.store(true, std::memory_order_relaxed);
+}
+
+// Stops recording spans. The recorded spans are kept. Requires the GIL.
+inline void StopBoundaryTracing() {
+  internal::GetTraceRegistry().enabled.store(false, std::memory_order_relaxed);
+}
+
+inline bool BoundaryTracingEnabled() {
+  return internal::GetTraceRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+// Discards the recorded spans, and the buffers of the threads that exited.
+// Requires the GIL.
+inline void ClearBoundaryTrace() {
+  auto& registry = internal::GetTraceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  for (auto& buffer : registry.buffers) buffer->Clear();
+  registry.buffers.erase(
+      std::remove_if(registry.buffers.begin(), registry.buffers.end(),
+                     [](const std::unique_ptr<internal::TraceBuffer>& b) {
+                       return b->users == 0;
+                     }),
+      registry.buffers.end());
+}
+
+// Returns the recorded spans in the Chrome trace event format, as complete
+// ("X") events with timestamps in microseconds. Requires the GIL.
+inline std::string BoundaryTraceToChromeJson() {
+  auto& registry = internal::GetTraceRegistry();
+  std::vector<internal::TraceRecord> records;
+  std::vector<int> tids;
+  {
+    std::lock_guard<std::mutex> lock(registry.mu);
+    for (const auto& buffer : registry.buffers) {
+      buffer->SnapshotTo(records);
+      tids.push_back(buffer->tid());
+    }
+  }
+  double nanos_per_tick = registry.calibration.NanosPerTick();
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  char number[64];
+  bool first = true;
+  for (int tid : tids) {
+    std::snprintf(number, sizeof(number), "%d", tid);
+    out += first ? "" : ",";
+    first = false;
+    out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":";
+    out += number;
+    out += ",\"args\":{\"name\":\"thread ";
+    out += number;
+    out += "\"}}";
+  }
+  for (const internal::TraceRecord& record : records) {
+    if (record.name == nullptr || record.category == nullptr) continue;
+    out += first ? "{" : ",{";
+    first = false;
+    out += "\"ph\":\"X\",\"name\":";
+    internal::AppendJsonString(out, record.name);
+    out += ",\"cat\":";
+    internal::AppendJsonString(out, record.category);
+    std::snprintf(
+        number, sizeof(number),
+        ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+        registry.calibration.NanosSinceStart(record.start, nanos_per_tick) /
+            1000.0,
+        static_cast<double>(record.end - record.start) * nanos_per_tick /
+            1000.0,
+        record.tid);
+    out += number;
+    out += "}";
+  }
+  out += "]}";
+  return out;
+}
+
+}  // namespace google
+}  // namespace pybind11
+
+#if defined(PYBIND11_ABSEIL_ENABLE_BOUNDARY_TRACER)
+#define PYBIND11_ABSEIL_TRACE_SPAN(var, name, category) \
+  ::pybind11::google::internal::TraceSpan var(name, category)
+#define PYBIND11_ABSEIL_TRACE_SPAN_END(var) var.End()
+#else
+// The arguments are not evaluated.
+#define PYBIND11_ABSEIL_TRACE_SPAN(var, name, category) static_cast<void>(0)
+#define PYBIND11_ABSEIL_TRACE_SPAN_END(var) static_cast<void>(0)
+#endif
+
+#endif  // PYBIND11_ABSEIL_BOUNDARY_TRACER_H_
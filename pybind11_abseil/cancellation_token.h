@@ -0,0 +1,376 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Cooperative cancellation of C++ calls running with the GIL released.
+//
+// Python cannot interrupt such a call: KeyboardInterrupt is only raised once it
+// returns, and PyErr_CheckSignals() requires the GIL. A binding opts in by
+// taking a CancellationToken, which C++ code polls between units of work:
+//
+//   m.def(
+//       "process",
+//       [](const Batch& batch, google::CancellationToken token)
+//           -> absl::Status {
+//         for (const Item& item : batch.items()) {
+//           if (token.cancelled()) return token.status();
+//           Process(item);
+//         }
+//         return absl::OkStatus();
+//       },
+//       arg("batch"), arg("timeout") = none(),
+//       call_guard<gil_scoped_release>());
+//
+// From python, the token is loaded from None, a timeout (absl::Duration, e.g.
+// a datetime.timedelta) or a deadline (absl::Time, a datetime.datetime):
+//
+//   records.process(batch, timeout=datetime.timedelta(seconds=30))
+//
+// The token is cancelled when SIGINT is received (Ctrl-C; POSIX only) and at
+// the deadline. status() is then a CancelledError or a DeadlineExceededError,
+// raised as StatusNotOk by the status casters. After SIGINT, python handles the
+// signal as usual (KeyboardInterrupt) once the call returned.
+//
+// cancelled() is two relaxed atomic loads: it can be polled in inner loops. The
+// deadlines are watched by a single background thread, shared by all the
+// tokens of the process (and restarted in a child process after fork(), by the
+// first token with a deadline).
+//
+// The SIGINT handler is installed by the first token watching SIGINT, and stays
+// installed: it forwards the signal to the handler it replaced (normally
+// python's), so later tokens are created without system calls. A handler
+// installed afterwards with signal.signal() replaces it, and the tokens then no
+// longer see SIGINT.
+
+#ifndef PYBIND11_ABSEIL_CANCELLATION_TOKEN_H_
+#define PYBIND11_ABSEIL_CANCELLATION_TOKEN_H_
+
+#include <pybind11/pybind11.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "pybind11_abseil/absl_casters.h"
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+enum class CancellationReason : int {
+  kNone,
+  kCancelled,
+  kInterrupted,
+  kDeadlineExceeded,
+};
+
+class CancellationTokenState;
+
+// Watches SIGINT and the deadlines of the tokens.
+struct CancellationRegistry {
+  // Incremented by the SIGINT handler (async-signal-safe).
+  std::atomic<int> sigint_count{0};
+  // Whether HandleSigint() (of one of the extension modules) is installed.
+  std::atomic<bool> sigint_installed{false};
+
+  // Held across fork() (see RegisterCancellationForkHandlers()).
+  std::mutex mu;
+#if !defined(_WIN32)
+  // The handler replaced by HandleSigint(), called by it. Set once, before
+  // sigint_installed.
+  struct sigaction previous_sigint;
+#endif
+  // The deadlines of the live tokens, earliest first.
+  std::set<std::pair<absl::Time, CancellationTokenState*>> deadlines;
+  std::condition_variable deadlines_changed;
+  // Whether the deadline watcher thread runs in this process.
+  bool deadline_watcher_started = false;
+  // Whether the fork handlers are registered. Requires the GIL.
+  bool fork_handlers_registered = false;
+};
+
+inline CancellationRegistry& GetCancellationRegistry();
+
+#if !defined(_WIN32)
+inline void LockCancellationRegistryBeforeFork() {
+  GetCancellationRegistry().mu.lock();
+}
+
+inline void UnlockCancellationRegistryAfterFork() {
+  GetCancellationRegistry().mu.unlock();
+}
+
+// The child only has the thread that called fork(): the deadline watcher is
+// gone (the next token with a deadline starts a new one), but
+// deadlines_changed may still count it as a waiter.
+inline void ResetCancellationRegistryInChild() {
+  CancellationRegistry& registry = GetCancellationRegistry();
+  new (&registry.deadlines_changed) std::condition_variable();
+  registry.deadline_watcher_started = false;
+  registry.mu.unlock();
+}
+#endif
+
+// Makes fork() take mu, so that the child does not inherit it locked by a
+// thread that does not exist there, and resets the deadline watcher in the
+// child. Once per process. Requires the GIL.
+inline void RegisterCancellationForkHandlers(CancellationRegistry& registry) {
+#if !defined(_WIN32)
+  if (registry.fork_handlers_registered) return;
+  registry.fork_handlers_registered = true;
+  pthread_atfork(&LockCancellationRegistryBeforeFork,
+                 &UnlockCancellationRegistryAfterFork,
+                 &ResetCancellationRegistryInChild);
+#else
+  static_cast<void>(registry);
+#endif
+}
+
+// Shared by all the extension modules of the process (through the pybind11
+// internals), and never destroyed, so that the deadline watcher thread can
+// outlive the interpreter. The first call requires the GIL.
+inline CancellationRegistry& GetCancellationRegistry() {
+  static CancellationRegistry* registry = [] {
+    auto* shared = &detail::get_or_create_shared_data<CancellationRegistry>(
+        "_pybind11_abseil_cancellation_v1");
+    RegisterCancellationForkHandlers(*shared);
+    return shared;
+  }();
+  return *registry;
+}
+
+#if !defined(_WIN32)
+inline void HandleSigint(int signum, siginfo_t* info, void* context) {
+  CancellationRegistry& registry = GetCancellationRegistry();
+  registry.sigint_count.fetch_add(1, std::memory_order_relaxed);
+  const struct sigaction& previous = registry.previous_sigint;
+  if (previous.sa_flags & SA_SIGINFO) {
+    previous.sa_sigaction(signum, info, context);
+  } else {
+    previous.sa_handler(signum);
+  }
+}
+#endif
+
+// Installs HandleSigint() in front of the current SIGINT handler (normally
+// python's), unless it is installed already, or SIGINT is ignored or handled
+// by default. Returns whether it is installed: after the first success, this
+// is an atomic load.
+inline bool InstallSigintHandler(CancellationRegistry& registry) {
+#if defined(_WIN32)
+  static_cast<void>(registry);
+  return false;
+#else
+  if (registry.sigint_installed.load(std::memory_order_acquire)) return true;
+  std::lock_guard<std::mutex> lock(registry.mu);
+  if (registry.sigint_installed.load(std::memory_order_relaxed)) return true;
+  struct sigaction current;
+  if (sigaction(SIGINT, nullptr, &current) != 0) return false;
+  if (!(current.sa_flags & SA_SIGINFO) &&
+      (current.sa_handler == SIG_DFL || current.sa_handler == SIG_IGN)) {
+    return false;
+  }
+  registry.previous_sigint = current;
+  struct sigaction action = {};
+  action.sa_sigaction = &HandleSigint;
+  action.sa_flags = SA_SIGINFO | (current.sa_flags & SA_ONSTACK);
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGINT, &action, nullptr) != 0) return false;
+  registry.sigint_installed.store(true, std::memory_order_release);
+  return true;
+#endif
+}
+
+class CancellationTokenState {
+ public:
+  CancellationTokenState() = default;
+
+  // Watches SIGINT if interruptible, and deadline. Requires the GIL if it is
+  // the first to watch either.
+  CancellationTokenState(absl::Time deadline, bool interruptible)
+      : registry_(&GetCancellationRegistry()), deadline_(deadline) {
+    if (interruptible && InstallSigintHandler(*registry_)) {
+      watches_sigint_ = true;
+      sigint_count_ = registry_->sigint_count.load(std::memory_order_relaxed);
+    }
+    if (deadline_ != absl::InfiniteFuture()) AddDeadline();
+  }
+
+  CancellationTokenState(const CancellationTokenState&) = delete;
+  CancellationTokenState& operator=(const CancellationTokenState&) = delete;
+
+  ~CancellationTokenState() {
+    if (watches_deadline_) {
+      std::lock_guard<std::mutex> lock(registry_->mu);
+      registry_->deadlines.erase({deadline_, this});
+    }
+  }
+
+  CancellationReason reason() {
+    auto reason = reason_.load(std::memory_order_relaxed);
+    if (reason == CancellationReason::kNone && watches_sigint_ &&
+        registry_->sigint_count.load(std::memory_order_relaxed) !=
+            sigint_count_) {
+      Cancel(CancellationReason::kInterrupted);
+      reason = reason_.load(std::memory_order_relaxed);
+    }
+    return reason;
+  }
+
+  // The first reason wins.
+  void Cancel(CancellationReason reason) {
+    auto expected = CancellationReason::kNone;
+    reason_.compare_exchange_strong(expected, reason,
+                                    std::memory_order_relaxed);
+  }
+
+  absl::Time deadline() const { return deadline_; }
+
+ private:
+  void AddDeadline() {
+    if (absl::Now() >= deadline_) {
+      Cancel(CancellationReason::kDeadlineExceeded);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(registry_->mu);
+    registry_->deadlines.insert({deadline_, this});
+    watches_deadline_ = true;
+    if (!registry_->deadline_watcher_started) {
+      registry_->deadline_watcher_started = true;
+      std::thread(&WatchDeadlines, registry_).detach();
+    }
+    registry_->deadlines_changed.notify_one();
+  }
+
+  // The deadline watcher thread: cancels the tokens at their deadlines. Never
+  // returns.
+  static void WatchDeadlines(CancellationRegistry* registry) {
+    std::unique_lock<std::mutex> lock(registry->mu);
+    while (true) {
+      if (registry->deadlines.empty()) {
+        registry->deadlines_changed.wait(lock);
+        continue;
+      }
+      auto first = registry->deadlines.begin();
+      absl::Time now = absl::Now();
+      if (first->first <= now) {
+        first->second->Cancel(CancellationReason::kDeadlineExceeded);
+        registry->deadlines.erase(first);
+        continue;
+      }
+      registry->deadlines_changed.wait_for(
+          lock, absl::ToChronoNanoseconds(first->first - now));
+    }
+  }
+
+  CancellationRegistry* registry_ = nullptr;
+  absl::Time deadline_ = absl::InfiniteFuture();
+  // Whether this is in registry_->deadlines.
+  bool watches_deadline_ = false;
+  bool watches_sigint_ = false;
+  int sigint_count_ = 0;
+  std::atomic<CancellationReason> reason_{CancellationReason::kNone};
+};
+
+}  // namespace internal
+
+// A flag set by Cancel(), SIGINT or a deadline, polled by C++ code (see
+// above). Copies share the flag. Thread-safe.
+class CancellationToken {
+ public:
+  // A token cancelled by Cancel() only.
+  CancellationToken()
+      : state_(std::make_shared<internal::CancellationTokenState>()) {}
+
+  // A token also cancelled at deadline, and when SIGINT is received if
+  // interruptible. Requires the GIL the first time a token watches either.
+  explicit CancellationToken(absl::Time deadline, bool interruptible = true)
+      : state_(std::make_shared<internal::CancellationTokenState>(
+            deadline, interruptible)) {}
+
+  // Whether the token was cancelled. Cheap enough for inner loops.
+  bool cancelled() const {
+    return state_->reason() != internal::CancellationReason::kNone;
+  }
+
+  // OK if not cancelled, else a CancelledError or (at the deadline) a
+  // DeadlineExceededError.
+  absl::Status status() const {
+    switch (state_->reason()) {
+      case internal::CancellationReason::kNone:
+        return absl::OkStatus();
+      case internal::CancellationReason::kCancelled:
+        return absl::CancelledError("Cancelled.");
+      case internal::CancellationReason::kInterrupted:
+        return absl::CancelledError("Interrupted by SIGINT.");
+      case internal::CancellationReason::kDeadlineExceeded:
+        return absl::DeadlineExceededError("Deadline exceeded.");
+    }
+    return absl::OkStatus();
+  }
+
+  void Cancel() const {
+    state_->Cancel(internal::CancellationReason::kCancelled);
+  }
+
+  // InfiniteFuture if there is none.
+  absl::Time deadline() const { return state_->deadline(); }
+
+ private:
+  std::shared_ptr<internal::CancellationTokenState> state_;
+};
+
+}  // namespace google
+
+namespace detail {
+
+// Loads an interruptible CancellationToken from None (no deadline), an
+// absl::Time (the deadline) or an absl::Duration (the timeout, from now).
+template <>
+struct type_caster<google::CancellationToken> {
+  PYBIND11_TYPE_CASTER(
+      google::CancellationToken,
+      const_name("Optional[Union[") + make_caster<absl::Time>::name +
+          const_name(", ") + make_caster<absl::Duration>::name +
+          const_name("]]"));
+
+  bool load(handle src, bool convert) {
+    if (!src) return false;
+    if (src.is_none()) {
+      value = google::CancellationToken(absl::InfiniteFuture());
+      return true;
+    }
+    // Numbers are timeouts.
+    make_caster<absl::Time> deadline;
+    if (deadline.load(src, /*convert=*/false)) {
+      value = google::CancellationToken(cast_op<absl::Time>(deadline));
+      return true;
+    }
+    make_caster<absl::Duration> timeout;
+    if (timeout.load(src, convert)) {
+      value = google::CancellationToken(absl::Now() +
+                                        cast_op<absl::Duration>(timeout));
+      return true;
+    }
+    return false;
+  }
+};
+
+}  // namespace detail
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_CANCELLATION_TOKEN_H_
@@ -0,0 +1,230 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Opt-in conversion counters for the pybind11_abseil casters.
+//
+// Compiled out unless PYBIND11_ABSEIL_ENABLE_CASTER_STATS is defined (Bazel:
+// --define=pybind11_abseil_caster_stats=1, CMake: -DENABLE_CASTER_STATS=ON).
+// When enabled, the casters record, per caster, the number of conversions,
+// fast path hits (e.g. a Span referencing a buffer), fallbacks (e.g. a Span
+// copied from a list), elements converted and bytes copied, plus the number of
+// StatusNotOk exceptions raised per absl::StatusCode. The absl::Status caster
+// also splits its fallbacks into loads from a capsule and loads through an
+// as_absl_Status() method.
+//
+// Each thread increments its own counters, without locks or read-modify-write
+// atomics. The counters of all threads and all extension modules of the process
+// are summed by SnapshotCasterStats(), which the pybind11_abseil.stats module
+// exposes to python.
+
+#ifndef PYBIND11_ABSEIL_CASTER_STATS_H_
+#define PYBIND11_ABSEIL_CASTER_STATS_H_
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace pybind11 {
+namespace google {
+
+enum class CasterId : int {
+  kSpan,
+  kCord,
+  kHashMap,
+  kHashSet,
+  // absl::btree_map and absl::btree_multimap.
+  kBtreeMap,
+  // absl::btree_set and absl::btree_multiset.
+  kBtreeSet,
+  // absl::InlinedVector and absl::FixedArray.
+  kArray,
+  kStatus,
+  kStatusOr,
+};
+
+enum class CasterStat : int {
+  kCalls,
+  kFastPath,
+  kFallback,
+  kElements,
+  kBytesCopied,
+  // The fallbacks that loaded a capsule, or called as_absl_Status().
+  kCapsule,
+  kAsAbslStatus,
+};
+
+constexpr int kNumCasterIds = static_cast<int>(CasterId::kStatusOr) + 1;
+constexpr int kNumCasterStats = static_cast<int>(CasterStat::kAsAbslStatus) + 1;
+// absl::StatusCode values are 0 to 16. The last slot counts all other codes.
+constexpr int kNumStatusNotOkSlots = 18;
+
+inline const char* CasterIdName(CasterId id) {
+  static constexpr const char* kNames[kNumCasterIds] = {
+      "span",      "cord",      "hash_map", "hash_set", "btree_map",
+      "btree_set", "array",     "status",   "statusor"};
+  return kNames[static_cast<int>(id)];
+}
+
+inline const char* CasterStatName(CasterStat stat) {
+  static constexpr const char* kNames[kNumCasterStats] = {
+      "calls",        "fast_path", "fallback",      "elements",
+      "bytes_copied", "capsule",   "as_absl_status"};
+  return kNames[static_cast<int>(stat)];
+}
+
+// The counters summed over all threads since the last ResetCasterStats().
+struct CasterStatsSnapshot {
+  uint64_t get(CasterId id, CasterStat stat) const {
+    return counts[static_cast<int>(id)][static_cast<int>(stat)];
+  }
+
+  std::array<std::array<uint64_t, kNumCasterStats>, kNumCasterIds> counts{};
+  // Indexed by absl::StatusCode, see kNumStatusNotOkSlots.
+  std::array<uint64_t, kNumStatusNotOkSlots> status_not_ok{};
+};
+
+namespace internal {
+
+// The counters of one thread. Only that thread writes them; the atomics only
+// make the concurrent reads in SnapshotCasterStats() well defined.
+struct CasterStatsBlock {
+  static void Add(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  void AddTo(CasterStatsSnapshot& out) const {
+    for (int i = 0; i < kNumCasterIds; ++i) {
+      for (int j = 0; j < kNumCasterStats; ++j) {
+        out.counts[i][j] += counts[i][j].load(std::memory_order_relaxed);
+      }
+    }
+    for (int i = 0; i < kNumStatusNotOkSlots; ++i) {
+      out.status_not_ok[i] += status_not_ok[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  std::array<std::array<std::atomic<uint64_t>, kNumCasterStats>, kNumCasterIds>
+      counts{};
+  std::array<std::atomic<uint64_t>, kNumStatusNotOkSlots> status_not_ok{};
+};
+
+struct CasterStatsRegistry {
+  // Sum of the live blocks and of retired, minus baseline.
+  CasterStatsSnapshot Snapshot() const {
+    CasterStatsSnapshot result = retired;
+    for (const CasterStatsBlock* block : live) block->AddTo(result);
+    for (int i = 0; i < kNumCasterIds; ++i) {
+      for (int j = 0; j < kNumCasterStats; ++j) {
+        result.counts[i][j] -= baseline.counts[i][j];
+      }
+    }
+    for (int i = 0; i < kNumStatusNotOkSlots; ++i) {
+      result.status_not_ok[i] -= baseline.status_not_ok[i];
+    }
+    return result;
+  }
+
+  std::mutex mu;
+  std::vector<const CasterStatsBlock*> live;
+  // The counters of the threads that exited.
+  CasterStatsSnapshot retired;
+  // The totals at the last reset. Resetting does not write the blocks, which
+  // belong to their threads.
+  CasterStatsSnapshot baseline;
+};
+
+// Shared by all the extension modules of the process (through the pybind11
+// internals), and never destroyed, so that threads exiting during interpreter
+// shutdown can still retire their counters. The first call requires the GIL.
+inline CasterStatsRegistry& GetCasterStatsRegistry() {
+  static CasterStatsRegistry* registry =
+      &detail::get_or_create_shared_data<CasterStatsRegistry>(
+          "_pybind11_abseil_caster_stats_v1");
+  return *registry;
+}
+
+class ThreadCasterStats {
+ public:
+  ThreadCasterStats() : registry_(GetCasterStatsRegistry()) {
+    std::lock_guard<std::mutex> lock(registry_.mu);
+    registry_.live.push_back(&block_);
+  }
+
+  ~ThreadCasterStats() {
+    std::lock_guard<std::mutex> lock(registry_.mu);
+    block_.AddTo(registry_.retired);
+    registry_.live.erase(
+        std::find(registry_.live.begin(), registry_.live.end(), &block_));
+  }
+
+  ThreadCasterStats(const ThreadCasterStats&) = delete;
+  ThreadCasterStats& operator=(const ThreadCasterStats&) = delete;
+
+  CasterStatsBlock& block() { return block_; }
+
+ private:
+  CasterStatsRegistry& registry_;
+  CasterStatsBlock block_;
+};
+
+inline CasterStatsBlock& ThisThreadCasterStats() {
+  static thread_local ThreadCasterStats stats;
+  return stats.block();
+}
+
+}  // namespace internal
+
+// Must be called with the GIL held, like the casters that use it.
+inline void RecordCasterStat(CasterId id, CasterStat stat, uint64_t n = 1) {
+  internal::CasterStatsBlock::Add(
+      internal::ThisThreadCasterStats()
+          .counts[static_cast<int>(id)][static_cast<int>(stat)],
+      n);
+}
+
+inline void RecordStatusNotOk(int code) {
+  int slot = code >= 0 && code < kNumStatusNotOkSlots - 1
+                 ? code
+                 : kNumStatusNotOkSlots - 1;
+  internal::CasterStatsBlock::Add(
+      internal::ThisThreadCasterStats().status_not_ok[slot], 1);
+}
+
+inline CasterStatsSnapshot SnapshotCasterStats() {
+  internal::CasterStatsRegistry& registry = internal::GetCasterStatsRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  return registry.Snapshot();
+}
+
+inline void ResetCasterStats() {
+  internal::CasterStatsRegistry& registry = internal::GetCasterStatsRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  registry.baseline = CasterStatsSnapshot();
+  registry.baseline = registry.Snapshot();
+}
+
+}  // namespace google
+}  // namespace pybind11
+
+#if defined(PYBIND11_ABSEIL_ENABLE_CASTER_STATS)
+#define PYBIND11_ABSEIL_CASTER_STAT(caster, stat, n)                        \
+  ::pybind11::google::RecordCasterStat(::pybind11::google::CasterId::caster, \
+                                       ::pybind11::google::CasterStat::stat, \
+                                       static_cast<uint64_t>(n))
+#define PYBIND11_ABSEIL_STATUS_NOT_OK_STAT(code) \
+  ::pybind11::google::RecordStatusNotOk(static_cast<int>(code))
+#else
+// The arguments are not evaluated.
+#define PYBIND11_ABSEIL_CASTER_STAT(caster, stat, n) static_cast<void>(0)
+#define PYBIND11_ABSEIL_STATUS_NOT_OK_STAT(code) static_cast<void>(0)
+#endif
+
+#endif  // PYBIND11_ABSEIL_CASTER_STATS_H_
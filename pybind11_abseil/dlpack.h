@@ -0,0 +1,543 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// DLPack (https://dmlc.github.io/dlpack/latest/python_spec.html) support for
+// absl::Span, without a build or runtime dependency on DLPack.
+//
+// Importing: the absl::Span caster (absl_casters.h) references the memory of
+// objects implementing __dlpack__ and __dlpack_device__ on the CPU, e.g. torch
+// and JAX CPU arrays, when no buffer can be obtained from them.
+//
+// Exporting: ToDLPack() returns an object implementing the protocol for the
+// memory of a span, e.g. for numpy.from_dlpack(obj) or torch.from_dlpack(obj):
+//
+//   m.def("weights", [](const Model& model, pybind11::handle self) {
+//     return pybind11::google::ToDLPack(model.Weights(), self);
+//   }, pybind11::arg("self"));
+//
+// The exported objects also implement the buffer protocol (Python >= 3.9), and
+// ToMemoryView() returns a memoryview of one.
+
+#ifndef PYBIND11_ABSEIL_DLPACK_H_
+#define PYBIND11_ABSEIL_DLPACK_H_
+
+#include <Python.h>
+#include <pybind11/pybind11.h>
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "absl/types/span.h"
+
+// The structs of DLPack 1.0, as in dlpack/dlpack.h.
+#ifndef DLPACK_DLPACK_H_
+#define DLPACK_DLPACK_H_
+
+#define DLPACK_MAJOR_VERSION 1
+#define DLPACK_MINOR_VERSION 0
+
+#define DLPACK_FLAG_BITMASK_READ_ONLY (1UL << 0UL)
+#define DLPACK_FLAG_BITMASK_IS_COPIED (1UL << 1UL)
+
+extern "C" {
+
+typedef struct {
+  uint32_t major;
+  uint32_t minor;
+} DLPackVersion;
+
+typedef enum {
+  kDLCPU = 1,
+  kDLCUDA = 2,
+  kDLCUDAHost = 3,
+  kDLOpenCL = 4,
+  kDLVulkan = 7,
+  kDLMetal = 8,
+  kDLVPI = 9,
+  kDLROCM = 10,
+  kDLROCMHost = 11,
+  kDLExtDev = 12,
+  kDLCUDAManaged = 13,
+  kDLOneAPI = 14,
+  kDLWebGPU = 15,
+  kDLHexagon = 16,
+  kDLMAIA = 17,
+} DLDeviceType;
+
+typedef struct {
+  DLDeviceType device_type;
+  int32_t device_id;
+} DLDevice;
+
+typedef enum {
+  kDLInt = 0U,
+  kDLUInt = 1U,
+  kDLFloat = 2U,
+  kDLOpaqueHandle = 3U,
+  kDLBfloat = 4U,
+  kDLComplex = 5U,
+  kDLBool = 6U,
+} DLDataTypeCode;
+
+typedef struct {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+} DLDataType;
+
+typedef struct {
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+} DLTensor;
+
+typedef struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(struct DLManagedTensor* self);
+} DLManagedTensor;
+
+typedef struct DLManagedTensorVersioned {
+  DLPackVersion version;
+  void* manager_ctx;
+  void (*deleter)(struct DLManagedTensorVersioned* self);
+  uint64_t flags;
+  DLTensor dl_tensor;
+} DLManagedTensorVersioned;
+
+}  // extern "C"
+
+#endif  // DLPACK_DLPACK_H_
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+template <typename T>
+constexpr bool IsDLPackCompatible() {
+  return std::is_arithmetic<T>::value ||
+         std::is_same<T, std::complex<float>>::value ||
+         std::is_same<T, std::complex<double>>::value;
+}
+
+// The DLPack type of T, one of the types accepted by IsDLPackCompatible().
+template <typename T>
+constexpr DLDataType DLPackDataType() {
+  return DLDataType{
+      static_cast<uint8_t>(std::is_same<T, bool>::value         ? kDLBool
+                           : std::is_floating_point<T>::value ? kDLFloat
+                           : !std::is_arithmetic<T>::value    ? kDLComplex
+                           : std::is_signed<T>::value         ? kDLInt
+                                                              : kDLUInt),
+      static_cast<uint8_t>(sizeof(T) * 8), 1};
+}
+
+// Keeps obj alive. Releasing the reference acquires the GIL: consumers of
+// exported memory may release it from any thread.
+inline std::shared_ptr<const void> PyObjectOwner(handle obj) {
+  return std::shared_ptr<const void>(obj.inc_ref().ptr(), [](PyObject* ptr) {
+    if (!Py_IsInitialized()) return;
+    PyGILState_STATE gil = PyGILState_Ensure();
+    Py_DECREF(ptr);
+    PyGILState_Release(gil);
+  });
+}
+
+// A tensor imported with src.__dlpack__(). The capsule owns the tensor: it is
+// not renamed to "used_dltensor", so the producer deletes the tensor when the
+// capsule is destroyed.
+struct DLPackImport {
+  object capsule;
+  const DLTensor* tensor = nullptr;
+  uint64_t flags = 0;
+};
+
+// Returns false (with the python error cleared) if src does not implement the
+// DLPack protocol, is not on the CPU, or fails to export a tensor.
+inline bool ImportDLPack(handle src, DLPackImport* imported) {
+  // Skips the attribute lookups for the common sequences.
+  if (PyList_CheckExact(src.ptr()) || PyTuple_CheckExact(src.ptr())) {
+    return false;
+  }
+  if (!hasattr(src, "__dlpack__") || !hasattr(src, "__dlpack_device__")) {
+    return false;
+  }
+  try {
+    tuple device = src.attr("__dlpack_device__")();
+    if (device.size() != 2 || device[0].cast<int>() != kDLCPU) return false;
+    object capsule;
+    try {
+      capsule = src.attr("__dlpack__")(arg("max_version") = make_tuple(
+                                           DLPACK_MAJOR_VERSION,
+                                           DLPACK_MINOR_VERSION));
+    } catch (error_already_set& e) {
+      // Producers implementing DLPack < 1.0 have no max_version parameter.
+      if (!e.matches(PyExc_TypeError)) throw;
+      capsule = src.attr("__dlpack__")();
+    }
+    if (PyCapsule_IsValid(capsule.ptr(), "dltensor_versioned")) {
+      auto* managed = static_cast<DLManagedTensorVersioned*>(
+          PyCapsule_GetPointer(capsule.ptr(), "dltensor_versioned"));
+      if (managed->version.major != DLPACK_MAJOR_VERSION) return false;
+      imported->tensor = &managed->dl_tensor;
+      imported->flags = managed->flags;
+    } else if (PyCapsule_IsValid(capsule.ptr(), "dltensor")) {
+      auto* managed = static_cast<DLManagedTensor*>(
+          PyCapsule_GetPointer(capsule.ptr(), "dltensor"));
+      imported->tensor = &managed->dl_tensor;
+      // Unversioned tensors cannot be flagged read-only: producers refuse to
+      // export read-only memory that way.
+      imported->flags = 0;
+    } else {
+      return false;
+    }
+    imported->capsule = std::move(capsule);
+    return true;
+  } catch (error_already_set&) {
+    return false;
+  } catch (cast_error&) {
+    return false;
+  }
+}
+
+// Returns {true, a span over the elements of the imported tensor} if it is a
+// 1-D contiguous CPU tensor of T, writable if T is not const. Otherwise returns
+// {false, an empty span}.
+template <typename T>
+std::tuple<bool, absl::Span<T>> SpanOfDLPack(const DLPackImport& imported) {
+  using value_type = std::remove_cv_t<T>;
+  const DLTensor& tensor = *imported.tensor;
+  constexpr DLDataType dtype = DLPackDataType<value_type>();
+  if (tensor.device.device_type != kDLCPU || tensor.ndim != 1 ||
+      tensor.dtype.code != dtype.code || tensor.dtype.bits != dtype.bits ||
+      tensor.dtype.lanes != dtype.lanes ||
+      (tensor.shape[0] > 1 && tensor.strides != nullptr &&
+       tensor.strides[0] != 1)) {
+    return {false, absl::Span<T>()};
+  }
+  // A copy would not see the writes through the span.
+  if (!std::is_const<T>::value &&
+      (imported.flags &
+       (DLPACK_FLAG_BITMASK_READ_ONLY | DLPACK_FLAG_BITMASK_IS_COPIED)) != 0) {
+    return {false, absl::Span<T>()};
+  }
+  char* data = static_cast<char*>(tensor.data) + tensor.byte_offset;
+  if (reinterpret_cast<std::uintptr_t>(data) % alignof(value_type) != 0) {
+    return {false, absl::Span<T>()};
+  }
+  return {true, absl::MakeSpan(reinterpret_cast<T*>(data),
+                               static_cast<std::size_t>(tensor.shape[0]))};
+}
+
+// What ToDLPack() exports. Immutable: shared by all the tensors exported from
+// it.
+struct DLPackExportState {
+  void* data = nullptr;
+  int64_t length = 0;
+  DLDataType dtype = {};
+  bool read_only = false;
+  std::shared_ptr<const void> owner;
+  // The shape (in items) and strides (in bytes) of the exported Py_buffers.
+  Py_ssize_t buffer_shape[1] = {0};
+  Py_ssize_t buffer_strides[1] = {0};
+};
+
+using DLPackExportStatePtr = std::shared_ptr<const DLPackExportState>;
+
+// The manager_ctx of an exported tensor.
+struct DLPackExportContext {
+  DLPackExportStatePtr state;
+  int64_t shape[1];
+  int64_t strides[1];
+};
+
+template <typename Managed>
+void DeleteDLPackExport(Managed* managed) {
+  delete static_cast<DLPackExportContext*>(managed->manager_ctx);
+  delete managed;
+}
+
+// Sets the tensor and context of managed from state.
+template <typename Managed>
+void FillDLPackExport(const DLPackExportStatePtr& state, Managed* managed) {
+  auto* context = new DLPackExportContext{state, {state->length}, {1}};
+  managed->manager_ctx = context;
+  managed->deleter = &DeleteDLPackExport<Managed>;
+  managed->dl_tensor = DLTensor{state->data,      DLDevice{kDLCPU, 0}, 1,
+                                state->dtype,     context->shape,
+                                context->strides, 0};
+}
+
+// Capsule destructors: delete the tensor unless a consumer renamed the capsule
+// to take ownership of it.
+template <typename Managed>
+void DeleteDLPackCapsule(PyObject* capsule, const char* name) {
+  if (!PyCapsule_IsValid(capsule, name)) return;
+  PyObject* type;
+  PyObject* value;
+  PyObject* traceback;
+  PyErr_Fetch(&type, &value, &traceback);
+  auto* managed = static_cast<Managed*>(PyCapsule_GetPointer(capsule, name));
+  managed->deleter(managed);
+  PyErr_Restore(type, value, traceback);
+}
+
+inline void DeleteDLTensorCapsule(PyObject* capsule) {
+  DeleteDLPackCapsule<DLManagedTensor>(capsule, "dltensor");
+}
+
+inline void DeleteDLTensorVersionedCapsule(PyObject* capsule) {
+  DeleteDLPackCapsule<DLManagedTensorVersioned>(capsule, "dltensor_versioned");
+}
+
+// Returns a new reference, or nullptr with a python error.
+inline PyObject* NewDLTensorCapsule(const DLPackExportStatePtr& state,
+                                    bool versioned) {
+  if (versioned) {
+    auto* managed = new DLManagedTensorVersioned();
+    managed->version = {DLPACK_MAJOR_VERSION, DLPACK_MINOR_VERSION};
+    managed->flags = state->read_only ? DLPACK_FLAG_BITMASK_READ_ONLY : 0;
+    FillDLPackExport(state, managed);
+    PyObject* capsule = PyCapsule_New(managed, "dltensor_versioned",
+                                      &DeleteDLTensorVersionedCapsule);
+    if (capsule == nullptr) managed->deleter(managed);
+    return capsule;
+  }
+  if (state->read_only) {
+    PyErr_SetString(PyExc_BufferError,
+                    "__dlpack__: a read-only array can only be exported with "
+                    "max_version >= (1, 0).");
+    return nullptr;
+  }
+  auto* managed = new DLManagedTensor();
+  FillDLPackExport(state, managed);
+  PyObject* capsule =
+      PyCapsule_New(managed, "dltensor", &DeleteDLTensorCapsule);
+  if (capsule == nullptr) managed->deleter(managed);
+  return capsule;
+}
+
+// The python objects returned by ToDLPack().
+struct DLPackExportObject {
+  PyObject_HEAD
+  DLPackExportStatePtr* state;
+};
+
+inline const DLPackExportStatePtr& DLPackExportStateOf(PyObject* self) {
+  return *reinterpret_cast<DLPackExportObject*>(self)->state;
+}
+
+inline PyObject* DLPackExportMethod(PyObject* self, PyObject* args,
+                                    PyObject* kwargs) {
+  static const char* keywords[] = {"stream", "max_version", "dl_device",
+                                   "copy", nullptr};
+  PyObject* stream = Py_None;
+  PyObject* max_version = Py_None;
+  PyObject* dl_device = Py_None;
+  PyObject* copy = Py_None;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|$OOOO:__dlpack__",
+                                   const_cast<char**>(keywords), &stream,
+                                   &max_version, &dl_device, &copy)) {
+    return nullptr;
+  }
+  if (stream != Py_None) {
+    PyErr_SetString(PyExc_ValueError,
+                    "__dlpack__: stream must be None for CPU arrays.");
+    return nullptr;
+  }
+  if (dl_device != Py_None) {
+    int device_type;
+    int device_id;
+    if (!PyArg_ParseTuple(dl_device, "ii:__dlpack__", &device_type,
+                          &device_id)) {
+      return nullptr;
+    }
+    if (device_type != kDLCPU) {
+      PyErr_SetString(PyExc_BufferError,
+                      "__dlpack__: only the CPU device is supported.");
+      return nullptr;
+    }
+  }
+  if (copy != Py_None) {
+    int copy_requested = PyObject_IsTrue(copy);
+    if (copy_requested < 0) return nullptr;
+    if (copy_requested) {
+      PyErr_SetString(PyExc_BufferError,
+                      "__dlpack__: copy=True is not supported.");
+      return nullptr;
+    }
+  }
+  bool versioned = false;
+  if (max_version != Py_None) {
+    int major;
+    int minor;
+    if (!PyArg_ParseTuple(max_version, "ii:__dlpack__", &major, &minor)) {
+      return nullptr;
+    }
+    versioned = major >= DLPACK_MAJOR_VERSION;
+  }
+  try {
+    return NewDLTensorCapsule(DLPackExportStateOf(self), versioned);
+  } catch (const std::bad_alloc&) {
+    return PyErr_NoMemory();
+  }
+}
+
+inline PyObject* DLPackDeviceMethod(PyObject*, PyObject*) {
+  return Py_BuildValue("(ii)", static_cast<int>(kDLCPU), 0);
+}
+
+inline Py_ssize_t DLPackExportLength(PyObject* self) {
+  return static_cast<Py_ssize_t>(DLPackExportStateOf(self)->length);
+}
+
+// The struct module format of the items of dtype, one of the types returned by
+// DLPackDataType().
+inline const char* BufferFormat(DLDataType dtype) {
+  switch (dtype.code) {
+    case kDLBool:
+      return "?";
+    case kDLFloat:
+      return dtype.bits == 16 ? "e" : dtype.bits == 32 ? "f"
+                                  : dtype.bits == 64   ? "d"
+                                                       : "g";
+    case kDLComplex:
+      return dtype.bits == 64 ? "Zf" : "Zd";
+    case kDLInt:
+      return dtype.bits == 8    ? "b"
+             : dtype.bits == 16 ? "h"
+             : dtype.bits == 32 ? "i"
+                                : "q";
+    default:
+      return dtype.bits == 8    ? "B"
+             : dtype.bits == 16 ? "H"
+             : dtype.bits == 32 ? "I"
+                                : "Q";
+  }
+}
+
+inline int DLPackExportGetBuffer(PyObject* self, Py_buffer* view, int flags) {
+  const DLPackExportState& state = *DLPackExportStateOf(self);
+  if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && state.read_only) {
+    view->obj = nullptr;
+    PyErr_SetString(PyExc_BufferError, "The array is read-only.");
+    return -1;
+  }
+  view->buf = state.data;
+  view->obj = self;
+  Py_INCREF(self);
+  view->itemsize = state.dtype.bits / 8;
+  view->len = state.buffer_shape[0] * view->itemsize;
+  view->readonly = state.read_only ? 1 : 0;
+  view->ndim = 1;
+  view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT
+                     ? const_cast<char*>(BufferFormat(state.dtype))
+                     : nullptr;
+  view->shape = (flags & PyBUF_ND) == PyBUF_ND
+                    ? const_cast<Py_ssize_t*>(state.buffer_shape)
+                    : nullptr;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES
+                      ? const_cast<Py_ssize_t*>(state.buffer_strides)
+                      : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = nullptr;
+  return 0;
+}
+
+inline void DLPackExportDealloc(PyObject* self) {
+  delete reinterpret_cast<DLPackExportObject*>(self)->state;
+  PyTypeObject* type = Py_TYPE(self);
+  type->tp_free(self);
+  Py_DECREF(type);
+}
+
+// The type of the objects returned by ToDLPack(), shared by all the extension
+// modules. Intentionally leaked.
+inline PyTypeObject* DLPackExportType() {
+  auto& type = detail::get_or_create_shared_data<PyTypeObject*>(
+      "_pybind11_abseil_dlpack_export_type_v1");
+  if (type != nullptr) return type;
+  static PyMethodDef methods[] = {
+      {"__dlpack__",
+       reinterpret_cast<PyCFunction>(
+           reinterpret_cast<void (*)()>(DLPackExportMethod)),
+       METH_VARARGS | METH_KEYWORDS,
+       "__dlpack__($self, /, *, stream=None, max_version=None, "
+       "dl_device=None, copy=None)\n--\n\n"},
+      {"__dlpack_device__", DLPackDeviceMethod, METH_NOARGS,
+       "__dlpack_device__($self, /)\n--\n\n"},
+      {nullptr, nullptr, 0, nullptr}};
+  static PyType_Slot slots[] = {
+      {Py_tp_dealloc, reinterpret_cast<void*>(DLPackExportDealloc)},
+      {Py_tp_methods, methods},
+      {Py_sq_length, reinterpret_cast<void*>(DLPackExportLength)},
+#if PY_VERSION_HEX >= 0x03090000
+      {Py_bf_getbuffer, reinterpret_cast<void*>(DLPackExportGetBuffer)},
+#endif
+      {Py_tp_doc, const_cast<char*>("A 1-D array exported with the DLPack "
+                                    "and buffer protocols.")},
+      {0, nullptr}};
+  static PyType_Spec spec = {"pybind11_abseil.DLPackExport",
+                             static_cast<int>(sizeof(DLPackExportObject)), 0,
+                             Py_TPFLAGS_DEFAULT, slots};
+  PyObject* created = PyType_FromSpec(&spec);
+  if (created == nullptr) throw error_already_set();
+  type = reinterpret_cast<PyTypeObject*>(created);
+  return type;
+}
+
+}  // namespace internal
+
+// Returns an object implementing the DLPack protocol (__dlpack__ and
+// __dlpack_device__) for the elements of values, without copying them: their
+// memory is owned by owner (e.g. the python object of the class owning the
+// span), which the exported tensors keep alive. Spans of const elements are
+// exported read-only, which requires consumers implementing DLPack >= 1.0.
+template <typename T>
+object ToDLPack(absl::Span<T> values, handle owner) {
+  using value_type = std::remove_cv_t<T>;
+  static_assert(internal::IsDLPackCompatible<value_type>(),
+                "Only spans of arithmetic and complex types are supported.");
+  auto state = std::make_shared<internal::DLPackExportState>();
+  state->data = const_cast<value_type*>(values.data());
+  state->length = static_cast<int64_t>(values.size());
+  state->dtype = internal::DLPackDataType<value_type>();
+  state->read_only = std::is_const<T>::value;
+  state->owner = internal::PyObjectOwner(owner);
+  state->buffer_shape[0] = static_cast<Py_ssize_t>(values.size());
+  state->buffer_strides[0] = static_cast<Py_ssize_t>(sizeof(value_type));
+  PyTypeObject* type = internal::DLPackExportType();
+  auto self = reinterpret_steal<object>(type->tp_alloc(type, 0));
+  if (!self) throw error_already_set();
+  reinterpret_cast<internal::DLPackExportObject*>(self.ptr())->state =
+      new internal::DLPackExportStatePtr(std::move(state));
+  return self;
+}
+
+// Returns a memoryview of the elements of values, without copying them, which
+// keeps owner alive like ToDLPack(). Spans of const elements are viewed
+// read-only. Requires Python >= 3.9.
+template <typename T>
+object ToMemoryView(absl::Span<T> values, handle owner) {
+  object exporter = ToDLPack(values, owner);
+  auto view =
+      reinterpret_steal<object>(PyMemoryView_FromObject(exporter.ptr()));
+  if (!view) throw error_already_set();
+  return view;
+}
+
+}  // namespace google
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_DLPACK_H_
@@ -0,0 +1,573 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Per-binding latency histograms.
+//
+// Wrapping a function with Instrumented() records, for each call, the time
+// spent converting the arguments from python, executing the C++ function and
+// converting the result (including raising StatusNotOk), and the absl::Status
+// code of the result:
+//
+//   m.def("lookup", pybind11::google::Instrumented("lookup", &Lookup),
+//         arg("key"));
+//   py::class_<Db>(m, "Db")
+//       .def("get", pybind11::google::Instrumented("Db.get", &Db::Get));
+//
+// The signature and argument conversions of the binding are unchanged.
+// Functions without arguments record no argument conversion phase. Each
+// thread records into its own shards (one per binding), without locks or
+// read-modify-write atomics; SnapshotBindingLatencies() merges the shards of
+// all threads and extension modules. The pybind11_abseil.stats module exposes
+// the snapshots to python.
+//
+// The histograms are HDR-style: 8 linear sub-buckets per power of two, so that
+// the relative error of a reported percentile is below 12.5%. Durations are
+// measured with the CPU timestamp counter where available, and converted to
+// nanoseconds when reading.
+//
+// While boundary tracing is started (see boundary_tracer.h), each phase of the
+// calls is also recorded as a span named after the binding.
+
+#ifndef PYBIND11_ABSEIL_INSTRUMENTED_BINDING_H_
+#define PYBIND11_ABSEIL_INSTRUMENTED_BINDING_H_
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "pybind11_abseil/boundary_tracer.h"
+#include "pybind11_abseil/no_throw_status.h"
+#include "pybind11_abseil/status_not_ok_exception.h"
+#include "pybind11_abseil/tick_clock.h"
+
+namespace pybind11 {
+namespace google {
+
+// The phases of a call: argument conversion, execution, result conversion.
+constexpr int kNumCallPhases = 3;
+
+// absl::StatusCode values are 0 to 16. Slot 17 counts the other codes, and slot
+// 18 the C++ exceptions other than StatusNotOk.
+constexpr int kNumCallOutcomeSlots = 19;
+constexpr int kOtherStatusCodeSlot = 17;
+constexpr int kCppExceptionSlot = 18;
+
+// A latency histogram, in ticks of internal::CpuTicks().
+struct LatencyHistogram {
+  static constexpr int kSubBucketBits = 3;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // Larger durations (more than an hour at 4 GHz) go to the last bucket.
+  static constexpr int kMaxExponent = 44;
+  static constexpr int kNumBuckets =
+      (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+  static int BucketIndex(uint64_t ticks) {
+    if (ticks < kSubBuckets) return static_cast<int>(ticks);
+    int exponent = 0;
+    for (uint64_t v = ticks >> 1; v != 0; v >>= 1) ++exponent;
+    if (exponent > kMaxExponent) return kNumBuckets - 1;
+    int sub = static_cast<int>(ticks >> (exponent - kSubBucketBits)) &
+              (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+  }
+
+  // The smallest number of ticks recorded in bucket index.
+  static uint64_t BucketLowerBound(int index) {
+    if (index < kSubBuckets) return static_cast<uint64_t>(index);
+    int exponent = index / kSubBuckets + kSubBucketBits - 1;
+    uint64_t sub = static_cast<uint64_t>(index % kSubBuckets);
+    return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+  }
+
+  uint64_t count() const {
+    uint64_t total = 0;
+    for (uint64_t n : buckets) total += n;
+    return total;
+  }
+
+  // The upper bound of the bucket holding the q-quantile (0 <= q <= 1), or 0
+  // if the histogram is empty.
+  uint64_t QuantileUpperBound(double q) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+    auto rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        return i + 1 < kNumBuckets ? BucketLowerBound(i + 1) - 1
+                                   : BucketLowerBound(i);
+      }
+    }
+    return BucketLowerBound(kNumBuckets - 1);
+  }
+
+  std::array<uint64_t, kNumBuckets> buckets{};
+  uint64_t sum_ticks = 0;
+};
+
+// The counters of one binding, summed over all threads.
+struct BindingLatencySnapshot {
+  std::string name;
+  uint64_t calls = 0;
+  // Indexed by absl::StatusCode, see kNumCallOutcomeSlots. Slot 0 (OK) is the
+  // number of successful calls.
+  std::array<uint64_t, kNumCallOutcomeSlots> outcomes{};
+  std::array<LatencyHistogram, kNumCallPhases> phases{};
+};
+
+namespace internal {
+
+inline void AddRelaxed(std::atomic<uint64_t>& counter, uint64_t n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+// The counters of one binding in one thread. Only that thread writes them; the
+// atomics only make the concurrent reads in Snapshot() well defined.
+struct LatencyShard {
+  // Skips the argument conversion phase unless has_args.
+  void Record(int outcome_slot, const uint64_t (&phase_ticks)[kNumCallPhases],
+              bool has_args) {
+    AddRelaxed(outcomes[outcome_slot], 1);
+    for (int i = has_args ? 0 : 1; i < kNumCallPhases; ++i) {
+      AddRelaxed(buckets[i][LatencyHistogram::BucketIndex(phase_ticks[i])], 1);
+      AddRelaxed(sum_ticks[i], phase_ticks[i]);
+    }
+  }
+
+  void AddTo(BindingLatencySnapshot& out) const {
+    for (int i = 0; i < kNumCallOutcomeSlots; ++i) {
+      uint64_t n = outcomes[i].load(std::memory_order_relaxed);
+      out.outcomes[i] += n;
+      out.calls += n;
+    }
+    for (int i = 0; i < kNumCallPhases; ++i) {
+      for (int j = 0; j < LatencyHistogram::kNumBuckets; ++j) {
+        out.phases[i].buckets[j] +=
+            buckets[i][j].load(std::memory_order_relaxed);
+      }
+      out.phases[i].sum_ticks += sum_ticks[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  std::array<std::atomic<uint64_t>, kNumCallOutcomeSlots> outcomes{};
+  std::array<std::array<std::atomic<uint64_t>, LatencyHistogram::kNumBuckets>,
+             kNumCallPhases>
+      buckets{};
+  std::array<std::atomic<uint64_t>, kNumCallPhases> sum_ticks{};
+};
+
+inline void Subtract(BindingLatencySnapshot& from,
+                     const BindingLatencySnapshot& other) {
+  from.calls -= other.calls;
+  for (int i = 0; i < kNumCallOutcomeSlots; ++i) {
+    from.outcomes[i] -= other.outcomes[i];
+  }
+  for (int i = 0; i < kNumCallPhases; ++i) {
+    for (int j = 0; j < LatencyHistogram::kNumBuckets; ++j) {
+      from.phases[i].buckets[j] -= other.phases[i].buckets[j];
+    }
+    from.phases[i].sum_ticks -= other.phases[i].sum_ticks;
+  }
+}
+
+inline void Add(BindingLatencySnapshot& to,
+                const BindingLatencySnapshot& other) {
+  to.calls += other.calls;
+  for (int i = 0; i < kNumCallOutcomeSlots; ++i) {
+    to.outcomes[i] += other.outcomes[i];
+  }
+  for (int i = 0; i < kNumCallPhases; ++i) {
+    for (int j = 0; j < LatencyHistogram::kNumBuckets; ++j) {
+      to.phases[i].buckets[j] += other.phases[i].buckets[j];
+    }
+    to.phases[i].sum_ticks += other.phases[i].sum_ticks;
+  }
+}
+
+struct LatencyRegistry {
+  // Returns the id of the binding called name, registering it if needed.
+  // Bindings registered with the same name share their counters.
+  int Register(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it != names.end()) return static_cast<int>(it - names.begin());
+    names.push_back(name);
+    live.emplace_back();
+    retired.emplace_back();
+    baseline.emplace_back();
+    return static_cast<int>(names.size()) - 1;
+  }
+
+  // Requires mu. Sum of the live shards and of retired, minus baseline.
+  BindingLatencySnapshot Snapshot(std::size_t id) const {
+    BindingLatencySnapshot result = retired[id];
+    result.name = names[id];
+    for (const LatencyShard* shard : live[id]) shard->AddTo(result);
+    Subtract(result, baseline[id]);
+    return result;
+  }
+
+  std::mutex mu;
+  // Indexed by binding id.
+  std::vector<std::string> names;
+  std::vector<std::vector<const LatencyShard*>> live;
+  // The counters of the threads that exited.
+  std::vector<BindingLatencySnapshot> retired;
+  // The totals at the last reset. Resetting does not write the shards, which
+  // belong to their threads.
+  std::vector<BindingLatencySnapshot> baseline;
+  TickCalibration calibration;
+};
+
+// Shared by all the extension modules of the process (through the pybind11
+// internals), and never destroyed. The first call requires the GIL.
+inline LatencyRegistry& GetLatencyRegistry() {
+  static LatencyRegistry* registry =
+      &detail::get_or_create_shared_data<LatencyRegistry>(
+          "_pybind11_abseil_latency_registry_v1");
+  return *registry;
+}
+
+// The shards of the current thread, indexed by binding id.
+class ThreadLatencyShards {
+ public:
+  ThreadLatencyShards() = default;
+  ThreadLatencyShards(const ThreadLatencyShards&) = delete;
+  ThreadLatencyShards& operator=(const ThreadLatencyShards&) = delete;
+
+  ~ThreadLatencyShards() {
+    if (registry_ == nullptr) return;
+    std::lock_guard<std::mutex> lock(registry_->mu);
+    for (std::size_t id = 0; id < shards_.size(); ++id) {
+      if (!shards_[id]) continue;
+      BindingLatencySnapshot counts;
+      shards_[id]->AddTo(counts);
+      Add(registry_->retired[id], counts);
+      auto& live = registry_->live[id];
+      live.erase(std::find(live.begin(), live.end(), shards_[id].get()));
+    }
+  }
+
+  LatencyShard& Get(LatencyRegistry& registry, int id) {
+    auto index = static_cast<std::size_t>(id);
+    if (index < shards_.size() && shards_[index]) return *shards_[index];
+    registry_ = &registry;
+    if (index >= shards_.size()) shards_.resize(index + 1);
+    shards_[index] = std::make_unique<LatencyShard>();
+    std::lock_guard<std::mutex> lock(registry.mu);
+    registry.live[index].push_back(shards_[index].get());
+    return *shards_[index];
+  }
+
+ private:
+  LatencyRegistry* registry_ = nullptr;
+  std::vector<std::unique_ptr<LatencyShard>> shards_;
+};
+
+inline LatencyShard& ThisThreadLatencyShard(LatencyRegistry& registry,
+                                            int id) {
+  static thread_local ThreadLatencyShards shards;
+  return shards.Get(registry, id);
+}
+
+inline int OutcomeSlot(const absl::Status& status) {
+  int code = status.raw_code();
+  return code >= 0 && code < kOtherStatusCodeSlot ? code
+                                                  : kOtherStatusCodeSlot;
+}
+
+// The outcome of a call returning a T. Only absl::Status, absl::StatusOr and
+// NoThrowStatus can fail without throwing.
+template <typename T>
+int ResultOutcomeSlot(const T&) {
+  return 0;
+}
+inline int ResultOutcomeSlot(const absl::Status& status) {
+  return OutcomeSlot(status);
+}
+template <typename T>
+int ResultOutcomeSlot(const absl::StatusOr<T>& statusor) {
+  return OutcomeSlot(statusor.status());
+}
+template <typename StatusType>
+int ResultOutcomeSlot(const NoThrowStatus<StatusType>& no_throw) {
+  return ResultOutcomeSlot(no_throw.status);
+}
+
+// Where the calls of a binding are recorded. Obtained with the GIL held, when
+// the binding is created.
+struct BindingRecorder {
+  LatencyRegistry* registry;
+  int id;
+  TraceRegistry* tracer;
+  // The binding name, interned by the tracer.
+  const char* trace_name;
+};
+
+inline BindingRecorder MakeBindingRecorder(const std::string& name) {
+  auto& registry = GetLatencyRegistry();
+  auto& tracer = GetTraceRegistry();
+  return {&registry, registry.Register(name), &tracer,
+          InternTraceName(tracer, name)};
+}
+
+// The state of a call between the execution of the function and the
+// conversion of its result.
+struct CallTicks {
+  BindingRecorder recorder;
+  // False for functions without arguments, which record no args phase.
+  bool has_args;
+  uint64_t args_start;
+  uint64_t exec_start;
+  int outcome_slot;
+
+  // Records the call, with the result converted at end (or the exception
+  // raised at end).
+  void Record(uint64_t exec_end, uint64_t end) const {
+    uint64_t phase_ticks[kNumCallPhases] = {exec_start - args_start,
+                                            exec_end - exec_start,
+                                            end - exec_end};
+    ThisThreadLatencyShard(*recorder.registry, recorder.id)
+        .Record(outcome_slot, phase_ticks, has_args);
+    // A span per phase, if boundary tracing is started.
+    if (has_args) {
+      AppendTraceEvent(*recorder.tracer, recorder.trace_name, "args",
+                       args_start, exec_start);
+    }
+    AppendTraceEvent(*recorder.tracer, recorder.trace_name, "exec", exec_start,
+                     exec_end);
+    AppendTraceEvent(*recorder.tracer, recorder.trace_name, "result", exec_end,
+                     end);
+  }
+};
+
+// The value returned by an instrumented binding. Its type_caster converts
+// value, then records the call and the status of value.
+template <typename Return>
+struct InstrumentedResult {
+  CallTicks ticks;
+  Return value;
+};
+
+template <>
+struct InstrumentedResult<void> {
+  CallTicks ticks;
+};
+
+// A function argument whose type_caster records when the conversion of the
+// arguments started (pybind11 converts them in order). The time is kept by the
+// caster of the call, so that the calls made while converting the arguments
+// (e.g. by __index__) and the overloads that failed to load do not affect it.
+template <typename T>
+struct ArgsStart {
+  T value;
+  uint64_t start_ticks;
+};
+
+template <typename Return>
+struct InstrumentedInvoker {
+  template <typename Func, typename... Args>
+  static InstrumentedResult<Return> Invoke(CallTicks ticks, Func& f,
+                                           Args&&... args) {
+    return {ticks, f(std::forward<Args>(args)...)};
+  }
+};
+
+template <>
+struct InstrumentedInvoker<void> {
+  template <typename Func, typename... Args>
+  static InstrumentedResult<void> Invoke(CallTicks ticks, Func& f,
+                                         Args&&... args) {
+    f(std::forward<Args>(args)...);
+    return {ticks};
+  }
+};
+
+template <typename Return, typename Func, typename... Args>
+InstrumentedResult<Return> InvokeAndRecordFailure(CallTicks ticks, Func& f,
+                                                  Args&&... args) {
+  try {
+    return InstrumentedInvoker<Return>::Invoke(ticks, f,
+                                               std::forward<Args>(args)...);
+  } catch (const StatusNotOk& e) {
+    ticks.outcome_slot = OutcomeSlot(e.status());
+    uint64_t now = CpuTicks();
+    ticks.Record(now, now);
+    throw;
+  } catch (...) {
+    ticks.outcome_slot = kCppExceptionSlot;
+    uint64_t now = CpuTicks();
+    ticks.Record(now, now);
+    throw;
+  }
+}
+
+template <typename Return, typename Func>
+auto MakeInstrumented(BindingRecorder recorder, Func&& f, Return (*)()) {
+  return [recorder, f = std::forward<Func>(f)]() mutable {
+    uint64_t now = CpuTicks();
+    return InvokeAndRecordFailure<Return>(
+        CallTicks{recorder, false, now, now, 0}, f);
+  };
+}
+
+template <typename Return, typename Func, typename Arg0, typename... Args>
+auto MakeInstrumented(BindingRecorder recorder, Func&& f,
+                      Return (*)(Arg0, Args...)) {
+  static_assert(!std::is_same<detail::intrinsic_t<Arg0>, args>::value &&
+                    !std::is_same<detail::intrinsic_t<Arg0>, kwargs>::value,
+                "Instrumented() does not support *args or **kwargs as the "
+                "first parameter.");
+  return [recorder, f = std::forward<Func>(f)](ArgsStart<Arg0> arg0,
+                                               Args... rest) mutable {
+    CallTicks ticks{recorder, true, arg0.start_ticks, CpuTicks(), 0};
+    return InvokeAndRecordFailure<Return>(ticks, f,
+                                          std::forward<Arg0>(arg0.value),
+                                          std::forward<Args>(rest)...);
+  };
+}
+
+}  // namespace internal
+
+// Returns a callable with the same signature as f, for cpp_function, m.def or
+// class_::def, that records the latency of each call under name. Must be
+// called with the GIL held.
+template <typename Return, typename... Args>
+auto Instrumented(const std::string& name, Return (*f)(Args...)) {
+  return internal::MakeInstrumented(internal::MakeBindingRecorder(name), f,
+                                    static_cast<Return (*)(Args...)>(nullptr));
+}
+
+template <typename Return, typename Class, typename... Args>
+auto Instrumented(const std::string& name, Return (Class::*f)(Args...)) {
+  return internal::MakeInstrumented(
+      internal::MakeBindingRecorder(name),
+      [f](Class* self, Args... args) -> Return {
+        return (self->*f)(std::forward<Args>(args)...);
+      },
+      static_cast<Return (*)(Class*, Args...)>(nullptr));
+}
+
+template <typename Return, typename Class, typename... Args>
+auto Instrumented(const std::string& name, Return (Class::*f)(Args...) const) {
+  return internal::MakeInstrumented(
+      internal::MakeBindingRecorder(name),
+      [f](const Class* self, Args... args) -> Return {
+        return (self->*f)(std::forward<Args>(args)...);
+      },
+      static_cast<Return (*)(const Class*, Args...)>(nullptr));
+}
+
+// Lambdas and other function objects with a non-overloaded operator().
+template <typename Func, typename Signature =
+                             detail::function_signature_t<std::decay_t<Func>>>
+auto Instrumented(const std::string& name, Func&& f) {
+  return internal::MakeInstrumented(internal::MakeBindingRecorder(name),
+                                    std::forward<Func>(f),
+                                    static_cast<Signature*>(nullptr));
+}
+
+// The latencies recorded since the last ResetBindingLatencies(), per binding,
+// in the order the bindings were registered.
+inline std::vector<BindingLatencySnapshot> SnapshotBindingLatencies() {
+  auto& registry = internal::GetLatencyRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  std::vector<BindingLatencySnapshot> result;
+  result.reserve(registry.names.size());
+  for (std::size_t id = 0; id < registry.names.size(); ++id) {
+    result.push_back(registry.Snapshot(id));
+  }
+  return result;
+}
+
+// The duration of a tick of LatencyHistogram, in nanoseconds.
+inline double LatencyNanosPerTick() {
+  return internal::GetLatencyRegistry().calibration.NanosPerTick();
+}
+
+inline void ResetBindingLatencies() {
+  auto& registry = internal::GetLatencyRegistry();
+  std::lock_guard<std::mutex> lock(registry.mu);
+  for (std::size_t id = 0; id < registry.names.size(); ++id) {
+    registry.baseline[id] = BindingLatencySnapshot();
+    registry.baseline[id] = registry.Snapshot(id);
+  }
+}
+
+}  // namespace google
+
+namespace detail {
+
+template <typename T>
+struct type_caster<google::internal::ArgsStart<T>> {
+  static constexpr auto name = make_caster<T>::name;
+
+  bool load(handle src, bool convert) {
+    start_ticks_ = google::internal::CpuTicks();
+    return inner_.load(src, convert);
+  }
+
+  template <typename>
+  using cast_op_type = google::internal::ArgsStart<T>;
+  operator google::internal::ArgsStart<T>() {
+    return {cast_op<T>(std::move(inner_)), start_ticks_};
+  }
+
+ private:
+  make_caster<T> inner_;
+  uint64_t start_ticks_ = 0;
+};
+
+template <typename Return>
+struct type_caster<google::internal::InstrumentedResult<Return>> {
+  static constexpr auto name = make_caster<Return>::name;
+
+  static handle cast(google::internal::InstrumentedResult<Return>&& src,
+                     return_value_policy policy, handle parent) {
+    uint64_t exec_end = google::internal::CpuTicks();
+    src.ticks.outcome_slot = google::internal::ResultOutcomeSlot(src.value);
+    handle result;
+    try {
+      result = make_caster<Return>::cast(
+          std::forward<Return>(src.value),
+          return_value_policy_override<Return>::policy(policy), parent);
+    } catch (...) {
+      src.ticks.Record(exec_end, google::internal::CpuTicks());
+      throw;
+    }
+    src.ticks.Record(exec_end, google::internal::CpuTicks());
+    return result;
+  }
+};
+
+template <>
+struct type_caster<google::internal::InstrumentedResult<void>> {
+  static constexpr auto name = const_name("None");
+
+  static handle cast(google::internal::InstrumentedResult<void>&& src,
+                     return_value_policy, handle) {
+    uint64_t now = google::internal::CpuTicks();
+    src.ticks.Record(now, now);
+    return none().release();
+  }
+};
+
+}  // namespace detail
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_INSTRUMENTED_BINDING_H_
@@ -0,0 +1,207 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// C++ sources of records pulled from python iterables.
+//
+// A PyBatchedSource<T> returns the items of a python iterable converted to T,
+// nullopt at the end of the iteration, or a non-ok status:
+//
+//   absl::StatusOr<absl::optional<T>> PyBatchedSource<T>::operator()();
+//
+// Unlike a std::function<absl::StatusOr<T>()> wrapping a python callable,
+// which acquires the GIL and converts the result once per item, the source
+// acquires the GIL once per batch of up to batch_size items: it pulls them
+// from the iterator and converts them all while holding it, and then returns
+// the converted items without touching python. An exception raised by the
+// iterator is returned as a status (see StatusFromPyExcGivenErrOccurred()) as
+// is a failed conversion (kInvalidArgument), after the items before it. Both
+// end the iteration.
+//
+// The source does not require the GIL, and is typically pulled with the GIL
+// released. It can be taken as an argument of a binding, from any iterable:
+//
+//   m.def(
+//       "write",
+//       [](RecordWriter& writer, google::PyBatchedSource<Record> records)
+//           -> absl::Status {
+//         while (true) {
+//           absl::StatusOr<absl::optional<Record>> record = records();
+//           if (!record.ok()) return record.status();
+//           if (!record->has_value()) return absl::OkStatus();
+//           absl::Status status = writer.Write(**record);
+//           if (!status.ok()) return status;
+//         }
+//       },
+//       call_guard<gil_scoped_release>());
+//
+// Copies share the iterator and the items pulled ahead. A source must not be
+// called by several threads at once.
+
+#ifndef PYBIND11_ABSEIL_PY_BATCHED_SOURCE_H_
+#define PYBIND11_ABSEIL_PY_BATCHED_SOURCE_H_
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "pybind11_abseil/boundary_tracer.h"
+#include "pybind11_abseil/compat/status_from_py_exc.h"
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+template <typename T>
+class PyBatchedSourceState {
+ public:
+  // Requires the GIL.
+  PyBatchedSourceState(object iterator, std::size_t batch_size)
+      : iterator_(std::move(iterator)),
+        batch_size_(std::max<std::size_t>(batch_size, 1)) {
+    buffer_.reserve(batch_size_);
+  }
+
+  PyBatchedSourceState(const PyBatchedSourceState&) = delete;
+  PyBatchedSourceState& operator=(const PyBatchedSourceState&) = delete;
+
+  // The items pulled ahead (e.g. python objects, if T is object) are
+  // destroyed with the iterator, with the GIL held.
+  ~PyBatchedSourceState() {
+    if (!iterator_ && buffer_.empty()) return;
+    if (!Py_IsInitialized()) {
+      // The iterator and the items cannot be released anymore.
+      iterator_.release();
+      static_cast<void>(new std::vector<T>(std::move(buffer_)));
+      return;
+    }
+    gil_scoped_acquire acquire;
+    iterator_ = object();
+    buffer_.clear();
+  }
+
+  absl::StatusOr<absl::optional<T>> Next() {
+    if (position_ == buffer_.size() && iterator_) Refill();
+    if (position_ < buffer_.size()) {
+      return absl::optional<T>(std::move(buffer_[position_++]));
+    }
+    if (!status_.ok()) {
+      absl::Status status = std::move(status_);
+      status_ = absl::OkStatus();
+      return status;
+    }
+    return absl::optional<T>();
+  }
+
+ private:
+  // Pulls and converts up to batch_size_ items, holding the GIL once. Releases
+  // the iterator at the end of the iteration.
+  void Refill() {
+    buffer_.clear();
+    position_ = 0;
+    PYBIND11_ABSEIL_TRACE_SPAN(gil_span, "gil_acquire", "py_batched_source");
+    gil_scoped_acquire acquire;
+    PYBIND11_ABSEIL_TRACE_SPAN_END(gil_span);
+    PYBIND11_ABSEIL_TRACE_SPAN(pull_span, "py_pull", "py_batched_source");
+    while (buffer_.size() < batch_size_) {
+      auto item = reinterpret_steal<object>(PyIter_Next(iterator_.ptr()));
+      if (!item) {
+        if (PyErr_Occurred()) {
+          status_ = pybind11_abseil::compat::StatusFromPyExcGivenErrOccurred();
+        }
+        iterator_ = object();
+        return;
+      }
+      try {
+        buffer_.push_back(item.template cast<T>());
+      } catch (cast_error& e) {
+        status_ = absl::InvalidArgumentError(e.what());
+        iterator_ = object();
+        return;
+      }
+      // See comment for the corresponding `catch` in status_caster.h.
+      catch (error_already_set& e) {
+        e.restore();
+        status_ = pybind11_abseil::compat::StatusFromPyExcGivenErrOccurred();
+        iterator_ = object();
+        return;
+      }
+    }
+  }
+
+  // Null at the end of the iteration.
+  object iterator_;
+  const std::size_t batch_size_;
+  // The items pulled ahead: buffer_[position_:]. Reused by every batch.
+  std::vector<T> buffer_;
+  std::size_t position_ = 0;
+  // The outcome of the iteration after buffer_.
+  absl::Status status_;
+};
+
+}  // namespace internal
+
+// A C++ source of the items of a python iterable (see above).
+template <typename T>
+class PyBatchedSource {
+ public:
+  static constexpr std::size_t kDefaultBatchSize = 256;
+
+  // An empty source.
+  PyBatchedSource() = default;
+
+  // Takes an iterator of iterable. Requires the GIL. Raises TypeError if
+  // iterable is not iterable.
+  explicit PyBatchedSource(handle iterable,
+                           std::size_t batch_size = kDefaultBatchSize)
+      : state_(std::make_shared<internal::PyBatchedSourceState<T>>(
+            iter(iterable), batch_size)) {}
+
+  // Returns the next item, nullopt at the end, or the status of the exception
+  // raised by the iterator or of the failed conversion. Acquires the GIL once
+  // every batch_size items.
+  absl::StatusOr<absl::optional<T>> operator()() {
+    if (!state_) return absl::optional<T>();
+    return state_->Next();
+  }
+
+ private:
+  std::shared_ptr<internal::PyBatchedSourceState<T>> state_;
+};
+
+}  // namespace google
+
+namespace detail {
+
+// Loads a PyBatchedSource with the default batch size from any iterable.
+template <typename T>
+struct type_caster<google::PyBatchedSource<T>> {
+  PYBIND11_TYPE_CASTER(google::PyBatchedSource<T>,
+                       const_name("Iterable[") + make_caster<T>::name +
+                           const_name("]"));
+
+  bool load(handle src, bool /*convert*/) {
+    if (!src) return false;
+    PyObject* iterator = PyObject_GetIter(src.ptr());
+    if (iterator == nullptr) {
+      PyErr_Clear();
+      return false;
+    }
+    value = google::PyBatchedSource<T>(
+        reinterpret_steal<object>(iterator));
+    return true;
+  }
+};
+
+}  // namespace detail
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_PY_BATCHED_SOURCE_H_
@@ -1,23 +1,31 @@
 #include "pybind11_abseil/register_status_bindings.h"
 
-#include <pybind11/embed.h>
+#include <Python.h>
 #include <pybind11/pybind11.h>
+#include <structmember.h>
 
 #include <cstddef>
+#include <cstring>
 #include <exception>
-#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "pybind11_abseil/absl_casters.h"
+#include "pybind11_abseil/boundary_tracer.h"
 #include "pybind11_abseil/cpp_capsule_tools/raw_ptr_from_capsule.h"
 #include "pybind11_abseil/init_from_tag.h"
 #include "pybind11_abseil/no_throw_status.h"
 #include "pybind11_abseil/ok_status_singleton_lib.h"
+#include "pybind11_abseil/status_accessors.h"
 #include "pybind11_abseil/status_caster.h"
 #include "pybind11_abseil/status_not_ok_exception.h"
 #include "pybind11_abseil/utils_pybind11_absl.h"
@@ -90,15 +98,38 @@ absl::Status WrapUnknownError(absl::string_view message) {
   return absl::UnknownError(message);
 }
 
-void def_status_factory(
-    module& m, const char* name,
-    absl::Status (*absl_status_factory)(absl::string_view message)) {
-  m.def(
-      name,
+struct StatusFactory {
+  const char* name;
+  absl::Status (*absl_status_factory)(absl::string_view message);
+};
+
+constexpr StatusFactory kStatusFactories[] = {
+    {"aborted_error", WrapAbortedError},
+    {"already_exists_error", WrapAlreadyExistsError},
+    {"cancelled_error", WrapCancelledError},
+    {"data_loss_error", WrapDataLossError},
+    {"deadline_exceeded_error", WrapDeadlineExceededError},
+    {"failed_precondition_error", WrapFailedPreconditionError},
+    {"internal_error", WrapInternalError},
+    {"invalid_argument_error", WrapInvalidArgumentError},
+    {"not_found_error", WrapNotFoundError},
+    {"out_of_range_error", WrapOutOfRangeError},
+    {"permission_denied_error", WrapPermissionDeniedError},
+    {"resource_exhausted_error", WrapResourceExhaustedError},
+    {"unauthenticated_error", WrapUnauthenticatedError},
+    {"unavailable_error", WrapUnavailableError},
+    {"unimplemented_error", WrapUnimplementedError},
+    {"unknown_error", WrapUnknownError},
+};
+
+cpp_function MakeStatusFactoryFunction(module m,
+                                       const StatusFactory& factory) {
+  auto absl_status_factory = factory.absl_status_factory;
+  return cpp_function(
       [absl_status_factory](absl::string_view message) {
         return DoNotThrowStatus(absl_status_factory(message));
       },
-      arg("message"));
+      pybind11::name(factory.name), scope(m), arg("message"));
 }
 
 absl::StatusOr<absl::Status*> StatusRawPtrFromCapsule(
@@ -108,12 +139,6 @@ absl::StatusOr<absl::Status*> StatusRawPtrFromCapsule(
       enable_as_capsule_method ? "as_absl_Status" : nullptr);
 }
 
-// https://stackoverflow.com/questions/2590677/how-do-i-combine-hash-values-in-c0x
-std::size_t boost_hash_combine(std::size_t lhs, std::size_t rhs) {
-  lhs ^= rhs + 0x9e3779b9 + (lhs << 6) + (lhs >> 2);
-  return lhs;
-}
-
 handle ThisModule(handle m = nullptr) {
   static handle this_module = nullptr;
   if (m) {
@@ -146,6 +171,650 @@ handle PyStatusNotOkTypeInUse() {
   type_in_use = object(module_in_use.attr("StatusNotOk")).release();
   return type_in_use;
 }
+
+std::string StatusNotOkStr(const absl::Status& s) {
+  std::string code_str = absl::StatusCodeToString(s.code());
+  if (code_str.empty()) {
+    // This code is meant to be unreachable, but we want to produce as much of
+    // the original error as possible even if this assumption is violated.
+    code_str = std::to_string(static_cast<int>(s.code()));
+  }
+  return absl::StrCat(s.message(), " [", code_str, "]");
+}
+
+// Returns the absl::Status wrapped by obj if obj is exactly a Status (not a
+// subclass, which could override the methods), else nullptr.
+const absl::Status* ExactStatus(handle obj) {
+  detail::type_caster_base<absl::Status> caster;
+  if (!caster.load(obj, /*convert=*/false) ||
+      Py_TYPE(obj.ptr()) != caster.typeinfo->type) {
+    return nullptr;
+  }
+  return static_cast<const absl::Status*>(caster.value);
+}
+
+// Equivalent to IsOk(), for the elements of the sequences passed to the batch
+// functions (ok_mask etc.): exact Status objects and builtin values are
+// classified without the type_caster (and its as_absl_Status() fallback).
+class StatusOrClassifier {
+ public:
+  StatusOrClassifier()
+      : status_type_(detail::get_type_info(typeid(absl::Status))->type) {}
+
+  bool ItemIsOk(handle item) const {
+    PyTypeObject* type = Py_TYPE(item.ptr());
+    if (type == status_type_) {
+      auto* status = static_cast<const absl::Status*>(
+          reinterpret_cast<detail::instance*>(item.ptr())
+              ->get_value_and_holder()
+              .value_ptr());
+      if (status != nullptr) return status->ok();
+    } else if (IsBuiltinValueType(type)) {
+      return true;
+    }
+    return IsOk(item);
+  }
+
+ private:
+  // Instances of these types are neither Status objects nor have an
+  // as_absl_Status() method.
+  static bool IsBuiltinValueType(PyTypeObject* type) {
+    return type == &PyLong_Type || type == &PyFloat_Type ||
+           type == &PyUnicode_Type || type == &PyBytes_Type ||
+           type == &PyBool_Type || type == Py_TYPE(Py_None) ||
+           type == &PyList_Type || type == &PyTuple_Type ||
+           type == &PyDict_Type;
+  }
+
+  PyTypeObject* status_type_;
+};
+
+// Calls fn(index, item, is_ok) for each element of seq, a list, tuple or other
+// iterable.
+template <typename Fn>
+void ForEachStatusOr(handle seq, Fn&& fn) {
+  auto items = reinterpret_steal<object>(
+      PySequence_Fast(seq.ptr(), "expected a sequence of StatusOr results"));
+  if (!items) throw error_already_set();
+  StatusOrClassifier classifier;
+  // Python code called by IsOk() may modify a list: the size and items are
+  // read again at each iteration.
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(items.ptr()); ++i) {
+    auto item =
+        reinterpret_borrow<object>(PySequence_Fast_GET_ITEM(items.ptr(), i));
+    fn(i, item, classifier.ItemIsOk(item));
+  }
+}
+
+bytes OkMask(handle seq) {
+  std::string mask;
+  ForEachStatusOr(seq, [&mask](Py_ssize_t, handle, bool is_ok) {
+    mask.push_back(is_ok ? 1 : 0);
+  });
+  return bytes(mask);
+}
+
+tuple Partition(handle seq) {
+  list values;
+  list indices;
+  list statuses;
+  ForEachStatusOr(seq, [&](Py_ssize_t i, handle item, bool is_ok) {
+    if (is_ok) {
+      values.append(item);
+    } else {
+      indices.append(int_(i));
+      statuses.append(item);
+    }
+  });
+  return make_tuple(values, indices, statuses);
+}
+
+// A StatusNotOk raised for the non-ok item.
+object StatusNotOkOf(handle item) {
+  if (isinstance<absl::Status>(item)) return PyStatusNotOkTypeInUse()(item);
+  // An object with an as_absl_Status() method.
+  detail::make_caster<absl::Status> caster;
+  if (!caster.load(item, true)) throw cast_error("not a Status");
+  return PyStatusNotOkTypeInUse()(google::NoThrowStatus<absl::Status>(
+      static_cast<absl::Status&>(caster)));
+}
+
+void RaiseIfAny(handle seq) {
+  list errors;
+  Py_ssize_t size = 0;
+  ForEachStatusOr(seq, [&](Py_ssize_t, handle item, bool is_ok) {
+    ++size;
+    if (!is_ok) errors.append(StatusNotOkOf(item));
+  });
+  if (errors.empty()) return;
+#if PY_VERSION_HEX >= 0x030B0000
+  // Returns an ExceptionGroup: all the errors are Exceptions.
+  object group = reinterpret_borrow<object>(PyExc_BaseExceptionGroup)(
+      absl::StrCat(len(errors), " of ", size, " results are not ok"), errors);
+  PyErr_SetObject(reinterpret_cast<PyObject*>(Py_TYPE(group.ptr())),
+                  group.ptr());
+#else
+  // No exception groups: raise the first error.
+  handle first = errors[0];
+  PyErr_SetObject(reinterpret_cast<PyObject*>(Py_TYPE(first.ptr())),
+                  first.ptr());
+#endif
+  throw error_already_set();
+}
+
+// Payloads smaller than this are copied: referencing them costs more
+// (allocations, and releasing them with the GIL). Also guarantees that the
+// referenced Cords are not inlined.
+constexpr std::size_t kMinExternalCordSize = 512;
+
+// A non-flat payload is pickled as one buffer per chunk only if its chunks are
+// at least this large on average, otherwise it is copied into a single buffer.
+constexpr std::size_t kMinPickleBufferChunkSize = 16 << 10;
+
+// A read-only buffer over bytes owned by a Status (its message) or by a Cord (a
+// payload or a chunk of it). Used for the out-of-band buffers of pickle
+// protocol 5. The bytes are shared by copies of the Status or Cord.
+struct StatusBytesView {
+  absl::string_view data;
+  absl::Status status_owner;
+  absl::Cord cord_owner;
+};
+
+// The iterator returned by Status.payloads(), creating the (type_url,
+// memoryview) pairs one at a time. It iterates over a copy of the status, which
+// shares (and keeps unmodified) the payloads referenced here.
+struct StatusPayloadIterator {
+  absl::Status status;
+  // In the order of ForEachPayload(), unspecified.
+  std::vector<std::pair<absl::string_view, const absl::Cord*>> payloads;
+  std::size_t position = 0;
+};
+
+object PickleBufferOf(handle exporter) {
+  auto buffer =
+      reinterpret_steal<object>(PyPickleBuffer_FromObject(exporter.ptr()));
+  if (!buffer) throw error_already_set();
+  return buffer;
+}
+
+object PickleBufferOf(StatusBytesView view) {
+  return PickleBufferOf(cast(std::move(view)));
+}
+
+// A single copy, unlike bytes(std::string(cord)).
+object CordToBytes(const absl::Cord& cord) {
+  auto result = reinterpret_steal<object>(PyBytes_FromStringAndSize(
+      nullptr, static_cast<Py_ssize_t>(cord.size())));
+  if (!result) throw error_already_set();
+  char* out = PyBytes_AS_STRING(result.ptr());
+  for (absl::string_view chunk : cord.Chunks()) {
+    std::memcpy(out, chunk.data(), chunk.size());
+    out += chunk.size();
+  }
+  return result;
+}
+
+// An object exporting the bytes of payload with the buffer protocol: a
+// _StatusBytesView if payload is large and flat, else a copy as bytes.
+object PayloadExporter(const absl::Cord& payload) {
+  if (payload.size() >= kMinExternalCordSize) {
+    absl::optional<absl::string_view> flat = payload.TryFlat();
+    if (flat) return cast(StatusBytesView{*flat, absl::Status(), payload});
+  }
+  return CordToBytes(payload);
+}
+
+object MemoryViewOf(handle exporter) {
+  auto view =
+      reinterpret_steal<object>(PyMemoryView_FromObject(exporter.ptr()));
+  if (!view) throw error_already_set();
+  return view;
+}
+
+// A PickleBuffer, or a list of PickleBuffers (one per chunk). Large flat
+// payloads and payloads with large chunks are not copied.
+object PayloadPickleBuffers(const absl::Cord& payload) {
+  if (payload.size() >= kMinExternalCordSize && !payload.TryFlat()) {
+    std::size_t num_chunks = 0;
+    for (absl::string_view chunk : payload.Chunks()) {
+      static_cast<void>(chunk);
+      ++num_chunks;
+    }
+    if (payload.size() >= num_chunks * kMinPickleBufferChunkSize) {
+      list chunks;
+      for (absl::string_view chunk : payload.Chunks()) {
+        chunks.append(PickleBufferOf({chunk, absl::Status(), payload}));
+      }
+      return std::move(chunks);
+    }
+  }
+  return PickleBufferOf(PayloadExporter(payload));
+}
+
+// The buffers referenced by Cords whose last reference was dropped by a thread
+// not holding the GIL, waiting to be released by ReleasePendingBuffers().
+struct PendingBufferReleases {
+  std::mutex mu;
+  std::vector<Py_buffer*> views;
+  // Whether ReleasePendingBuffers() is scheduled with Py_AddPendingCall().
+  bool scheduled = false;
+};
+
+// Never destroyed: Cords may be dropped during interpreter shutdown.
+PendingBufferReleases& GetPendingBufferReleases() {
+  static auto* pending = new PendingBufferReleases();
+  return *pending;
+}
+
+// A pending call: runs with the GIL held.
+int ReleasePendingBuffers(void*) {
+  std::vector<Py_buffer*> views;
+  {
+    PendingBufferReleases& pending = GetPendingBufferReleases();
+    std::lock_guard<std::mutex> lock(pending.mu);
+    views.swap(pending.views);
+    pending.scheduled = false;
+  }
+  for (Py_buffer* view : views) {
+    PyBuffer_Release(view);
+    delete view;
+  }
+  return 0;
+}
+
+// Releases view (allocated with new) on any thread without acquiring the GIL:
+// the thread dropping the last reference to a Cord may hold locks that a
+// thread holding the GIL waits for. Without the GIL, the release is handed
+// over to the interpreter with Py_AddPendingCall().
+void ReleaseBufferAnyThread(Py_buffer* view) {
+  if (!Py_IsInitialized()) {
+    // The buffer cannot be released anymore.
+    delete view;
+    return;
+  }
+  if (PyGILState_Check()) {
+    PyBuffer_Release(view);
+    delete view;
+    return;
+  }
+  PendingBufferReleases& pending = GetPendingBufferReleases();
+  std::lock_guard<std::mutex> lock(pending.mu);
+  pending.views.push_back(view);
+  if (!pending.scheduled) {
+    // If the queue of pending calls is full, the next release retries.
+    pending.scheduled =
+        Py_AddPendingCall(&ReleasePendingBuffers, nullptr) == 0;
+  }
+}
+
+// Whether the bytes exported by view can never change: those of a bytes
+// object, or of a _StatusBytesView (owned by a Status or Cord), possibly
+// through a memoryview. Read-only buffers may still be mutable through their
+// exporter, e.g. memoryview(bytearray(...)).toreadonly().
+bool IsImmutableBuffer(const Py_buffer& view) {
+  handle exporter = view.obj;
+  if (exporter && PyMemoryView_Check(exporter.ptr())) {
+    exporter = PyMemoryView_GET_BUFFER(exporter.ptr())->obj;
+  }
+  if (!exporter) return false;
+  return PyBytes_CheckExact(exporter.ptr()) ||
+         isinstance<StatusBytesView>(exporter);
+}
+
+// The bytes of a str (UTF-8), or of an object supporting the buffer protocol
+// (bytes, bytearray, memoryview, pickle.PickleBuffer, ...).
+class BufferBytes {
+ public:
+  explicit BufferBytes(handle obj) {
+    if (PyUnicode_Check(obj.ptr())) {
+      Py_ssize_t size;
+      const char* data = PyUnicode_AsUTF8AndSize(obj.ptr(), &size);
+      if (data == nullptr) throw error_already_set();
+      data_ = absl::string_view(data, static_cast<std::size_t>(size));
+      return;
+    }
+    view_.reset(new Py_buffer());
+    if (PyObject_GetBuffer(obj.ptr(), view_.get(), PyBUF_SIMPLE) != 0) {
+      view_.reset();
+      throw error_already_set();
+    }
+    data_ = absl::string_view(static_cast<const char*>(view_->buf),
+                              static_cast<std::size_t>(view_->len));
+  }
+  BufferBytes(const BufferBytes&) = delete;
+  BufferBytes& operator=(const BufferBytes&) = delete;
+  ~BufferBytes() {
+    if (view_) PyBuffer_Release(view_.get());
+  }
+
+  absl::string_view data() const { return data_; }
+
+  // Returns a Cord referencing the buffer (which it releases when destroyed)
+  // if it is large and immutable (see IsImmutableBuffer()), else a copy of the
+  // bytes.
+  absl::Cord ToCord() && {
+    if (!view_ || data_.size() < kMinExternalCordSize ||
+        !IsImmutableBuffer(*view_)) {
+      return absl::Cord(data_);
+    }
+    Py_buffer* view = view_.release();
+    return absl::MakeCordFromExternal(
+        data_, [view]() { ReleaseBufferAnyThread(view); });
+  }
+
+ private:
+  absl::string_view data_;
+  std::unique_ptr<Py_buffer> view_;
+};
+
+// Payloads are serialized as (type_url, bytes) or, with PayloadPickleBuffers(),
+// (type_url, buffer or list of buffers).
+absl::Cord PayloadFromPickle(handle payload) {
+  if (!PyList_Check(payload.ptr())) return BufferBytes(payload).ToCord();
+  absl::Cord cord;
+  for (handle chunk : reinterpret_borrow<list>(payload)) {
+    cord.Append(BufferBytes(chunk).ToCord());
+  }
+  return cord;
+}
+
+object StatusReduceEx(const object& self, int protocol) {
+  const auto& status = cast<const absl::Status&>(self);
+  list payloads;
+  object message;
+  if (protocol >= 5) {
+    // Zero-copy: pickle writes the bytes from the buffers, or hands them to
+    // its buffer_callback (out-of-band).
+    message = PickleBufferOf({status.message(), status, absl::Cord()});
+    status.ForEachPayload(
+        [&payloads](absl::string_view type_url, const absl::Cord& payload) {
+          payloads.append(make_tuple(bytes(type_url.data(), type_url.size()),
+                                     PayloadPickleBuffers(payload)));
+        });
+  } else {
+    message = bytes(status.message().data(), status.message().size());
+    status.ForEachPayload(
+        [&payloads](absl::string_view type_url, const absl::Cord& payload) {
+          payloads.append(make_tuple(bytes(type_url.data(), type_url.size()),
+                                     CordToBytes(payload)));
+        });
+  }
+  // Make the order deterministic, especially long-term. The type URLs are
+  // unique: the payloads are never compared.
+  payloads.attr("sort")();
+  return make_tuple(
+      self.attr("__class__"),
+      make_tuple(InitFromTag::serialized,
+                 make_tuple(status.code(), message, tuple(payloads))));
+}
+
+// The python StatusNotOk exception type is implemented with the C API.
+// Defining it with python source passed to exec() meant compiling that source
+// each time the module was imported.
+struct StatusNotOkObject {
+  PyBaseExceptionObject base;
+  // The status passed to __init__.
+  PyObject* status;
+  // Like python subclasses of Exception, StatusNotOk supports weak references.
+  PyObject* weakreflist;
+};
+
+PyTypeObject* StatusNotOkType(PyTypeObject* type = nullptr) {
+  static PyTypeObject* status_not_ok_type = nullptr;
+  if (type) {
+    status_not_ok_type = type;
+  }
+  return status_not_ok_type;
+}
+
+PyTypeObject* ExceptionType() {
+  return reinterpret_cast<PyTypeObject*>(PyExc_Exception);
+}
+
+handle StatusOf(PyObject* self) {
+  PyObject* status = reinterpret_cast<StatusNotOkObject*>(self)->status;
+  if (status == nullptr) {
+    throw attribute_error("StatusNotOk.__init__() was not called");
+  }
+  return status;
+}
+
+int StatusNotOkInit(PyObject* self, PyObject* args, PyObject* kwargs) {
+  static const char* keywords[] = {"status", nullptr};
+  PyObject* status = nullptr;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:StatusNotOk",
+                                   const_cast<char**>(keywords), &status)) {
+    return -1;
+  }
+  return CallAndSetPyErr(
+      [self, status]() {
+        if (status == Py_None) {
+          PyErr_SetNone(PyExc_AssertionError);
+          return -1;
+        }
+        const absl::Status* cpp_status = ExactStatus(status);
+        bool ok;
+        if (cpp_status != nullptr) {
+          ok = cpp_status->ok();
+        } else {
+          object py_ok = handle(status).attr("ok")();
+          int truth = PyObject_IsTrue(py_ok.ptr());
+          if (truth < 0) throw error_already_set();
+          ok = truth != 0;
+        }
+        if (ok) {
+          PyErr_SetNone(PyExc_AssertionError);
+          return -1;
+        }
+        Py_INCREF(status);
+        Py_XSETREF(reinterpret_cast<StatusNotOkObject*>(self)->status, status);
+        // Same as Exception.__init__(self, str(self)).
+        auto message = reinterpret_steal<object>(PyObject_Str(self));
+        if (!message) throw error_already_set();
+        tuple exception_args = make_tuple(message);
+        return ExceptionType()->tp_init(self, exception_args.ptr(), nullptr);
+      },
+      -1);
+}
+
+int StatusNotOkTraverse(PyObject* self, visitproc visit, void* arg) {
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
+  Py_VISIT(reinterpret_cast<StatusNotOkObject*>(self)->status);
+  return ExceptionType()->tp_traverse(self, visit, arg);
+}
+
+int StatusNotOkClear(PyObject* self) {
+  Py_CLEAR(reinterpret_cast<StatusNotOkObject*>(self)->status);
+  return ExceptionType()->tp_clear(self);
+}
+
+void StatusNotOkDealloc(PyObject* self) {
+  PyTypeObject* type = Py_TYPE(self);
+  PyObject_GC_UnTrack(self);
+  if (reinterpret_cast<StatusNotOkObject*>(self)->weakreflist != nullptr) {
+    PyObject_ClearWeakRefs(self);
+  }
+  Py_CLEAR(reinterpret_cast<StatusNotOkObject*>(self)->status);
+  // Untracks (again), clears and frees the exception.
+  ExceptionType()->tp_dealloc(self);
+  Py_DECREF(type);
+}
+
+PyObject* StatusNotOkStrSlot(PyObject* self) {
+  return CallAndSetPyErr(
+      [self]() {
+        handle status = StatusOf(self);
+        const absl::Status* cpp_status = ExactStatus(status);
+        if (cpp_status != nullptr) {
+          return decode_utf8_replace(StatusNotOkStr(*cpp_status)).release();
+        }
+        return status.attr("status_not_ok_str")().release();
+      },
+      static_cast<handle>(nullptr))
+      .ptr();
+}
+
+PyObject* StatusNotOkRichCompare(PyObject* self, PyObject* other, int op) {
+  if ((op != Py_EQ && op != Py_NE) ||
+      !PyObject_TypeCheck(other, StatusNotOkType())) {
+    Py_RETURN_NOTIMPLEMENTED;
+  }
+  return CallAndSetPyErr(
+      [self, other, op]() {
+        // Same as comparing Status(InitFromTag.capsule, status).
+        absl::StatusOr<absl::Status*> lhs = StatusRawPtrFromCapsule(
+            reinterpret_borrow<object>(StatusOf(self)));
+        if (!lhs.ok()) throw value_error(std::string(lhs.status().message()));
+        absl::StatusOr<absl::Status*> rhs = StatusRawPtrFromCapsule(
+            reinterpret_borrow<object>(StatusOf(other)));
+        if (!rhs.ok()) throw value_error(std::string(rhs.status().message()));
+        bool equal = *lhs.value() == *rhs.value();
+        return handle(equal == (op == Py_EQ) ? Py_True : Py_False)
+            .inc_ref();
+      },
+      static_cast<handle>(nullptr))
+      .ptr();
+}
+
+PyObject* StatusNotOkGetStatus(PyObject* self, void*) {
+  return CallAndSetPyErr([self]() { return StatusOf(self).inc_ref(); },
+                         static_cast<handle>(nullptr))
+      .ptr();
+}
+
+// _status is the attribute of the StatusNotOk class formerly defined in python,
+// which subclasses may still set.
+int StatusNotOkSetStatus(PyObject* self, PyObject* value, void*) {
+  if (value == nullptr) {
+    PyErr_SetString(PyExc_AttributeError, "cannot delete _status");
+    return -1;
+  }
+  Py_INCREF(value);
+  Py_XSETREF(reinterpret_cast<StatusNotOkObject*>(self)->status, value);
+  return 0;
+}
+
+// code is int by choice. Sorry it would be a major API break to make this an
+// enum.
+PyObject* StatusNotOkGetCode(PyObject* self, void*) {
+  return CallAndSetPyErr(
+      [self]() {
+        handle status = StatusOf(self);
+        const absl::Status* cpp_status = ExactStatus(status);
+        if (cpp_status != nullptr) {
+          return int_(cpp_status->raw_code()).release();
+        }
+        return status.attr("raw_code")().release();
+      },
+      static_cast<handle>(nullptr))
+      .ptr();
+}
+
+PyObject* StatusNotOkGetMessage(PyObject* self, void*) {
+  return CallAndSetPyErr(
+      [self]() {
+        handle status = StatusOf(self);
+        const absl::Status* cpp_status = ExactStatus(status);
+        if (cpp_status != nullptr) {
+          return decode_utf8_replace(cpp_status->message()).release();
+        }
+        return status.attr("message")().release();
+      },
+      static_cast<handle>(nullptr))
+      .ptr();
+}
+
+PyObject* StatusNotOkReduceEx(PyObject* self, PyObject* /*protocol*/) {
+  return CallAndSetPyErr(
+      [self]() {
+        return make_tuple(handle(reinterpret_cast<PyObject*>(Py_TYPE(self))),
+                          make_tuple(StatusOf(self)))
+            .release();
+      },
+      static_cast<handle>(nullptr))
+      .ptr();
+}
+
+object MakeStatusNotOkType(const module& m) {
+  static PyGetSetDef getset[] = {
+      {"status", StatusNotOkGetStatus, nullptr, nullptr, nullptr},
+      {"code", StatusNotOkGetCode, nullptr, nullptr, nullptr},
+      {"message", StatusNotOkGetMessage, nullptr, nullptr, nullptr},
+      {"_status", StatusNotOkGetStatus, StatusNotOkSetStatus, nullptr,
+       nullptr},
+      {nullptr, nullptr, nullptr, nullptr, nullptr},
+  };
+  static PyMemberDef members[] = {
+      {"__weaklistoffset__", T_PYSSIZET,
+       offsetof(StatusNotOkObject, weakreflist), READONLY, nullptr},
+      {nullptr, 0, 0, 0, nullptr},
+  };
+  static PyMethodDef methods[] = {
+      {"__reduce_ex__", StatusNotOkReduceEx, METH_O, nullptr},
+      {nullptr, nullptr, 0, nullptr},
+  };
+  static PyType_Slot slots[] = {
+      {Py_tp_init, reinterpret_cast<void*>(StatusNotOkInit)},
+      {Py_tp_traverse, reinterpret_cast<void*>(StatusNotOkTraverse)},
+      {Py_tp_clear, reinterpret_cast<void*>(StatusNotOkClear)},
+      {Py_tp_dealloc, reinterpret_cast<void*>(StatusNotOkDealloc)},
+      {Py_tp_str, reinterpret_cast<void*>(StatusNotOkStrSlot)},
+      {Py_tp_richcompare, reinterpret_cast<void*>(StatusNotOkRichCompare)},
+      {Py_tp_getset, getset},
+      {Py_tp_members, members},
+      {Py_tp_methods, methods},
+      {0, nullptr},
+  };
+  // PyType_FromSpec() keeps a pointer to the name (before Python 3.12).
+  static const std::string* qualified_name =
+      new std::string(m.attr("__name__").cast<std::string>() + ".StatusNotOk");
+  static PyType_Spec spec = {
+      qualified_name->c_str(), static_cast<int>(sizeof(StatusNotOkObject)), 0,
+      Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, slots};
+  tuple bases = make_tuple(handle(PyExc_Exception));
+  auto type = reinterpret_steal<object>(
+      PyType_FromSpecWithBases(&spec, bases.ptr()));
+  if (!type) throw error_already_set();
+#if PY_VERSION_HEX < 0x03090000
+  // PyType_FromSpec() only reads __weaklistoffset__ since Python 3.9.
+  reinterpret_cast<PyTypeObject*>(type.ptr())->tp_weaklistoffset =
+      offsetof(StatusNotOkObject, weakreflist);
+#endif
+  StatusNotOkType(reinterpret_cast<PyTypeObject*>(type.ptr()));
+  return type;
+}
+
+// Binds the canonical error factories (aborted_error etc.) on first access,
+// through the module __getattr__ (PEP 562), instead of at import time.
+void DefLazyStatusFactories(module m) {
+  m.def(
+      "__getattr__",
+      [](const std::string& attr_name) -> object {
+        module this_module = reinterpret_borrow<module>(ThisModule());
+        for (const StatusFactory& factory : kStatusFactories) {
+          if (attr_name != factory.name) continue;
+          cpp_function function =
+              MakeStatusFactoryFunction(this_module, factory);
+          this_module.add_object(factory.name, function, /*overwrite=*/true);
+          return std::move(function);
+        }
+        throw attribute_error(absl::StrCat(
+            "module '", this_module.attr("__name__").cast<std::string>(),
+            "' has no attribute '", attr_name, "'"));
+      },
+      arg("name"));
+
+  m.def("__dir__", []() {
+    list names(ThisModule().attr("__dict__"));
+    for (const StatusFactory& factory : kStatusFactories) {
+      if (!names.contains(factory.name)) names.append(factory.name);
+    }
+    names.attr("sort")();
+    return names;
+  });
+}
 }  // namespace
 
 namespace internal {
@@ -158,7 +827,8 @@ void RegisterStatusBindings(module m) {
       .value("capsule_direct_only", InitFromTag::capsule_direct_only)
       .value("serialized", InitFromTag::serialized);
 
-  enum_<absl::StatusCode>(m, "StatusCode")
+  enum_<absl::StatusCode> py_enum_status_code(m, "StatusCode");
+  py_enum_status_code
       .value("OK", absl::StatusCode::kOk)
       .value("CANCELLED", absl::StatusCode::kCancelled)
       .value("UNKNOWN", absl::StatusCode::kUnknown)
@@ -196,6 +866,23 @@ void RegisterStatusBindings(module m) {
       [](const absl::StatusCode& code) { return static_cast<int>(code); },
       arg("code"));
 
+  class_<StatusBytesView>(m, "_StatusBytesView", buffer_protocol())
+      .def_buffer([](StatusBytesView& view) {
+        return buffer_info(const_cast<char*>(view.data.data()), 1, "B",
+                           static_cast<ssize_t>(view.data.size()),
+                           /*readonly=*/true);
+      });
+
+  class_<StatusPayloadIterator>(m, "_StatusPayloadIterator")
+      .def("__iter__", [](const object& self) { return self; })
+      .def("__next__", [](StatusPayloadIterator& it) {
+        if (it.position == it.payloads.size()) throw stop_iteration();
+        const auto& payload = it.payloads[it.position++];
+        return make_tuple(
+            bytes(payload.first.data(), payload.first.size()),
+            MemoryViewOf(PayloadExporter(*payload.second)));
+      });
+
   class_<absl::Status> py_class_status(m, "Status");
   py_class_status.def(init())
       .def(init())
@@ -221,10 +908,9 @@ void RegisterStatusBindings(module m) {
                                     " [", __FILE__, ":", __LINE__, "]"));
                  }
                  auto code = cast<absl::StatusCode>(state[0]);
-                 auto message = cast<std::string>(state[1]);
                  auto all_payloads = cast<tuple>(state[2]);
-                 auto status = std::unique_ptr<absl::Status>{
-                     new absl::Status{code, message}};
+                 auto status = std::unique_ptr<absl::Status>{new absl::Status{
+                     code, BufferBytes(state[1]).data()}};
                  for (auto ap_item_obj : all_payloads) {
                    auto ap_item_tup = cast<tuple>(ap_item_obj);
                    if (len(ap_item_tup) != 2) {
@@ -234,8 +920,8 @@ void RegisterStatusBindings(module m) {
                          ":", __LINE__, "]"));
                    }
                    auto type_url = cast<absl::string_view>(ap_item_tup[0]);
-                   auto payload = cast<absl::string_view>(ap_item_tup[1]);
-                   status->SetPayload(type_url, absl::Cord(payload));
+                   status->SetPayload(type_url,
+                                      PayloadFromPickle(ap_item_tup[1]));
                  }
                  return status;
                }
@@ -245,16 +931,6 @@ void RegisterStatusBindings(module m) {
            }),
            arg("init_from_tag"), arg("obj"))
       .def(init<absl::StatusCode, std::string>(), arg("code"), arg("msg"))
-      .def("ok", &absl::Status::ok)
-      .def("code", &absl::Status::code)
-      .def("code_int",
-           [](const absl::Status& self) {
-             return static_cast<int>(self.code());
-           })
-      .def("message",
-           [](const absl::Status& self) {
-             return decode_utf8_replace(self.message());
-           })
       .def("message_bytes",
            [](const absl::Status& self) {
              return bytes(self.message().data(), self.message().size());
@@ -270,15 +946,7 @@ void RegisterStatusBindings(module m) {
            }, kw_only{}, arg("with_source_location") = false)
       .def("status_not_ok_str",
            [](const absl::Status& s) {
-             std::string code_str = absl::StatusCodeToString(s.code());
-             if (code_str.empty()) {
-               // This code is meant to be unreachable, but we want to produce
-               // as much of the original error as possible even if this
-               // assumption is violated.
-               code_str = std::to_string(static_cast<int>(s.code()));
-             }
-             auto output = absl::StrCat(s.message(), " [", code_str, "]");
-             return decode_utf8_replace(output);
+             return decode_utf8_replace(StatusNotOkStr(s));
            })
       .def_static("OkStatus",
                   []() {
@@ -288,24 +956,40 @@ void RegisterStatusBindings(module m) {
                     }
                     return py_singleton;
                   })
-      .def("raw_code", &absl::Status::raw_code)
       .def("IgnoreError", &absl::Status::IgnoreError)
       .def("SetPayload",
-           [](absl::Status& self, absl::string_view type_url,
-              absl::string_view payload) {
-             self.SetPayload(type_url, absl::Cord(payload));
-           })
+           [](absl::Status& self, absl::string_view type_url, handle payload) {
+             // Large read-only buffers (e.g. bytes) are referenced, not copied.
+             self.SetPayload(type_url, BufferBytes(payload).ToCord());
+           },
+           arg("type_url"), arg("payload"))
       .def("ErasePayload",
            [](absl::Status& self, absl::string_view type_url) {
              return self.ErasePayload(type_url);
            })
+      .def("get_payload",
+           [](const absl::Status& self, absl::string_view type_url) -> object {
+             absl::optional<absl::Cord> payload = self.GetPayload(type_url);
+             if (!payload) return none();
+             return MemoryViewOf(PayloadExporter(*payload));
+           },
+           arg("type_url"))
+      .def("payloads",
+           [](const absl::Status& self) {
+             StatusPayloadIterator it{self};
+             it.status.ForEachPayload(
+                 [&it](absl::string_view type_url, const absl::Cord& payload) {
+                   it.payloads.emplace_back(type_url, &payload);
+                 });
+             return it;
+           })
       .def("AllPayloads",
            [](const absl::Status& s) {
              list key_value_pairs;
              s.ForEachPayload([&key_value_pairs](absl::string_view key,
                                                  const absl::Cord& value) {
-               key_value_pairs.append(make_tuple(bytes(std::string(key)),
-                                                 bytes(std::string(value))));
+               key_value_pairs.append(make_tuple(bytes(key.data(), key.size()),
+                                                 CordToBytes(value)));
              });
              // Make the order deterministic, especially long-term.
              key_value_pairs.attr("sort")();
@@ -317,29 +1001,7 @@ void RegisterStatusBindings(module m) {
                  rhs, /*enable_as_capsule_method=*/true);
              return rhs_ptr.ok() && *rhs_ptr.value() == self;
            })
-      .def("__hash__",
-           [](const absl::Status& self) {
-             // Payload is ignored intentionally to minimize runtime.
-             return boost_hash_combine(
-                 std::hash<int>{}(self.raw_code()),
-#if defined(ABSL_USES_STD_STRING_VIEW)
-                 std::hash<std::string_view>{}(self.message())
-#else
-                 std::hash<std::string>{}(std::string(self.message()))
-#endif
-             );
-           })
-      .def(
-          "__reduce_ex__",
-          [](const object& self, int) {
-            return make_tuple(
-                self.attr("__class__"),
-                make_tuple(InitFromTag::serialized,
-                           make_tuple(self.attr("code")(),
-                                      self.attr("message_bytes")(),
-                                      self.attr("AllPayloads")())));
-          },
-          arg("protocol") = -1)
+      .def("__reduce_ex__", &StatusReduceEx, arg("protocol") = -1)
       .def("as_absl_Status", [](absl::Status* self) -> object {
         return reinterpret_steal<object>(
             PyCapsule_New(static_cast<void*>(self), "::absl::Status", nullptr));
@@ -350,6 +1012,9 @@ void RegisterStatusBindings(module m) {
          return decode_utf8_replace(s.ToString());
        });
 
+  // ok, code, code_int, raw_code, message and __hash__.
+  InstallStatusAccessors(py_class_status, py_enum_status_code);
+
   m.def("is_ok", &IsOk, arg("status_or"),
         "Returns false only if passed a non-ok status; otherwise returns true. "
         "This can be used on the return value of a function which returns a "
@@ -357,71 +1022,22 @@ void RegisterStatusBindings(module m) {
         "used in this case because an ok status is never returned; instead, a "
         "non-status object is returned, which doesn't have a .ok() method.");
 
+  m.def("ok_mask", &OkMask, arg("seq"),
+        "Returns bytes with, for each element of seq, 1 if is_ok(element) "
+        "else 0.");
+  m.def("partition", &Partition, arg("seq"),
+        "Returns (values, indices, statuses): the elements of seq for which "
+        "is_ok() is true, and the positions in seq and the elements for which "
+        "it is false.");
+  m.def("raise_if_any", &RaiseIfAny, arg("seq"),
+        "Raises an ExceptionGroup of StatusNotOk, one for each element of seq "
+        "for which is_ok() is false, if any (before python 3.11, raises the "
+        "first StatusNotOk).");
+
   // Return canonical errors.
-  def_status_factory(m, "aborted_error", WrapAbortedError);
-  def_status_factory(m, "already_exists_error", WrapAlreadyExistsError);
-  def_status_factory(m, "cancelled_error", WrapCancelledError);
-  def_status_factory(m, "data_loss_error", WrapDataLossError);
-  def_status_factory(m, "deadline_exceeded_error", WrapDeadlineExceededError);
-  def_status_factory(m, "failed_precondition_error",
-                     WrapFailedPreconditionError);
-  def_status_factory(m, "internal_error", WrapInternalError);
-  def_status_factory(m, "invalid_argument_error", WrapInvalidArgumentError);
-  def_status_factory(m, "not_found_error", WrapNotFoundError);
-  def_status_factory(m, "out_of_range_error", WrapOutOfRangeError);
-  def_status_factory(m, "permission_denied_error", WrapPermissionDeniedError);
-  def_status_factory(m, "resource_exhausted_error", WrapResourceExhaustedError);
-  def_status_factory(m, "unauthenticated_error", WrapUnauthenticatedError);
-  def_status_factory(m, "unavailable_error", WrapUnavailableError);
-  def_status_factory(m, "unimplemented_error", WrapUnimplementedError);
-  def_status_factory(m, "unknown_error", WrapUnknownError);
-
-  // Having Python code embedded here is a compromise solution:
-  // * Ideally the code would live in a .py file, where it is accessible to
-  //   tooling such as linters or source code indexing systems.
-  // * But that makes the dependency management in build systems much more
-  //   complex.
-  // * The embedded code fragment is small and expected to always stay small,
-  //   having it here is most practical given current technologies (the lesser
-  //   of two evils).
-  pybind11::exec(R"(
-      class StatusNotOk(Exception):
-
-        def __init__(self, status):
-          assert status is not None
-          assert not status.ok()
-          self._status = status
-          Exception.__init__(self, str(self))
-
-        @property
-        def status(self):
-          return self._status
-
-        @property
-        def code(self):
-          # code is int by choice. Sorry it would be a major API break to make
-          # this an enum.
-          return self._status.raw_code()
-
-        @property
-        def message(self):
-          return self._status.message()
-
-        def __str__(self):
-          return self._status.status_not_ok_str()
-
-        def __eq__(self, other):
-          if not isinstance(other, StatusNotOk):
-            return NotImplemented
-          lhs = Status(InitFromTag.capsule, self._status)
-          rhs = Status(InitFromTag.capsule, other._status)
-          return lhs == rhs
-
-        def __reduce_ex__(self, protocol):
-          del protocol
-          return (type(self), (self._status,))
-      )",
-                 m.attr("__dict__"), m.attr("__dict__"));
+  DefLazyStatusFactories(m);
+
+  m.attr("StatusNotOk") = MakeStatusNotOkType(m);
 
   // Register a custom handler which converts a C++ StatusNotOk to a
   // PyStatusNotOk.
@@ -429,6 +1045,10 @@ void RegisterStatusBindings(module m) {
     try {
       if (p) std::rethrow_exception(p);
     } catch (const StatusNotOk& e) {
+      PYBIND11_ABSEIL_TRACE_SPAN(span, "exception_translation", "StatusNotOk");
+      // The exception object is shared by all the copies of p (e.g. held by
+      // std::future or rethrown elsewhere): its status is copied, which only
+      // adds a reference to the status representation.
       PyErr_SetObject(PyStatusNotOkTypeInUse().ptr(),
                       PyStatusNotOkTypeInUse()(
                           google::NoThrowStatus<absl::Status>(e.status()))
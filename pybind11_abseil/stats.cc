@@ -0,0 +1,181 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// pybind11_abseil.stats: python access to the counters of caster_stats.h, to
+// the latency histograms of instrumented_binding.h and to the timeline of
+// boundary_tracer.h.
+
+#include <pybind11/pybind11.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "pybind11_abseil/boundary_tracer.h"
+#include "pybind11_abseil/caster_stats.h"
+#include "pybind11_abseil/instrumented_binding.h"
+
+namespace pybind11 {
+namespace google {
+namespace {
+
+dict SnapshotToDict(const CasterStatsSnapshot& snapshot) {
+  dict result;
+  for (int i = 0; i < kNumCasterIds; ++i) {
+    auto id = static_cast<CasterId>(i);
+    dict counts;
+    for (int j = 0; j < kNumCasterStats; ++j) {
+      auto stat = static_cast<CasterStat>(j);
+      counts[CasterStatName(stat)] = snapshot.get(id, stat);
+    }
+    result[CasterIdName(id)] = counts;
+  }
+  dict status_not_ok;
+  for (int code = 0; code < kNumStatusNotOkSlots; ++code) {
+    std::string name =
+        code < kNumStatusNotOkSlots - 1
+            ? absl::StatusCodeToString(static_cast<absl::StatusCode>(code))
+            : "OTHER";
+    status_not_ok[str(name)] = snapshot.status_not_ok[code];
+  }
+  result["status_not_ok"] = status_not_ok;
+  return result;
+}
+
+dict HistogramToDict(const LatencyHistogram& histogram,
+                     double nanos_per_tick) {
+  auto to_nanos = [nanos_per_tick](uint64_t ticks) {
+    return static_cast<double>(ticks) * nanos_per_tick;
+  };
+  dict result;
+  uint64_t count = histogram.count();
+  result["count"] = count;
+  result["mean_ns"] = count == 0 ? 0.0
+                                 : to_nanos(histogram.sum_ticks) /
+                                       static_cast<double>(count);
+  result["p50_ns"] = to_nanos(histogram.QuantileUpperBound(0.5));
+  result["p90_ns"] = to_nanos(histogram.QuantileUpperBound(0.9));
+  result["p99_ns"] = to_nanos(histogram.QuantileUpperBound(0.99));
+  result["p999_ns"] = to_nanos(histogram.QuantileUpperBound(0.999));
+  // (lower bound in ns, count) of the non-empty buckets.
+  list buckets;
+  for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+    if (histogram.buckets[i] == 0) continue;
+    buckets.append(make_tuple(to_nanos(LatencyHistogram::BucketLowerBound(i)),
+                              histogram.buckets[i]));
+  }
+  result["buckets"] = buckets;
+  return result;
+}
+
+std::string OutcomeName(int slot) {
+  if (slot == kCppExceptionSlot) return "EXCEPTION";
+  if (slot == kOtherStatusCodeSlot) return "OTHER";
+  return absl::StatusCodeToString(static_cast<absl::StatusCode>(slot));
+}
+
+dict LatenciesToDict(const std::vector<BindingLatencySnapshot>& snapshots,
+                     double nanos_per_tick) {
+  static constexpr const char* kPhaseNames[kNumCallPhases] = {"args", "exec",
+                                                              "result"};
+  dict result;
+  for (const BindingLatencySnapshot& snapshot : snapshots) {
+    dict binding;
+    binding["calls"] = snapshot.calls;
+    dict outcomes;
+    for (int slot = 0; slot < kNumCallOutcomeSlots; ++slot) {
+      if (snapshot.outcomes[slot] == 0) continue;
+      outcomes[str(OutcomeName(slot))] = snapshot.outcomes[slot];
+    }
+    binding["outcomes"] = outcomes;
+    for (int i = 0; i < kNumCallPhases; ++i) {
+      binding[kPhaseNames[i]] =
+          HistogramToDict(snapshot.phases[i], nanos_per_tick);
+    }
+    result[str(snapshot.name)] = binding;
+  }
+  return result;
+}
+
+}  // namespace
+
+PYBIND11_MODULE(stats, m) {
+  m.doc() =
+      "Conversion counters of the pybind11_abseil casters, recorded by "
+      "extensions built with PYBIND11_ABSEIL_ENABLE_CASTER_STATS, latency "
+      "histograms of the bindings wrapped with "
+      "pybind11::google::Instrumented(), and a Chrome trace of the C++/Python "
+      "boundary crossings.";
+
+  m.def(
+      "enabled",
+      []() {
+#if defined(PYBIND11_ABSEIL_ENABLE_CASTER_STATS)
+        return true;
+#else
+        return false;
+#endif
+      },
+      "Whether this module was built with "
+      "PYBIND11_ABSEIL_ENABLE_CASTER_STATS.");
+
+  m.def(
+      "snapshot", []() { return SnapshotToDict(SnapshotCasterStats()); },
+      "Returns {caster: {stat: count}} for the casters, and "
+      "{'status_not_ok': {code_name: count}}, summed over all threads and "
+      "extension modules since the last reset().");
+
+  m.def("reset", &ResetCasterStats, "Resets all the counters to zero.");
+
+  m.def(
+      "latency_snapshot",
+      []() {
+        return LatenciesToDict(SnapshotBindingLatencies(),
+                               LatencyNanosPerTick());
+      },
+      "Returns {binding: {'calls': n, 'outcomes': {code_name: n}, 'args': h, "
+      "'exec': h, 'result': h}} for the bindings wrapped with "
+      "pybind11::google::Instrumented(), where each h summarizes the latency "
+      "histogram of a phase of the calls. Calls raising a C++ exception other "
+      "than StatusNotOk have the outcome 'EXCEPTION'.");
+
+  m.def("reset_latencies", &ResetBindingLatencies,
+        "Resets all the latency histograms.");
+
+  m.def(
+      "tracer_enabled",
+      []() {
+#if defined(PYBIND11_ABSEIL_ENABLE_BOUNDARY_TRACER)
+        return true;
+#else
+        return false;
+#endif
+      },
+      "Whether this module was built with "
+      "PYBIND11_ABSEIL_ENABLE_BOUNDARY_TRACER. Only the extensions built with "
+      "it record the func_wrapper and StatusNotOk translation spans; the "
+      "Instrumented() bindings are always traced.");
+
+  m.def("start_tracing", &StartBoundaryTracing,
+        arg("events_per_thread") = std::size_t{1} << 14,
+        "Starts recording spans, in a ring buffer of events_per_thread spans "
+        "per thread (for the threads that did not record any span yet).");
+
+  m.def("stop_tracing", &StopBoundaryTracing,
+        "Stops recording spans. The recorded spans are kept.");
+
+  m.def("tracing", &BoundaryTracingEnabled,
+        "Whether spans are being recorded.");
+
+  m.def("trace_json", &BoundaryTraceToChromeJson,
+        "Returns the recorded spans as Chrome trace JSON, for "
+        "chrome://tracing or https://ui.perfetto.dev.");
+
+  m.def("clear_trace", &ClearBoundaryTrace, "Discards the recorded spans.");
+}
+
+}  // namespace google
+}  // namespace pybind11
@@ -0,0 +1,142 @@
+#include "pybind11_abseil/status_accessors.h"
+
+#include <Python.h>
+#include <pybind11/pybind11.h>
+
+#include <array>
+
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "pybind11_abseil/utils_pybind11_absl.h"
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+namespace {
+
+// absl::StatusCode values are 0 to 16.
+constexpr int kNumStatusCodes = 17;
+
+struct AccessorState {
+  // The members of the StatusCode enum, indexed by code.
+  std::array<object, kNumStatusCodes> status_codes;
+};
+
+// Intentionally leaked: the python references must not be released after the
+// interpreter is finalized.
+AccessorState& State() {
+  static AccessorState* state = new AccessorState();
+  return *state;
+}
+
+// Returns nullptr (with a python error) if __init__ was not called.
+const absl::Status* SelfStatus(PyObject* self) {
+  auto* status = static_cast<const absl::Status*>(
+      reinterpret_cast<detail::instance*>(self)
+          ->get_value_and_holder()
+          .value_ptr());
+  if (status == nullptr) {
+    PyErr_SetString(PyExc_TypeError, "Status.__init__() was not called");
+  }
+  return status;
+}
+
+PyObject* StatusOkMethod(PyObject* self, PyObject*) {
+  const absl::Status* status = SelfStatus(self);
+  if (status == nullptr) return nullptr;
+  return PyBool_FromLong(status->ok());
+}
+
+PyObject* StatusCodeMethod(PyObject* self, PyObject*) {
+  const absl::Status* status = SelfStatus(self);
+  if (status == nullptr) return nullptr;
+  return CallAndSetPyErr(
+      [status]() {
+        auto code = static_cast<int>(status->code());
+        if (code >= 0 && code < kNumStatusCodes &&
+            State().status_codes[code]) {
+          return State().status_codes[code].inc_ref();
+        }
+        return cast(status->code()).release();
+      },
+      handle())
+      .ptr();
+}
+
+PyObject* StatusCodeIntMethod(PyObject* self, PyObject*) {
+  const absl::Status* status = SelfStatus(self);
+  if (status == nullptr) return nullptr;
+  return PyLong_FromLong(static_cast<int>(status->code()));
+}
+
+PyObject* StatusRawCodeMethod(PyObject* self, PyObject*) {
+  const absl::Status* status = SelfStatus(self);
+  if (status == nullptr) return nullptr;
+  return PyLong_FromLong(status->raw_code());
+}
+
+PyObject* StatusMessageMethod(PyObject* self, PyObject*) {
+  const absl::Status* status = SelfStatus(self);
+  if (status == nullptr) return nullptr;
+  if (status->message().empty()) return PyUnicode_FromStringAndSize("", 0);
+  return CallAndSetPyErr(
+      [status]() { return decode_utf8_replace(status->message()).release(); },
+      handle())
+      .ptr();
+}
+
+// Payloads are ignored intentionally to minimize runtime.
+Py_hash_t StatusHash(PyObject* self) {
+  const absl::Status* status = SelfStatus(self);
+  if (status == nullptr) return -1;
+  auto hash = static_cast<Py_hash_t>(
+      absl::HashOf(status->raw_code(), status->message()));
+  // -1 is reserved for errors.
+  return hash == -1 ? -2 : hash;
+}
+
+PyObject* StatusHashMethod(PyObject* self, PyObject*) {
+  Py_hash_t hash = StatusHash(self);
+  if (hash == -1) return nullptr;
+  return PyLong_FromSsize_t(hash);
+}
+
+}  // namespace
+
+void InstallStatusAccessors(handle status_type, handle status_code_type) {
+  // The "--" lines are the signatures reported by inspect.signature().
+  static PyMethodDef methods[] = {
+      {"ok", StatusOkMethod, METH_NOARGS, "ok($self, /)\n--\n\n"},
+      {"code", StatusCodeMethod, METH_NOARGS, "code($self, /)\n--\n\n"},
+      {"code_int", StatusCodeIntMethod, METH_NOARGS,
+       "code_int($self, /)\n--\n\n"},
+      {"raw_code", StatusRawCodeMethod, METH_NOARGS,
+       "raw_code($self, /)\n--\n\n"},
+      {"message", StatusMessageMethod, METH_NOARGS,
+       "message($self, /)\n--\n\n"},
+      {"__hash__", StatusHashMethod, METH_NOARGS,
+       "__hash__($self, /)\n--\n\n"},
+  };
+  auto* type = reinterpret_cast<PyTypeObject*>(status_type.ptr());
+  for (PyMethodDef& method : methods) {
+    auto descriptor =
+        reinterpret_steal<object>(PyDescr_NewMethod(type, &method));
+    if (!descriptor) throw error_already_set();
+    setattr(status_type, method.ml_name, descriptor);
+  }
+  // Setting __hash__ made tp_hash look up and call the method; call the C
+  // function directly instead.
+  type->tp_hash = StatusHash;
+  PyType_Modified(type);
+
+  for (auto member : dict(status_code_type.attr("__members__"))) {
+    int code = int_(reinterpret_borrow<object>(member.second));
+    if (code >= 0 && code < kNumStatusCodes) {
+      State().status_codes[code] = reinterpret_borrow<object>(member.second);
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace google
+}  // namespace pybind11
@@ -0,0 +1,26 @@
+#ifndef PYBIND11_ABSEIL_STATUS_ACCESSORS_H_
+#define PYBIND11_ABSEIL_STATUS_ACCESSORS_H_
+
+#include <pybind11/pybind11.h>
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+// Adds the ok, code, code_int, raw_code, message and __hash__ methods to the
+// python Status type (status_type, bound with class_<absl::Status>).
+//
+// The methods are C functions (METH_NOARGS, called with vectorcall), not
+// pybind11 functions: they skip the overload resolution and argument
+// conversions of the pybind11 dispatcher. code() returns the members of
+// status_code_type (the StatusCode enum_) instead of new enum objects.
+// message() and __hash__ read the status on every call (nothing is cached per
+// Status object), so they follow changes made in place or from C++. Can be
+// called again for the same type.
+void InstallStatusAccessors(handle status_type, handle status_code_type);
+
+}  // namespace internal
+}  // namespace google
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_STATUS_ACCESSORS_H_
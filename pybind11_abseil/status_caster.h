@@ -13,6 +13,8 @@
 #include <utility>
 
 #include "absl/status/status.h"
+#include "pybind11_abseil/boundary_tracer.h"
+#include "pybind11_abseil/caster_stats.h"
 #include "pybind11_abseil/check_status_module_imported.h"
 #include "pybind11_abseil/compat/status_from_py_exc.h"
 #include "pybind11_abseil/cpp_capsule_tools/raw_ptr_from_capsule.h"
@@ -76,7 +78,9 @@ struct type_caster<absl::Status> : public type_caster_base<absl::Status> {
   }
 
   bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kStatus, kCalls, 1);
     if (type_caster_base<absl::Status>::load(src, convert)) {
+      PYBIND11_ABSEIL_CASTER_STAT(kStatus, kFastPath, 1);
       // Behavior change 2023-02-09: previously `value` was simply left as
       // `nullptr`.
       if (!value) {
@@ -89,6 +93,13 @@ struct type_caster<absl::Status> : public type_caster_base<absl::Status> {
           pybind11_abseil::cpp_capsule_tools::RawPtrFromCapsule<void>(
               src.ptr(), "::absl::Status", "as_absl_Status");
       if (raw_ptr.ok()) {
+        // From a capsule, or from the capsule returned by as_absl_Status().
+        PYBIND11_ABSEIL_CASTER_STAT(kStatus, kFallback, 1);
+        if (PyCapsule_CheckExact(src.ptr())) {
+          PYBIND11_ABSEIL_CASTER_STAT(kStatus, kCapsule, 1);
+        } else {
+          PYBIND11_ABSEIL_CASTER_STAT(kStatus, kAsAbslStatus, 1);
+        }
         value = raw_ptr.value();
         return true;
       }
@@ -112,6 +123,7 @@ struct type_caster<absl::Status> : public type_caster_base<absl::Status> {
                                                   policy, parent);
     } else if (!src.ok()) {
       // Convert a non-ok status into an exception.
+      PYBIND11_ABSEIL_STATUS_NOT_OK_STAT(src.code());
       throw google::StatusNotOk(std::forward<CType>(src));
     } else {
       // Return none for an ok status.
@@ -136,14 +148,32 @@ struct func_wrapper<absl::Status, Args...> : func_wrapper_base {
   using func_wrapper_base::func_wrapper_base;
   // NOTE: `noexcept` to guarantee that no C++ exception will ever escape.
   absl::Status operator()(Args... args) const noexcept {
+    PYBIND11_ABSEIL_TRACE_SPAN(gil_span, "gil_acquire", "func_wrapper");
     gil_scoped_acquire acq;
+    PYBIND11_ABSEIL_TRACE_SPAN_END(gil_span);
     try {
-      object py_result =
 #if defined(PYBIND11_HAS_RETURN_VALUE_POLICY_PACK)
+      // The policies apply to the conversion of the arguments, which is
+      // therefore recorded as part of the python call.
+      PYBIND11_ABSEIL_TRACE_SPAN(call_span, "py_call", "func_wrapper");
+      object py_result =
           hfunc.f.call_with_policies(rvpp, std::forward<Args>(args)...);
 #else
-          hfunc.f(std::forward<Args>(args)...);
+      // Same as hfunc.f(args...), with the conversion of the arguments
+      // recorded separately from the python call.
+      PYBIND11_ABSEIL_TRACE_SPAN(args_span, "args_conversion", "func_wrapper");
+      tuple py_args = make_tuple(std::forward<Args>(args)...);
+      PYBIND11_ABSEIL_TRACE_SPAN_END(args_span);
+      PYBIND11_ABSEIL_TRACE_SPAN(call_span, "py_call", "func_wrapper");
+      auto py_result = reinterpret_steal<object>(
+          PyObject_Call(hfunc.f.ptr(), py_args.ptr(), nullptr));
+      if (!py_result) {
+        throw error_already_set();
+      }
 #endif
+      PYBIND11_ABSEIL_TRACE_SPAN_END(call_span);
+      PYBIND11_ABSEIL_TRACE_SPAN(result_span, "result_conversion",
+                                 "func_wrapper");
       try {
         return py_result.template cast<absl::Status>();
       } catch (cast_error& e) {
@@ -156,6 +186,8 @@ struct func_wrapper<absl::Status, Args...> : func_wrapper_base {
     // Occurrence of such exceptions in this context is considered a bug in
     // user code. The `noexcept` above will lead to process termination.
     catch (error_already_set& e) {
+      PYBIND11_ABSEIL_TRACE_SPAN(exception_span, "exception_translation",
+                                 "func_wrapper");
       e.restore();
       return pybind11_abseil::compat::StatusFromPyExcGivenErrOccurred();
     }
@@ -1,6 +1,7 @@
 #ifndef PYBIND11_ABSEIL_STATUS_NOT_OK_EXCEPTION_H_
 #define PYBIND11_ABSEIL_STATUS_NOT_OK_EXCEPTION_H_
 
+#include <atomic>
 #include <exception>
 #include <string>
 #include <utility>
@@ -14,21 +15,63 @@ namespace google {
 //
 // This is in the pybind::google namespace because it was originally created to
 // use with pybind11, but it does NOT depend on the pybind11 library.
+//
+// what() formats the status (with its payloads) on first use: the conversion
+// to a python exception only needs status().
 class StatusNotOk : public std::exception {
  public:
-  StatusNotOk(absl::Status&& status)
-      : status_(std::move(status)),
-        what_(status_.ToString(absl::StatusToStringMode::kWithEverything)) {}
-  StatusNotOk(const absl::Status& status)
-      : status_(status),
-        what_(status_.ToString(absl::StatusToStringMode::kWithEverything)) {}
+  StatusNotOk(absl::Status&& status) : status_(std::move(status)) {}
+  StatusNotOk(const absl::Status& status) : status_(status) {}
+  StatusNotOk(const StatusNotOk& other)
+      : std::exception(other), status_(other.status_) {}
+  StatusNotOk(StatusNotOk&& other) noexcept
+      : std::exception(other),
+        status_(std::move(other.status_)),
+        what_(other.what_.exchange(nullptr, std::memory_order_acq_rel)) {}
+  StatusNotOk& operator=(const StatusNotOk& other) {
+    if (this != &other) {
+      status_ = other.status_;
+      delete what_.exchange(nullptr, std::memory_order_acq_rel);
+    }
+    return *this;
+  }
+  StatusNotOk& operator=(StatusNotOk&& other) noexcept {
+    if (this != &other) {
+      status_ = std::move(other.status_);
+      delete what_.exchange(
+          other.what_.exchange(nullptr, std::memory_order_acq_rel),
+          std::memory_order_acq_rel);
+    }
+    return *this;
+  }
+  ~StatusNotOk() override { delete what_.load(std::memory_order_acquire); }
+
   const absl::Status& status() const& { return status_; }
   absl::Status&& status() && { return std::move(status_); }
-  const char* what() const noexcept override { return what_.c_str(); }
+
+  // Thread-safe. Reflects status() at the time of the first call.
+  const char* what() const noexcept override {
+    const std::string* what = what_.load(std::memory_order_acquire);
+    if (what != nullptr) return what->c_str();
+    try {
+      auto* formatted = new std::string(
+          status_.ToString(absl::StatusToStringMode::kWithEverything));
+      // If another thread formatted the status first, use its string.
+      if (what_.compare_exchange_strong(what, formatted,
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_acquire)) {
+        return formatted->c_str();
+      }
+      delete formatted;
+      return what->c_str();
+    } catch (...) {
+      return "StatusNotOk";
+    }
+  }
 
  private:
   absl::Status status_;
-  std::string what_;
+  mutable std::atomic<const std::string*> what_{nullptr};
 };
 
 }  // namespace google
@@ -15,6 +15,8 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "pybind11_abseil/boundary_tracer.h"
+#include "pybind11_abseil/caster_stats.h"
 #include "pybind11_abseil/check_status_module_imported.h"
 #include "pybind11_abseil/compat/status_from_py_exc.h"
 #include "pybind11_abseil/no_throw_status.h"
@@ -58,9 +60,11 @@ struct type_caster<absl::StatusOr<PayloadType>> {
 #endif
 
   bool load(handle src, bool convert) {
+    PYBIND11_ABSEIL_CASTER_STAT(kStatusOr, kCalls, 1);
     PayloadCaster payload_caster;
     if (payload_caster.load(src, convert)) {
       value = cast_op<PayloadType>(std::move(payload_caster));
+      PYBIND11_ABSEIL_CASTER_STAT(kStatusOr, kFastPath, 1);
       return true;
     }
     if (src.is_none()) {
@@ -76,6 +80,7 @@ struct type_caster<absl::StatusOr<PayloadType>> {
       } else {
         value = status;
       }
+      PYBIND11_ABSEIL_CASTER_STAT(kStatusOr, kFallback, 1);
       return true;
     }
     return false;
@@ -140,14 +145,29 @@ struct func_wrapper<absl::StatusOr<PayloadType>, Args...> : func_wrapper_base {
   using func_wrapper_base::func_wrapper_base;
   // NOTE: `noexcept` to guarantee that no C++ exception will ever escape.
   absl::StatusOr<PayloadType> operator()(Args... args) const noexcept {
+    PYBIND11_ABSEIL_TRACE_SPAN(gil_span, "gil_acquire", "func_wrapper");
     gil_scoped_acquire acq;
+    PYBIND11_ABSEIL_TRACE_SPAN_END(gil_span);
     try {
-      object py_result =
 #if defined(PYBIND11_HAS_RETURN_VALUE_POLICY_PACK)
+      // See the corresponding comment in status_caster.h.
+      PYBIND11_ABSEIL_TRACE_SPAN(call_span, "py_call", "func_wrapper");
+      object py_result =
           hfunc.f.call_with_policies(rvpp, std::forward<Args>(args)...);
 #else
-          hfunc.f(std::forward<Args>(args)...);
+      PYBIND11_ABSEIL_TRACE_SPAN(args_span, "args_conversion", "func_wrapper");
+      tuple py_args = make_tuple(std::forward<Args>(args)...);
+      PYBIND11_ABSEIL_TRACE_SPAN_END(args_span);
+      PYBIND11_ABSEIL_TRACE_SPAN(call_span, "py_call", "func_wrapper");
+      auto py_result = reinterpret_steal<object>(
+          PyObject_Call(hfunc.f.ptr(), py_args.ptr(), nullptr));
+      if (!py_result) {
+        throw error_already_set();
+      }
 #endif
+      PYBIND11_ABSEIL_TRACE_SPAN_END(call_span);
+      PYBIND11_ABSEIL_TRACE_SPAN(result_span, "result_conversion",
+                                 "func_wrapper");
       try {
         auto cpp_result =
             py_result.template cast<absl::StatusOr<PayloadType>>();
@@ -163,6 +183,8 @@ struct func_wrapper<absl::StatusOr<PayloadType>, Args...> : func_wrapper_base {
     }
     // See comment for the corresponding `catch` in status_caster.h.
     catch (error_already_set& e) {
+      PYBIND11_ABSEIL_TRACE_SPAN(exception_span, "exception_translation",
+                                 "func_wrapper");
       e.restore();
       return pybind11_abseil::compat::StatusFromPyExcGivenErrOccurred();
     }
@@ -0,0 +1,462 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Python iterators over C++ streams of records, with background prefetching.
+//
+// A source returns the next record, nullopt at the end of the stream, or a
+// non-ok status, e.g. a record reader:
+//
+//   absl::StatusOr<std::optional<Record>> RecordReader::Next();
+//
+// A StatusOrStream pulls its source on a C++ worker thread, without the GIL,
+// in batches of up to batch_size records. At most max_pending_batches batches
+// wait to be consumed: the worker blocks while they are all pending. Each batch
+// is converted to python at once when it is handed over, and its records are
+// then returned without calling into C++. A non-ok status is raised as
+// StatusNotOk after the records pulled before it, and ends the iteration.
+//
+//   PYBIND11_MODULE(records, m) {
+//     pybind11::google::ImportStatusModule();
+//     pybind11::google::bind_statusor_stream<Record>(m, "RecordStream");
+//     m.def("read", [](const std::string& path) {
+//       auto reader = std::make_shared<RecordReader>(path);
+//       return pybind11::google::MakeStatusOrStream<Record>(
+//           [reader] { return reader->Next(); });
+//     });
+//   }
+//
+// The streams are iterators (`for record in records.read(path)`) and
+// asynchronous iterators (`async for record in records.read(path)`): awaiting
+// a record that was not pulled yet does not block the event loop, which the
+// worker thread wakes up when the batch is ready.
+//
+// The source is called on the worker thread only, and destroyed with the
+// stream: it must acquire the GIL itself if it calls into python. Destroying
+// (or closing) the stream waits for the call of the source in progress, if
+// any, to return.
+
+#ifndef PYBIND11_ABSEIL_STATUSOR_STREAM_H_
+#define PYBIND11_ABSEIL_STATUSOR_STREAM_H_
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "pybind11_abseil/caster_stats.h"
+#include "pybind11_abseil/check_status_module_imported.h"
+#include "pybind11_abseil/import_status_module.h"
+#include "pybind11_abseil/no_throw_status.h"
+#include "pybind11_abseil/status_casters.h"
+#include "pybind11_abseil/status_not_ok_exception.h"
+
+namespace pybind11 {
+namespace google {
+
+struct StatusOrStreamOptions {
+  // The maximum number of records handed over to python at once. A partial
+  // batch is handed over as soon as python waits for the next record.
+  std::size_t batch_size = 256;
+  // The maximum number of batches pulled ahead of python.
+  std::size_t max_pending_batches = 4;
+};
+
+namespace internal {
+
+// How often a thread waiting for a batch checks for signals, e.g. SIGINT.
+constexpr std::chrono::milliseconds kStreamSignalCheckInterval(100);
+
+template <typename Record>
+struct StatusOrStreamBatch {
+  std::vector<Record> records;
+  // Not ok if pulling the record after the last one of records failed.
+  absl::Status status;
+  // Whether this is the last batch of the stream.
+  bool last = false;
+};
+
+// The state of a StatusOrStream shared with its worker thread and with the
+// callbacks scheduled on asyncio event loops. The consumer side (records_ to
+// waiter_) requires the GIL; the worker only touches python objects (a
+// waiter_ it took) with the GIL acquired.
+template <typename Record>
+class StatusOrStreamState {
+ public:
+  using Source = absl::AnyInvocable<absl::StatusOr<absl::optional<Record>>()>;
+  using Batch = StatusOrStreamBatch<Record>;
+
+  enum class Outcome { kRecord, kNotReady, kError, kEnd };
+
+  StatusOrStreamState(Source source, StatusOrStreamOptions options)
+      : source_(std::move(source)),
+        batch_size_(std::max<std::size_t>(options.batch_size, 1)),
+        max_pending_batches_(
+            std::max<std::size_t>(options.max_pending_batches, 1)) {}
+
+  // The worker thread: pulls batches until the end of the stream or Stop().
+  void Run() {
+    bool last = false;
+    while (!last) {
+      Batch batch;
+      batch.records.reserve(batch_size_);
+      while (batch.records.size() < batch_size_) {
+        if (stop_.load(std::memory_order_relaxed)) return;
+        if (!batch.records.empty() &&
+            consumer_waiting_.load(std::memory_order_relaxed)) {
+          break;
+        }
+        absl::StatusOr<absl::optional<Record>> next = source_();
+        if (!next.ok()) {
+          batch.status = std::move(next).status();
+          batch.last = true;
+          break;
+        }
+        if (!next->has_value()) {
+          batch.last = true;
+          break;
+        }
+        batch.records.push_back(std::move(**next));
+      }
+      last = batch.last;
+      Waiter waiter;
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        not_full_.wait(lock, [this] {
+          return stop_.load(std::memory_order_relaxed) ||
+                 pending_.size() < max_pending_batches_;
+        });
+        if (stop_.load(std::memory_order_relaxed)) return;
+        pending_.push_back(std::move(batch));
+        waiter = std::move(waiter_);
+        waiter_ = Waiter();
+      }
+      not_empty_.notify_one();
+      if (waiter.future) Wake(std::move(waiter));
+    }
+  }
+
+  // Makes Run() return, and ends the iteration of a future awaiting the next
+  // batch (with StopAsyncIteration). Any thread; acquires the GIL if there is
+  // such a future.
+  void Stop() {
+    Waiter waiter;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_.store(true, std::memory_order_relaxed);
+      waiter = std::move(waiter_);
+      waiter_ = Waiter();
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+    if (waiter.future) Wake(std::move(waiter));
+  }
+
+  // Takes the next record into *record, or the outcome of the stream at its
+  // position into *status. Waits for the worker with the GIL released if
+  // block, else returns kNotReady if the next batch is not pulled yet. Requires
+  // the GIL.
+  Outcome Take(bool block, object* record, absl::Status* status) {
+    while (true) {
+      if (position_ < records_.size()) {
+        *record = std::move(records_[position_++]);
+        return Outcome::kRecord;
+      }
+      if (!status_.ok()) {
+        *status = std::move(status_);
+        status_ = absl::OkStatus();
+        end_ = true;
+        return Outcome::kError;
+      }
+      if (end_) return Outcome::kEnd;
+      absl::optional<Batch> batch = Pop(block);
+      if (!batch) {
+        if (!stop_.load(std::memory_order_relaxed)) return Outcome::kNotReady;
+        end_ = true;
+        return Outcome::kEnd;
+      }
+      Adopt(std::move(*batch));
+    }
+  }
+
+  // Resolves future (of loop) with the next record, or with StatusNotOk or
+  // StopAsyncIteration. If the next batch is not pulled yet, resolves it once
+  // the worker hands the batch over instead. Requires the GIL.
+  static void Resolve(const std::shared_ptr<StatusOrStreamState>& self,
+                      const object& loop, const object& future) {
+    // Cancelled.
+    if (future.attr("done")().cast<bool>()) return;
+    while (true) {
+      object record;
+      absl::Status status;
+      switch (self->Take(/*block=*/false, &record, &status)) {
+        case Outcome::kRecord:
+          future.attr("set_result")(record);
+          return;
+        case Outcome::kError:
+          future.attr("set_exception")(ImportStatusModule().attr(
+              "StatusNotOk")(NoThrowStatus<absl::Status>(std::move(status))));
+          return;
+        case Outcome::kEnd:
+          future.attr("set_exception")(
+              reinterpret_borrow<object>(PyExc_StopAsyncIteration)());
+          return;
+        case Outcome::kNotReady:
+          break;
+      }
+      Waiter waiter{loop,
+                    cpp_function([self, loop](const object& future) {
+                      Resolve(self, loop, future);
+                    }),
+                    future};
+      std::lock_guard<std::mutex> lock(self->mu_);
+      // Else the worker handed a batch over meanwhile.
+      if (self->pending_.empty() &&
+          !self->stop_.load(std::memory_order_relaxed)) {
+        self->waiter_ = std::move(waiter);
+        self->consumer_waiting_.store(true, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  // Drops the pending asyncio callback, which references this state. Requires
+  // the GIL.
+  void ClearWaiter() {
+    Waiter waiter;
+    std::lock_guard<std::mutex> lock(mu_);
+    waiter = std::move(waiter_);
+    waiter_ = Waiter();
+  }
+
+ private:
+  // A future awaiting the next batch, resolved by callback(future) on loop.
+  struct Waiter {
+    object loop;
+    object callback;
+    object future;
+  };
+
+  absl::optional<Batch> Pop(bool block) {
+    absl::optional<Batch> batch;
+    if (block) {
+      bool interrupted = false;
+      {
+        gil_scoped_release release;
+        std::unique_lock<std::mutex> lock(mu_);
+        consumer_waiting_.store(true, std::memory_order_relaxed);
+        while (pending_.empty() && !stop_.load(std::memory_order_relaxed)) {
+          if (not_empty_.wait_for(lock, kStreamSignalCheckInterval) ==
+                  std::cv_status::timeout &&
+              pending_.empty()) {
+            lock.unlock();
+            {
+              gil_scoped_acquire acquire;
+              interrupted = PyErr_CheckSignals() != 0;
+            }
+            lock.lock();
+            if (interrupted) break;
+          }
+        }
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+        if (!interrupted && !pending_.empty()) {
+          batch = std::move(pending_.front());
+          pending_.pop_front();
+        }
+      }
+      if (interrupted) throw error_already_set();
+    } else {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (!pending_.empty()) {
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+        batch = std::move(pending_.front());
+        pending_.pop_front();
+      }
+    }
+    if (batch) not_full_.notify_one();
+    return batch;
+  }
+
+  // Converts the records of batch to python.
+  void Adopt(Batch batch) {
+    records_.clear();
+    position_ = 0;
+    records_.reserve(batch.records.size());
+    for (Record& record : batch.records) {
+      records_.push_back(pybind11::cast(std::move(record)));
+    }
+    status_ = std::move(batch.status);
+    end_ = batch.last;
+  }
+
+  // Schedules waiter.callback(waiter.future) on waiter.loop. Any thread.
+  static void Wake(Waiter waiter) {
+    if (!Py_IsInitialized()) {
+      // The objects cannot be released anymore.
+      waiter.loop.release();
+      waiter.callback.release();
+      waiter.future.release();
+      return;
+    }
+    gil_scoped_acquire acquire;
+    try {
+      waiter.loop.attr("call_soon_threadsafe")(waiter.callback, waiter.future);
+    } catch (error_already_set&) {
+      // The loop is closed: nothing awaits the future anymore.
+    }
+    waiter = Waiter();
+  }
+
+  Source source_;
+  const std::size_t batch_size_;
+  const std::size_t max_pending_batches_;
+
+  std::mutex mu_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<Batch> pending_;
+  std::atomic<bool> stop_{false};
+  // Whether python waits for a batch: the worker then hands over partial
+  // batches.
+  std::atomic<bool> consumer_waiting_{false};
+
+  // The converted records of the current batch.
+  std::vector<object> records_;
+  std::size_t position_ = 0;
+  // The outcome of the stream after records_.
+  absl::Status status_;
+  bool end_ = false;
+  // Guarded by mu_.
+  Waiter waiter_;
+};
+
+}  // namespace internal
+
+// A python iterator and asynchronous iterator over the records of a source,
+// pulled on a worker thread (see above). Bind with bind_statusor_stream().
+template <typename Record>
+class StatusOrStream {
+ public:
+  using State = internal::StatusOrStreamState<Record>;
+  using Source = typename State::Source;
+
+  // Starts pulling source on a worker thread.
+  explicit StatusOrStream(Source source, StatusOrStreamOptions options = {})
+      : state_(std::make_shared<State>(std::move(source), options)),
+        worker_([state = state_] { state->Run(); }) {}
+
+  StatusOrStream(const StatusOrStream&) = delete;
+  StatusOrStream& operator=(const StatusOrStream&) = delete;
+
+  // Requires the GIL if the stream was iterated from python.
+  ~StatusOrStream() {
+    Close();
+    state_->ClearWaiter();
+  }
+
+  // Returns the next record. Raises StatusNotOk at the position of a non-ok
+  // status, then StopIteration. Requires the GIL.
+  object Next() {
+    object record;
+    absl::Status status;
+    switch (state_->Take(/*block=*/true, &record, &status)) {
+      case State::Outcome::kRecord:
+        return record;
+      case State::Outcome::kError:
+        internal::CheckStatusModuleImported();
+        PYBIND11_ABSEIL_STATUS_NOT_OK_STAT(status.code());
+        throw StatusNotOk(std::move(status));
+      default:
+        throw stop_iteration();
+    }
+  }
+
+  // Returns an asyncio future of the next record, for `async for`. Raises
+  // RuntimeError if the future returned by the previous call is still pending,
+  // as for asynchronous generators. Requires the GIL and a running event loop.
+  object ANext() {
+    if (anext_future_ && !anext_future_.attr("done")().cast<bool>()) {
+      throw std::runtime_error(
+          "anext(): the stream is already awaited by another __anext__().");
+    }
+    object loop = module_::import("asyncio").attr("get_running_loop")();
+    object future = loop.attr("create_future")();
+    State::Resolve(state_, loop, future);
+    anext_future_ = future;
+    return future;
+  }
+
+  // Stops pulling the source, and ends the iteration after the batches already
+  // handed over. Waits for the worker thread, with the GIL released if held.
+  void Close() {
+    state_->Stop();
+    if (!worker_.joinable()) return;
+    if (PyGILState_Check()) {
+      gil_scoped_release release;
+      worker_.join();
+    } else {
+      worker_.join();
+    }
+  }
+
+ private:
+  std::shared_ptr<State> state_;
+  std::thread worker_;
+  // The future returned by the last ANext(). Requires the GIL.
+  object anext_future_;
+};
+
+// Returns a StatusOrStream over the records returned by source, a callable
+// returning absl::StatusOr<O> where O is std::optional<Record> or
+// absl::optional<Record>.
+template <typename Record, typename Source>
+std::unique_ptr<StatusOrStream<Record>> MakeStatusOrStream(
+    Source source, StatusOrStreamOptions options = {}) {
+  return std::make_unique<StatusOrStream<Record>>(
+      [source = std::move(source)]() mutable
+      -> absl::StatusOr<absl::optional<Record>> {
+        auto next = source();
+        if (!next.ok()) return std::move(next).status();
+        if (!next->has_value()) return absl::optional<Record>();
+        return absl::optional<Record>(std::move(**next));
+      },
+      options);
+}
+
+// Binds StatusOrStream<Record> as a python iterator and asynchronous iterator,
+// with a close() method.
+template <typename Record>
+class_<StatusOrStream<Record>> bind_statusor_stream(handle scope,
+                                                    const std::string& name) {
+  using Stream = StatusOrStream<Record>;
+  class_<Stream> cl(scope, name.c_str());
+  cl.def("__iter__", [](object self) { return self; });
+  cl.def("__next__", &Stream::Next);
+  cl.def("__aiter__", [](object self) { return self; });
+  cl.def("__anext__", &Stream::ANext);
+  cl.def("close", &Stream::Close,
+         "Stops pulling records. The batches already handed over are still "
+         "returned.");
+  return cl;
+}
+
+}  // namespace google
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_STATUSOR_STREAM_H_
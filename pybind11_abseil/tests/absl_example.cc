@@ -4,23 +4,42 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include <pybind11/complex.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 
+#include <algorithm>
 #include <complex>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <variant>
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
+#include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/civil_time.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "pybind11_abseil/absl_arrow.h"
 #include "pybind11_abseil/absl_casters.h"
+#include "pybind11_abseil/absl_columnar.h"
+#include "pybind11_abseil/absl_container_bind.h"
+#include "pybind11_abseil/dlpack.h"
+#include "pybind11_abseil/instrumented_binding.h"
 
 namespace pybind11 {
 namespace test {
@@ -125,6 +144,50 @@ bool CheckStringView(absl::string_view view, const std::string& values) {
   return view == values;
 }
 
+bytes StringViewBytes(absl::string_view view) {
+  return bytes(view.data(), view.size());
+}
+
+bytes BytesViewBytes(google::BytesView view) {
+  return StringViewBytes(view);
+}
+
+std::string JoinStringViews(absl::Span<const absl::string_view> views) {
+  return absl::StrJoin(views, "|");
+}
+
+// Calls callback before reading views, which must not have been overwritten.
+std::string JoinStringViewsAfter(absl::Span<const absl::string_view> views,
+                                 const object& callback) {
+  callback();
+  return JoinStringViews(views);
+}
+
+// Returns true if the views of the bytes items reference their data.
+bool StringViewsReferenceBytes(absl::Span<const absl::string_view> views,
+                               handle sequence) {
+  PyObject** items = PySequence_Fast_ITEMS(sequence.ptr());
+  for (size_t i = 0; i < views.size(); ++i) {
+    if (PyBytes_Check(items[i]) &&
+        views[i].data() != PyBytes_AS_STRING(items[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Spans of bytes, loaded from any buffer of bytes.
+template <typename Byte>
+int SumBytes(absl::Span<const Byte> span) {
+  int result = 0;
+  for (Byte byte : span) result += static_cast<unsigned char>(byte);
+  return result;
+}
+
+void FillBytes(uint8_t value, absl::Span<uint8_t> output_span) {
+  for (uint8_t& byte : output_span) byte = value;
+}
+
 // Since a string view does not own its data, we must create a class to own
 // them and persist beyond the function that constructs the span for testing.
 class StringContainer {
@@ -222,6 +285,119 @@ bool CheckNodeHashSet(const absl::node_hash_set<int>& set,
   return set == check;
 }
 
+double SumInt64ToDoubleMap(const absl::flat_hash_map<int64_t, double>& map) {
+  double sum = 0;
+  for (const auto& kvp : map) {
+    sum += static_cast<double>(kvp.first) + kvp.second;
+  }
+  return sum;
+}
+
+int64_t SumStringViewToInt64Map(
+    const absl::flat_hash_map<absl::string_view, int64_t>& map,
+    absl::string_view key_prefix) {
+  int64_t sum = 0;
+  for (const auto& kvp : map) {
+    if (absl::StartsWith(kvp.first, key_prefix)) {
+      sum += kvp.second;
+    }
+  }
+  return sum;
+}
+
+absl::flat_hash_map<int64_t, double> MakeInt64ToDoubleMap(int size) {
+  absl::flat_hash_map<int64_t, double> map;
+  for (int i = 0; i < size; ++i) {
+    map[i] = i * 0.5;
+  }
+  return map;
+}
+
+// Elements 0, 3, 6, ... are errors.
+std::vector<absl::StatusOr<int64_t>> MakeStatusOrInt64s(int size) {
+  std::vector<absl::StatusOr<int64_t>> values;
+  for (int i = 0; i < size; ++i) {
+    if (i % 3 == 0) {
+      values.push_back(absl::NotFoundError("missing"));
+    } else {
+      values.push_back(i);
+    }
+  }
+  return values;
+}
+
+double SumArrowDoubles(const google::ArrowColumn<double>& column) {
+  double sum = 0;
+  for (double value : column.values()) sum += value;
+  return sum;
+}
+
+// The values, with None for nulls.
+list ArrowInt64sWithNulls(const google::ArrowColumn<int64_t>& column) {
+  list result;
+  for (std::size_t i = 0; i < column.size(); ++i) {
+    if (column.is_valid(i)) {
+      result.append(column[i]);
+    } else {
+      result.append(none());
+    }
+  }
+  return result;
+}
+
+absl::btree_map<int, int> MakeReversedBtreeMap(int size) {
+  absl::btree_map<int, int> map;
+  for (int i = size - 1; i >= 0; --i) {
+    map[i] = -i;
+  }
+  return map;
+}
+
+std::vector<std::string> SortedStringSet(
+    const absl::node_hash_set<std::string>& set) {
+  std::vector<std::string> sorted(set.begin(), set.end());
+  std::sort(sorted.begin(), sorted.end());
+  return sorted;
+}
+
+// Bound opaquely with absl_container_bind.h (see PYBIND11_MAKE_OPAQUE below).
+using OpaqueStringToDoubleMap = absl::flat_hash_map<std::string, double>;
+using OpaqueInt64ToStringMap = absl::node_hash_map<int64_t, std::string>;
+using OpaqueStringSet = absl::flat_hash_set<std::string>;
+
+// A bound (non-converted) value, returned by reference or by copy.
+struct OpaqueValue {
+  int value;
+};
+using OpaqueStringToValueMap = absl::flat_hash_map<std::string, OpaqueValue>;
+using OpaqueInt64ToValueMap = absl::node_hash_map<int64_t, OpaqueValue>;
+
+double SumOpaqueMapValues(const OpaqueStringToDoubleMap& map) {
+  double sum = 0;
+  for (const auto& kvp : map) {
+    sum += kvp.second;
+  }
+  return sum;
+}
+
+void ScaleOpaqueMapValues(double factor, OpaqueStringToDoubleMap& map) {
+  for (auto& kvp : map) {
+    kvp.second *= factor;
+  }
+}
+
+OpaqueStringToDoubleMap MakeOpaqueMap(int size) {
+  OpaqueStringToDoubleMap map;
+  for (int i = 0; i < size; ++i) {
+    map[absl::StrCat("key", i)] = i;
+  }
+  return map;
+}
+
+bool OpaqueSetContains(const OpaqueStringSet& set, absl::string_view key) {
+  return set.contains(key);
+}
+
 absl::btree_map<int, int> MakeBtreeMap(
     const std::vector<std::pair<int, int>>& keys_and_values) {
   absl::btree_map<int, int> map;
@@ -245,6 +421,95 @@ bool CheckBtreeMap(const absl::btree_map<int, int>& map,
   return true;
 }
 
+absl::btree_set<int> MakeBtreeSet(const std::vector<int>& values) {
+  return absl::btree_set<int>(values.begin(), values.end());
+}
+
+bool CheckBtreeSet(const absl::btree_set<int>& set,
+                   const std::vector<int>& values) {
+  return set == absl::btree_set<int>(values.begin(), values.end());
+}
+
+absl::btree_multiset<int> MakeBtreeMultiset(const std::vector<int>& values) {
+  return absl::btree_multiset<int>(values.begin(), values.end());
+}
+
+bool CheckBtreeMultiset(const absl::btree_multiset<int>& set,
+                        const std::vector<int>& values) {
+  return set == absl::btree_multiset<int>(values.begin(), values.end());
+}
+
+absl::btree_multimap<int, std::string> MakeBtreeMultimap(
+    const std::vector<std::pair<int, std::string>>& keys_and_values) {
+  return absl::btree_multimap<int, std::string>(keys_and_values.begin(),
+                                                keys_and_values.end());
+}
+
+bool CheckBtreeMultimap(
+    const absl::btree_multimap<int, std::string>& map,
+    const std::vector<std::pair<int, std::string>>& keys_and_values) {
+  return map == absl::btree_multimap<int, std::string>(keys_and_values.begin(),
+                                                       keys_and_values.end());
+}
+
+using InlinedDoubles = absl::InlinedVector<double, 4>;
+using FixedInts = absl::FixedArray<int64_t, 4>;
+
+double SumInlinedVector(const InlinedDoubles& values) {
+  double result = 0;
+  for (double v : values) result += v;
+  return result;
+}
+
+int64_t SumFixedArray(const FixedInts& values) {
+  int64_t result = 0;
+  for (int64_t v : values) result += v;
+  return result;
+}
+
+// Whether the items of array are stored in the array object itself, i.e. were
+// loaded without allocating.
+template <typename Array>
+bool IsInline(const Array& array) {
+  auto begin = reinterpret_cast<const char*>(&array);
+  auto data = reinterpret_cast<const char*>(array.data());
+  return data >= begin && data < begin + sizeof(Array);
+}
+
+InlinedDoubles MakeInlinedVector(int size) {
+  InlinedDoubles result;
+  for (int i = 0; i < size; ++i) result.push_back(i + 0.5);
+  return result;
+}
+
+FixedInts MakeFixedArray(int size) {
+  FixedInts result(static_cast<std::size_t>(size));
+  for (int i = 0; i < size; ++i) result[i] = i;
+  return result;
+}
+
+std::string JoinInlinedStrings(
+    const absl::InlinedVector<std::string, 2>& values) {
+  return absl::StrJoin(values, ",");
+}
+
+// Arrays returned by reference_internal, as memoryviews.
+struct ArrayHolder {
+  InlinedDoubles values = {0.5, 1.5};
+  absl::FixedArray<int32_t> counts = absl::FixedArray<int32_t>(3, 0);
+};
+
+// Bound opaquely with absl_container_bind.h (see PYBIND11_MAKE_OPAQUE below).
+using OpaqueStringToIntBtreeMap = absl::btree_map<std::string, int>;
+
+OpaqueStringToIntBtreeMap MakeOpaqueBtreeMap(int size) {
+  OpaqueStringToIntBtreeMap map;
+  for (int i = 0; i < size; ++i) {
+    map[absl::StrCat("key", i)] = i;
+  }
+  return map;
+}
+
 // Span
 bool CheckSpan(absl::Span<const int> span, const std::vector<int>& values) {
   if (span.size() != values.size()) return false;
@@ -279,6 +544,13 @@ std::string PassSpanPyObjectPtr(absl::Span<PyObject*> input_span) {
   return result;
 }
 
+// Returns true if span references the items of sequence, a list or tuple.
+bool SpanReferencesItems(absl::Span<PyObject* const> span, handle sequence) {
+  return span.data() == PySequence_Fast_ITEMS(sequence.ptr()) &&
+         span.size() ==
+             static_cast<size_t>(PySequence_Fast_GET_SIZE(sequence.ptr()));
+}
+
 std::string PassSpanBool(absl::Span<bool> input_span) {
   std::string result;
   for (const auto& i : input_span) result += (i ? "t" : "f");
@@ -317,6 +589,38 @@ int SumObjectSpan(absl::Span<const ObjectForSpan> span) {
   return result;
 }
 
+// Spans of structs, loaded from numpy structured arrays (see span_buffer_struct
+// below).
+struct Point3f {
+  float x;
+  float y;
+  float z;
+};
+
+// Padded after tag.
+struct TaggedValue {
+  int8_t tag;
+  double value;
+};
+
+double SumPointsZ(absl::Span<const Point3f> points) {
+  double result = 0;
+  for (const Point3f& point : points) result += point.z;
+  return result;
+}
+
+void TranslatePointsX(float dx, absl::Span<Point3f> points) {
+  for (Point3f& point : points) point.x += dx;
+}
+
+double SumTaggedValues(absl::Span<const TaggedValue> values, int tag) {
+  double result = 0;
+  for (const TaggedValue& value : values) {
+    if (value.tag == tag) result += value.value;
+  }
+  return result;
+}
+
 // absl::variant
 struct A {
   int a;
@@ -356,10 +660,59 @@ bool CheckVariant(const absl::variant<absl::monostate, int> variant,
 absl::variant<absl::monostate, int> MakeVariant() { return {}; }
 absl::variant<absl::monostate, int> MakeVariant(int value) { return value; }
 
+// The alternatives are tried in order; the index reports which one was loaded.
+using WideVariant = absl::variant<int64_t, double, std::string, absl::Time,
+                                  absl::Duration, std::vector<float>>;
+using IntVariant = absl::variant<int8_t, int64_t>;
+using VectorVariant = absl::variant<std::vector<int>, std::vector<double>>;
+using BytesOrInts = absl::variant<google::BytesView, std::vector<int>>;
+// A std::variant (even if absl::variant is not an alias for it), where the
+// Duration caster fails depending on the attributes of the object.
+using StdDurationOrDouble = std::variant<absl::Duration, double>;
+
+std::size_t WideVariantIndex(const WideVariant& variant) {
+  return variant.index();
+}
+std::size_t IntVariantIndex(const IntVariant& variant) {
+  return variant.index();
+}
+std::size_t VectorVariantIndex(const VectorVariant& variant) {
+  return variant.index();
+}
+std::size_t StdDurationOrDoubleIndex(const StdDurationOrDouble& variant) {
+  return variant.index();
+}
+object BytesOrIntsValue(const BytesOrInts& variant) {
+  if (const auto* view = absl::get_if<google::BytesView>(&variant)) {
+    return BytesViewBytes(*view);
+  }
+  return cast(absl::get<std::vector<int>>(variant));
+}
+
 }  // namespace test
+
+namespace google {
+
+template <>
+struct span_buffer_struct<test::Point3f> : std::true_type {};
+template <>
+struct span_buffer_struct<test::TaggedValue> : std::true_type {};
+
+}  // namespace google
 }  // namespace pybind11
 
 PYBIND11_MAKE_OPAQUE(std::vector<pybind11::test::ObjectForSpan>);
+PYBIND11_MAKE_OPAQUE(pybind11::test::OpaqueStringToDoubleMap);
+PYBIND11_MAKE_OPAQUE(pybind11::test::OpaqueInt64ToStringMap);
+PYBIND11_MAKE_OPAQUE(pybind11::test::OpaqueStringSet);
+PYBIND11_MAKE_OPAQUE(pybind11::test::OpaqueStringToValueMap);
+PYBIND11_MAKE_OPAQUE(pybind11::test::OpaqueInt64ToValueMap);
+PYBIND11_MAKE_OPAQUE(pybind11::test::OpaqueStringToIntBtreeMap);
+// Also exercises the type-cached caster if absl::variant is std::variant.
+PYBIND11_ABSEIL_TYPE_CACHED_VARIANT_CASTER(pybind11::test::WideVariant);
+PYBIND11_ABSEIL_TYPE_CACHED_VARIANT_CASTER(pybind11::test::BytesOrInts);
+PYBIND11_ABSEIL_TYPE_CACHED_VARIANT_CASTER(
+    pybind11::test::StdDurationOrDouble);
 
 namespace pybind11 {
 namespace test {
@@ -435,6 +788,10 @@ PYBIND11_MODULE(absl_example, m) {
   m.def("sum_span_const_complex128",
         &SumSpanComplex<const std::complex<double>>, arg("input_span"));
   m.def("pass_span_pyobject_ptr", &PassSpanPyObjectPtr, arg("span"));
+  m.def("span_references_items", &SpanReferencesItems, arg("span"),
+        arg("sequence"));
+  m.def("span_references_items_no_convert", &SpanReferencesItems,
+        arg("span").noconvert(), arg("sequence"));
   m.def("pass_span_bool", &PassSpanBool, arg("span"));
   m.def("pass_span_const_bool", &PassSpanConstBool, arg("span"));
 
@@ -450,8 +807,31 @@ PYBIND11_MODULE(absl_example, m) {
         arg("output_span"));
   m.def("fill_object_span", &FillObjectSpan, arg("value"), arg("output_span"));
 
+  // Spans of bytes.
+  m.def("sum_bytes_uint8", &SumBytes<uint8_t>, arg("span").noconvert());
+  m.def("sum_bytes_char", &SumBytes<char>, arg("span").noconvert());
+  m.def("sum_bytes_std_byte", &SumBytes<std::byte>, arg("span").noconvert());
+  m.def("fill_bytes", &FillBytes, arg("value"), arg("output_span"));
+
+  // Spans of structs.
+  PYBIND11_NUMPY_DTYPE(Point3f, x, y, z);
+  PYBIND11_NUMPY_DTYPE(TaggedValue, tag, value);
+  m.attr("POINT3F_DTYPE") = dtype::of<Point3f>();
+  m.attr("TAGGED_VALUE_DTYPE") = dtype::of<TaggedValue>();
+  m.def("sum_points_z", &SumPointsZ, arg("points").noconvert());
+  m.def("translate_points_x", &TranslatePointsX, arg("dx"), arg("points"));
+  m.def("sum_tagged_values", &SumTaggedValues, arg("values").noconvert(),
+        arg("tag"));
+
   // absl::string_view bindings.
   m.def("check_string_view", &CheckStringView, arg("view"), arg("values"));
+  m.def("string_view_bytes", &StringViewBytes, arg("view").noconvert());
+  m.def("bytes_view_bytes", &BytesViewBytes, arg("view").noconvert());
+  m.def("join_string_views", &JoinStringViews, arg("views"));
+  m.def("join_string_views_after", &JoinStringViewsAfter, arg("views"),
+        arg("callback"));
+  m.def("string_views_reference_bytes", &StringViewsReferenceBytes,
+        arg("views"), arg("sequence"));
   class_<StringContainer>(m, "StringContainer")
       .def(init())
       .def("make_string_view", &StringContainer::MakeStringView, arg("values"));
@@ -481,6 +861,111 @@ PYBIND11_MODULE(absl_example, m) {
   m.def("check_node_hash_map", &CheckNodeHashMap, arg("map"),
         arg("keys_and_values"));
 
+  m.def("sum_int64_to_double_map", &SumInt64ToDoubleMap, arg("map"));
+  m.def("sum_string_view_to_int64_map", &SumStringViewToInt64Map, arg("map"),
+        arg("key_prefix"));
+
+  // Columnar conversions (absl_columnar.h).
+  m.def(
+      "make_int64_to_double_map_columns",
+      [](int size) { return google::MapToColumns(MakeInt64ToDoubleMap(size)); },
+      arg("size"));
+  m.def(
+      "make_btree_map_columns",
+      [](int size) { return google::MapToColumns(MakeReversedBtreeMap(size)); },
+      arg("size"));
+  m.def("int32_to_float_map_from_columns",
+        &google::MapFromColumns<absl::flat_hash_map<int32_t, float>>,
+        arg("keys"), arg("values"));
+
+  // Arrow C data interface (absl_arrow.h).
+  m.def(
+      "make_arrow_doubles",
+      [](int size) {
+        std::vector<double> values(static_cast<std::size_t>(size));
+        for (int i = 0; i < size; ++i) values[i] = i * 0.5;
+        return google::ToArrowArray(std::move(values));
+      },
+      arg("size"));
+  m.def(
+      "make_arrow_bools",
+      [](std::vector<bool> values) { return google::ToArrowArray(values); },
+      arg("values"));
+  m.def(
+      "make_arrow_strings",
+      [](std::vector<std::string> values, bool binary) {
+        return google::ToArrowArray(std::move(values),
+                                    binary ? google::ArrowStringType::kBinary
+                                           : google::ArrowStringType::kUtf8);
+      },
+      arg("values"), arg("binary") = false);
+  m.def(
+      "make_arrow_times",
+      [](std::vector<absl::Time> values) {
+        return google::ToArrowArray(std::move(values));
+      },
+      arg("values"));
+  m.def(
+      "make_arrow_durations",
+      [](std::vector<absl::Duration> values) {
+        return google::ToArrowArray(std::move(values));
+      },
+      arg("values"));
+  m.def(
+      "make_arrow_statusor_int64s",
+      [](int size) { return google::ToArrowArray(MakeStatusOrInt64s(size)); },
+      arg("size"));
+  m.def(
+      "arrow_doubles_of",
+      [](const array_t<double, array::c_style>& values) {
+        return google::ToArrowArray(
+            absl::MakeConstSpan(values.data(),
+                                static_cast<std::size_t>(values.size())),
+            values);
+      },
+      arg("values"));
+  m.def("sum_arrow_doubles", &SumArrowDoubles, arg("column"));
+  m.def("arrow_int64s_with_nulls", &ArrowInt64sWithNulls, arg("column"));
+  m.def(
+      "arrow_bools",
+      [](const google::ArrowColumn<bool>& column) { return column.ToVector(); },
+      arg("column"));
+  m.def(
+      "arrow_strings",
+      [](const google::ArrowColumn<std::string>& column) {
+        return column.ToVector();
+      },
+      arg("column"));
+  m.def(
+      "arrow_times",
+      [](const google::ArrowColumn<absl::Time>& column) {
+        return column.ToVector();
+      },
+      arg("column"));
+  m.def(
+      "arrow_durations",
+      [](const google::ArrowColumn<absl::Duration>& column) {
+        return column.ToVector();
+      },
+      arg("column"));
+  m.def(
+      "arrow_doubles_identity",
+      [](const google::ArrowColumn<double>& column) { return column; },
+      arg("column"));
+
+  // DLPack (dlpack.h). Spans are imported by the absl::Span bindings above.
+  m.def(
+      "dlpack_ints_of",
+      [](array_t<int, array::c_style> values, bool read_only) {
+        auto span = absl::MakeSpan(values.mutable_data(),
+                                   static_cast<std::size_t>(values.size()));
+        if (read_only) {
+          return google::ToDLPack(absl::MakeConstSpan(span), values);
+        }
+        return google::ToDLPack(span, values);
+      },
+      arg("values"), arg("read_only") = false);
+
   // absl::flat_hash_set bindings
   m.def("make_set", &MakeSet, arg("values"));
   m.def("check_set", &CheckSet, arg("set"), arg("values"));
@@ -489,9 +974,61 @@ PYBIND11_MODULE(absl_example, m) {
   m.def("make_btree_map", &MakeBtreeMap, arg("keys_and_values"));
   m.def("check_btree_map", &CheckBtreeMap, arg("map"), arg("keys_and_values"));
 
+  // absl::btree_set, btree_multiset and btree_multimap bindings
+  m.def("make_btree_set", &MakeBtreeSet, arg("values"));
+  m.def("check_btree_set", &CheckBtreeSet, arg("set"), arg("values"));
+  m.def("make_btree_multiset", &MakeBtreeMultiset, arg("values"));
+  m.def("check_btree_multiset", &CheckBtreeMultiset, arg("set"),
+        arg("values"));
+  m.def("make_btree_multimap", &MakeBtreeMultimap, arg("keys_and_values"));
+  m.def("check_btree_multimap", &CheckBtreeMultimap, arg("map"),
+        arg("keys_and_values"));
+
+  // absl::InlinedVector and absl::FixedArray bindings
+  m.def("sum_inlined_vector", &SumInlinedVector, arg("values"));
+  m.def("sum_fixed_array", &SumFixedArray, arg("values"));
+  m.def("inlined_vector_is_inline", &IsInline<InlinedDoubles>, arg("values"));
+  m.def("fixed_array_is_inline", &IsInline<FixedInts>, arg("values"));
+  m.def("make_inlined_vector", &MakeInlinedVector, arg("size"));
+  m.def("make_fixed_array", &MakeFixedArray, arg("size"));
+  m.def("join_inlined_strings", &JoinInlinedStrings, arg("values"));
+  class_<ArrayHolder>(m, "ArrayHolder")
+      .def(init<>())
+      .def_readonly("values", &ArrayHolder::values)
+      .def_readonly("counts", &ArrayHolder::counts)
+      .def(
+          "mutable_counts",
+          [](ArrayHolder& self) -> absl::FixedArray<int32_t>& {
+            return self.counts;
+          },
+          return_value_policy::reference_internal);
+
   // absl::node_hash_set bindings
   m.def("make_node_hash_set", &MakeNodeHashSet, arg("values"));
   m.def("check_node_hash_set", &CheckNodeHashSet, arg("set"), arg("values"));
+  m.def("sorted_string_set", &SortedStringSet, arg("set"));
+
+  // Opaque absl container bindings (absl_container_bind.h).
+  google::bind_flat_hash_map<OpaqueStringToDoubleMap>(m,
+                                                      "StringToDoubleMap");
+  google::bind_node_hash_map<OpaqueInt64ToStringMap>(m, "Int64ToStringMap");
+  google::bind_flat_hash_set<OpaqueStringSet>(m, "StringSet");
+  class_<OpaqueValue>(m, "OpaqueValue")
+      .def(init<int>())
+      .def_readwrite("value", &OpaqueValue::value);
+  google::bind_flat_hash_map<OpaqueStringToValueMap>(m, "StringToValueMap");
+  google::bind_node_hash_map<OpaqueInt64ToValueMap>(m, "Int64ToValueMap");
+  m.def("sum_opaque_map_values", &SumOpaqueMapValues, arg("map"));
+  m.def("scale_opaque_map_values", &ScaleOpaqueMapValues, arg("factor"),
+        arg("map"));
+  m.def("make_opaque_map", &MakeOpaqueMap, arg("size"));
+  m.def("opaque_set_contains", &OpaqueSetContains, arg("set"), arg("key"));
+  google::bind_btree_map<OpaqueStringToIntBtreeMap>(m, "StringToIntBtreeMap");
+  m.def("make_opaque_btree_map", &MakeOpaqueBtreeMap, arg("size"));
+
+  // Traced in the same buffer as the bindings of other extension modules.
+  m.def("instrumented_noop",
+        google::Instrumented("absl_example.noop", []() {}));
 
   // absl::variant
   class_<A>(m, "A").def(init<int>()).def_readonly("a", &A::a);
@@ -508,6 +1045,12 @@ PYBIND11_MODULE(absl_example, m) {
   m.def("make_variant",
         (absl::variant<absl::monostate, int> (*)(int))&MakeVariant,
         arg("value"));
+  m.def("wide_variant_index", &WideVariantIndex, arg("variant"));
+  m.def("int_variant_index", &IntVariantIndex, arg("variant"));
+  m.def("vector_variant_index", &VectorVariantIndex, arg("variant"));
+  m.def("std_duration_or_double_index", &StdDurationOrDoubleIndex,
+        arg("variant"));
+  m.def("bytes_or_ints", &BytesOrIntsValue, arg("variant"));
 }
 
 }  // namespace test
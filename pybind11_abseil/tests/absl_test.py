@@ -5,11 +5,16 @@
 """Tests for absl pybind11 casters."""
 
 import array
+import collections.abc
 import contextlib
 import datetime
+import mmap
 import os
+import sys
+import tempfile
 import threading
 import time
+import types
 from typing import Iterator
 
 from absl.testing import absltest
@@ -397,6 +402,23 @@ class AbslNumericSpanTest(parameterized.TestCase):
     arr = np.array([-3, 'four', 5.0], dtype=object)
     self.assertEqual(absl_example.pass_span_pyobject_ptr(arr), '-3four5.0')
 
+  @parameterized.named_parameters(
+      ('list', [-3, 'four', 5.0]),
+      ('tuple', (-3, 'four', 5.0)),
+      ('empty_list', []),
+      ('empty_tuple', ()),
+  )
+  def test_pass_span_pyobject_ptr_const_references_items(self, items):
+    self.assertTrue(absl_example.span_references_items(items, items))
+
+  @parameterized.named_parameters(
+      ('list', [-3, 'four', 5.0]),
+      ('tuple', (-3, 'four', 5.0)),
+  )
+  def test_pass_span_pyobject_ptr_const_no_convert_fails(self, items):
+    with self.assertRaises(TypeError):
+      absl_example.span_references_items_no_convert(items, items)
+
   @parameterized.parameters(
       ([], ''),
       ([False], 'f'),
@@ -470,6 +492,160 @@ class AbslObjectSpanTest(parameterized.TestCase):
       absl_example.fill_object_span(objects)
 
 
+def make_points(num_points, dtype=None):
+  points = np.zeros(num_points, dtype=dtype or absl_example.POINT3F_DTYPE)
+  points['z'] = np.arange(num_points)
+  return points
+
+
+class AbslStructSpanTest(parameterized.TestCase):
+
+  def test_pass_span_from_registered_dtype(self):
+    self.assertEqual(absl_example.sum_points_z(make_points(4)), 6)
+    # Again, with the format of the buffer known to match.
+    self.assertEqual(absl_example.sum_points_z(make_points(5)), 10)
+
+  def test_pass_span_from_equivalent_dtype(self):
+    dtype = np.dtype([('x', np.float32), ('y', np.float32),
+                      ('z', np.float32)])
+    self.assertEqual(absl_example.sum_points_z(make_points(4, dtype)), 6)
+
+  def test_fill_span_shares_memory(self):
+    points = make_points(3)
+    absl_example.translate_points_x(1.5, points)
+    self.assertEqual(points['x'].tolist(), [1.5] * 3)
+
+  def test_padded_struct(self):
+    values = np.zeros(3, dtype=absl_example.TAGGED_VALUE_DTYPE)
+    values['tag'] = [1, 2, 2]
+    values['value'] = [0.25, 0.5, 1.0]
+    self.assertEqual(absl_example.sum_tagged_values(values, 2), 1.5)
+
+  @parameterized.named_parameters(
+      ('other_names', np.zeros(2, dtype=[('x', np.float32), ('y', np.float32),
+                                         ('w', np.float32)])),
+      ('other_types', np.zeros(2, dtype=[('x', np.float64), ('y', np.float64),
+                                         ('z', np.float64)])),
+      ('strided', make_points(4)[::2]),
+      ('two_d', np.zeros((2, 2), dtype=absl_example.POINT3F_DTYPE)),
+      ('floats', np.zeros(6, dtype=np.float32)),
+  )
+  def test_pass_span_fails_from(self, values):
+    with self.assertRaises(TypeError):
+      absl_example.sum_points_z(values)
+    with self.assertRaises(TypeError):
+      absl_example.translate_points_x(1.0, values)
+
+  def test_fill_span_fails_from_read_only(self):
+    points = make_points(2)
+    points.flags.writeable = False
+    self.assertEqual(absl_example.sum_points_z(points), 1)
+    with self.assertRaises(TypeError):
+      absl_example.translate_points_x(1.0, points)
+
+
+class DLPackOnly:
+  """Exposes a numpy array with the DLPack protocol only, not as a buffer."""
+
+  def __init__(self, values):
+    self._values = values
+
+  def __dlpack__(self, **kwargs):
+    return self._values.__dlpack__(**kwargs)
+
+  def __dlpack_device__(self):
+    return self._values.__dlpack_device__()
+
+
+class LegacyDLPackOnly(DLPackOnly):
+  """A producer implementing DLPack < 1.0: no max_version parameter."""
+
+  def __dlpack__(self, stream=None):
+    return self._values.__dlpack__(stream=stream)
+
+
+def numpy_implements_dlpack_1():
+  return np.lib.NumpyVersion(np.__version__) >= '2.1.0'
+
+
+@absltest.skipUnless(
+    hasattr(np.ndarray, '__dlpack__'), 'numpy does not implement DLPack.')
+class AbslDLPackSpanTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(
+      ('versioned', DLPackOnly), ('legacy', LegacyDLPackOnly))
+  def test_pass_span_from(self, producer):
+    values = producer(np.array([7, 8, 9], dtype=np.int32))
+    self.assertTrue(absl_example.check_span(values, [7, 8, 9]))
+    self.assertTrue(absl_example.check_span_no_convert(values, [7, 8, 9]))
+
+  @parameterized.named_parameters(
+      ('versioned', DLPackOnly), ('legacy', LegacyDLPackOnly))
+  def test_fill_span_from(self, producer):
+    values = np.zeros(5, dtype=np.int32)
+    absl_example.fill_span(42, producer(values))
+    self.assertEqual(values.tolist(), [42] * 5)
+
+  @parameterized.named_parameters(
+      ('wrong_dtype', np.zeros(5, dtype=np.uint32)),
+      ('two_d', np.zeros((5, 5), dtype=np.int32)),
+      ('read_only', make_read_only_numpy_array()),
+      ('strided_skip', make_strided_numpy_array(2)),
+      ('strided_reverse', make_strided_numpy_array(-1)),
+  )
+  def test_fill_span_fails_from(self, values):
+    with self.assertRaises(TypeError):
+      absl_example.fill_span(42, DLPackOnly(values))
+
+  def test_pass_const_span_from_read_only(self):
+    if not numpy_implements_dlpack_1():
+      self.skipTest('numpy cannot export read-only arrays with DLPack < 1.0.')
+    values = make_read_only_numpy_array()
+    self.assertTrue(absl_example.check_span(DLPackOnly(values), [0] * 5))
+
+  def test_complex(self):
+    xs = np.array([x * 1j for x in range(10)], dtype=np.complex128)
+    self.assertEqual(absl_example.sum_span_const_complex128(DLPackOnly(xs)),
+                     45j)
+
+  def test_export(self):
+    values = np.arange(4, dtype=np.int32)
+    exported = absl_example.dlpack_ints_of(values)
+    self.assertLen(exported, 4)
+    self.assertEqual(exported.__dlpack_device__(), (1, 0))
+    self.assertIn('dltensor', repr(exported.__dlpack__()))
+    self.assertTrue(absl_example.check_span(exported, [0, 1, 2, 3]))
+    # The memory is shared, not copied.
+    absl_example.fill_span(5, exported)
+    self.assertEqual(values.tolist(), [5] * 4)
+
+  def test_export_to_numpy_keeps_owner_alive(self):
+    values = np.arange(4, dtype=np.int32)
+    imported = np.from_dlpack(absl_example.dlpack_ints_of(values))
+    del values
+    self.assertEqual(imported.tolist(), [0, 1, 2, 3])
+
+  def test_export_read_only(self):
+    exported = absl_example.dlpack_ints_of(
+        np.arange(3, dtype=np.int32), read_only=True)
+    with self.assertRaises(BufferError):
+      exported.__dlpack__()
+    self.assertIn('dltensor_versioned',
+                  repr(exported.__dlpack__(max_version=(1, 0))))
+    self.assertTrue(absl_example.check_span(exported, [0, 1, 2]))
+    with self.assertRaises(TypeError):
+      absl_example.fill_span(5, exported)
+    if numpy_implements_dlpack_1():
+      self.assertFalse(np.from_dlpack(exported).flags.writeable)
+
+  def test_export_rejects_other_devices(self):
+    exported = absl_example.dlpack_ints_of(np.arange(3, dtype=np.int32))
+    with self.assertRaises(BufferError):
+      exported.__dlpack__(max_version=(1, 0), dl_device=(2, 0))
+    with self.assertRaises(BufferError):
+      exported.__dlpack__(max_version=(1, 0), copy=True)
+
+
 class AbslStringViewTest(absltest.TestCase):
   TEST_STRING = 'test string!'
 
@@ -483,6 +659,130 @@ class AbslStringViewTest(absltest.TestCase):
         absl_example.check_string_view(self.TEST_STRING, self.TEST_STRING))
 
 
+class _StrSubclass(str):
+  pass
+
+
+def make_bytes_buffers():
+  data = b'\x01\x02\xff'
+  return (
+      ('bytes', data),
+      ('bytearray', bytearray(data)),
+      ('memoryview', memoryview(data)),
+      ('array', array.array('B', data)),
+      ('numpy_int8', np.frombuffer(data, dtype=np.int8)),
+      ('numpy_2d', np.frombuffer(data * 2, dtype=np.uint8).reshape(2, 3)),
+  )
+
+
+class AbslBytesBufferTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(*make_bytes_buffers())
+  def test_pass_bytes_span_from(self, buffer):
+    expected = sum(bytes(buffer))
+    self.assertEqual(absl_example.sum_bytes_uint8(buffer), expected)
+    self.assertEqual(absl_example.sum_bytes_char(buffer), expected)
+    self.assertEqual(absl_example.sum_bytes_std_byte(buffer), expected)
+
+  @parameterized.named_parameters(*make_bytes_buffers())
+  def test_pass_bytes_view_from(self, buffer):
+    self.assertEqual(absl_example.bytes_view_bytes(buffer), bytes(buffer))
+
+  @parameterized.named_parameters(
+      ('bytes', b'\x01\x02'),
+      ('bytearray', bytearray(b'\x01\x02')),
+  )
+  def test_pass_string_view_from(self, value):
+    self.assertEqual(absl_example.string_view_bytes(value), bytes(value))
+
+  @parameterized.named_parameters(
+      ('memoryview', memoryview(b'\x01\x02')),
+      ('array', array.array('B', b'\x01\x02')),
+  )
+  def test_string_view_does_not_load_buffers(self, buffer):
+    # Only google::BytesView opts in to loading buffers.
+    with self.assertRaises(TypeError):
+      absl_example.string_view_bytes(buffer)
+
+  @parameterized.named_parameters(
+      ('list', [b'ab', b'', 'cd', '\u00e4']),
+      ('tuple', (b'ab', b'', 'cd', '\u00e4')),
+  )
+  def test_pass_span_of_string_views_from(self, items):
+    self.assertEqual(absl_example.join_string_views(items), 'ab||cd|\u00e4')
+    self.assertTrue(absl_example.string_views_reference_bytes(items, items))
+
+  @parameterized.named_parameters(
+      ('bytearray', [bytearray(b'ab'), 'cd']),
+      ('str_subclass', [_StrSubclass('ab'), 'cd']),
+  )
+  def test_pass_span_of_string_views_converts(self, items):
+    self.assertEqual(absl_example.join_string_views(items), 'ab|cd')
+
+  def test_pass_span_of_string_views_fails_from(self):
+    with self.assertRaises(TypeError):
+      absl_example.join_string_views(['ab', 1])
+
+  def test_nested_spans_of_string_views(self):
+    inner = []
+    outer = absl_example.join_string_views_after(
+        ['a', 'b'],
+        lambda: inner.append(absl_example.join_string_views(['x', 'y', 'z'])))
+    self.assertEqual(outer, 'a|b')
+    self.assertEqual(inner, ['x|y|z'])
+
+  def test_pass_string_view_from_str(self):
+    self.assertEqual(absl_example.string_view_bytes('\u00e4'), b'\xc3\xa4')
+    self.assertEqual(absl_example.bytes_view_bytes('\u00e4'), b'\xc3\xa4')
+
+  def test_mmap(self):
+    with tempfile.TemporaryFile() as f:
+      f.write(b'mapped')
+      f.flush()
+      mapped = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+      self.assertEqual(absl_example.bytes_view_bytes(mapped), b'mapped')
+      self.assertEqual(absl_example.sum_bytes_char(mapped), sum(b'mapped'))
+      # The buffer was released: the mapping can be closed.
+      mapped.close()
+
+  def test_fill_bytes(self):
+    buffer = bytearray(3)
+    absl_example.fill_bytes(7, buffer)
+    self.assertEqual(buffer, bytearray(b'\x07' * 3))
+
+  @parameterized.named_parameters(
+      ('read_only', b'abc'),
+      ('not_contiguous', memoryview(bytearray(b'abcdef'))[::2]),
+  )
+  def test_fill_bytes_fails_from(self, buffer):
+    with self.assertRaises(TypeError):
+      absl_example.fill_bytes(7, buffer)
+
+  @parameterized.named_parameters(
+      ('not_contiguous', memoryview(b'abcdef')[::2]),
+      ('int16', np.zeros(3, dtype=np.int16)),
+      ('list', [1, 2, 3]),
+  )
+  def test_pass_bytes_fails_from(self, buffer):
+    with self.assertRaises(TypeError):
+      absl_example.sum_bytes_uint8(buffer)
+    with self.assertRaises(TypeError):
+      absl_example.bytes_view_bytes(buffer)
+
+  def test_bytes_view_variant_mixed_memoryviews(self):
+    ints = memoryview(array.array('i', [1, 2, 3]))
+    chars = memoryview(b'abc')
+    strided = memoryview(b'abcdef')[::2]
+    # Whether BytesView loads a memoryview depends on its items and strides,
+    # not only on its type: later rounds must not reuse the alternative that
+    # loaded another memoryview.
+    for _ in range(3):
+      self.assertEqual(absl_example.bytes_or_ints(ints), [1, 2, 3])
+      self.assertEqual(absl_example.bytes_or_ints(chars), b'abc')
+      self.assertEqual(absl_example.bytes_or_ints(strided), [97, 99, 101])
+    self.assertEqual(absl_example.bytes_or_ints([4, 5]), [4, 5])
+
+
 class AbslCordTest(absltest.TestCase):
   TEST_STRING = 'absl_Cord'
   TEST_BYTES = b'absl_Cord'
@@ -526,6 +826,199 @@ class AbslFlatHashMapTest(absltest.TestCase):
     self.assertTrue(absl_example.check_map(dict(expected), expected))
 
 
+class AbslHashMapFastPathTest(absltest.TestCase):
+
+  def test_int64_keys(self):
+    self.assertEqual(
+        absl_example.sum_int64_to_double_map({1: 2.5, -2: 3.5}), 5.0)
+
+  def test_int_value_converts_to_double(self):
+    self.assertEqual(absl_example.sum_int64_to_double_map({1: 2}), 3.0)
+
+  def test_int64_key_overflow(self):
+    with self.assertRaises(TypeError):
+      absl_example.sum_int64_to_double_map({2**63: 1.0})
+
+  def test_int_subclass_keys(self):
+
+    class MyInt(int):
+      pass
+
+    self.assertEqual(absl_example.sum_int64_to_double_map({MyInt(4): 0.5}),
+                     4.5)
+
+  def test_string_view_keys(self):
+    self.assertEqual(
+        absl_example.sum_string_view_to_int64_map(
+            {'ab': 1, b'ac': 2, 'b': 4, '\u00e4': 8}, 'a'), 3)
+
+  def test_non_string_key_fails(self):
+    with self.assertRaises(TypeError):
+      absl_example.sum_string_view_to_int64_map({1: 1}, '')
+
+  def test_string_set(self):
+    self.assertEqual(
+        absl_example.sorted_string_set({'b', b'a', '\u00e4'}),
+        ['a', 'b', '\u00e4'])
+
+
+class AbslMapColumnsTest(absltest.TestCase):
+
+  def test_load_from_columns(self):
+    keys = np.arange(5, dtype=np.int64)
+    values = np.full(5, 0.5)
+    self.assertEqual(
+        absl_example.sum_int64_to_double_map((keys, values)), 10 + 2.5)
+
+  def test_load_large_from_columns(self):
+    size = 1 << 15  # Loaded with the GIL released.
+    keys = np.arange(size, dtype=np.int64)
+    values = np.ones(size)
+    self.assertEqual(
+        absl_example.sum_int64_to_double_map((keys, values)),
+        size * (size - 1) // 2 + size)
+
+  def test_duplicate_keys_last_wins(self):
+    keys = np.array([1, 1], dtype=np.int64)
+    values = np.array([1.0, 2.0])
+    self.assertEqual(
+        absl_example.sum_int64_to_double_map((keys, values)), 3.0)
+
+  def test_dtype_mismatch(self):
+    keys = np.arange(2, dtype=np.int32)
+    with self.assertRaises(TypeError):
+      absl_example.sum_int64_to_double_map((keys, np.ones(2)))
+
+  def test_length_mismatch(self):
+    keys = np.arange(2, dtype=np.int64)
+    with self.assertRaises(TypeError):
+      absl_example.sum_int64_to_double_map((keys, np.ones(3)))
+
+  def test_non_buffer_tuple(self):
+    with self.assertRaises(TypeError):
+      absl_example.sum_int64_to_double_map(([1, 2], [1.0, 2.0]))
+
+  def test_btree_map_from_columns(self):
+    keys = np.array([2, 1], dtype=np.intc)
+    values = np.array([4, 3], dtype=np.intc)
+    self.assertTrue(
+        absl_example.check_btree_map((keys, values), [(1, 3), (2, 4)]))
+
+  def test_map_to_columns(self):
+    keys, values = absl_example.make_int64_to_double_map_columns(4)
+    self.assertEqual(keys.dtype, np.int64)
+    self.assertEqual(values.dtype, np.float64)
+    self.assertEqual(
+        dict(zip(keys.tolist(), values.tolist())),
+        {0: 0.0, 1: 0.5, 2: 1.0, 3: 1.5})
+
+  def test_btree_map_to_sorted_columns(self):
+    keys, values = absl_example.make_btree_map_columns(4)
+    self.assertEqual(keys.tolist(), [0, 1, 2, 3])
+    self.assertEqual(values.tolist(), [0, -1, -2, -3])
+
+  def test_map_from_columns_converts_dtypes(self):
+    self.assertEqual(
+        absl_example.int32_to_float_map_from_columns(
+            [1, 2], np.array([0.5, 1.5])),
+        {1: 0.5, 2: 1.5})
+
+  def test_map_from_columns_length_mismatch(self):
+    with self.assertRaises(ValueError):
+      absl_example.int32_to_float_map_from_columns([1, 2], [0.5])
+
+
+class AbslArrowTest(absltest.TestCase):
+
+  def test_export_doubles(self):
+    doubles = absl_example.make_arrow_doubles(5)
+    self.assertLen(doubles, 5)
+    schema = doubles.__arrow_c_schema__()
+    self.assertEqual(type(schema).__name__, 'PyCapsule')
+    schema, array = doubles.__arrow_c_array__()
+    self.assertIn('arrow_schema', repr(schema))
+    self.assertIn('arrow_array', repr(array))
+    self.assertEqual(absl_example.sum_arrow_doubles(doubles), 5.0)
+    # Can be imported again.
+    self.assertEqual(absl_example.sum_arrow_doubles(doubles), 5.0)
+
+  def test_requested_schema_is_ignored(self):
+    doubles = absl_example.make_arrow_doubles(2)
+    schema, _ = doubles.__arrow_c_array__(requested_schema=None)
+    self.assertIsNotNone(schema)
+
+  def test_export_span_keeps_owner_alive(self):
+    values = np.arange(4, dtype=np.float64)
+    doubles = absl_example.arrow_doubles_of(values)
+    del values
+    self.assertEqual(absl_example.sum_arrow_doubles(doubles), 6.0)
+
+  def test_reexport_imported_column(self):
+    doubles = absl_example.arrow_doubles_identity(
+        absl_example.make_arrow_doubles(3))
+    self.assertLen(doubles, 3)
+    self.assertEqual(absl_example.sum_arrow_doubles(doubles), 1.5)
+
+  def test_bools(self):
+    values = [True, False, True] * 5
+    self.assertEqual(
+        absl_example.arrow_bools(absl_example.make_arrow_bools(values)),
+        values)
+
+  def test_strings(self):
+    values = ['', 'a', '\u00e4bc']
+    self.assertEqual(
+        absl_example.arrow_strings(absl_example.make_arrow_strings(values)),
+        values)
+    binary = absl_example.make_arrow_strings(values, binary=True)
+    self.assertEqual(absl_example.arrow_strings(binary), values)
+
+  def test_times_and_durations(self):
+    utc = datetime.timezone.utc
+    times = [
+        datetime.datetime(1970, 1, 1, tzinfo=utc),
+        datetime.datetime(2024, 2, 29, 12, 30, 1, 250, tzinfo=utc),
+    ]
+    self.assertEqual(
+        [t.timestamp() for t in absl_example.arrow_times(
+            absl_example.make_arrow_times(times))],
+        [t.timestamp() for t in times])
+    durations = [datetime.timedelta(seconds=-1),
+                 datetime.timedelta(microseconds=3)]
+    self.assertEqual(
+        absl_example.arrow_durations(
+            absl_example.make_arrow_durations(durations)),
+        durations)
+
+  def test_statusor_nulls(self):
+    column = absl_example.make_arrow_statusor_int64s(5)
+    self.assertEqual(
+        absl_example.arrow_int64s_with_nulls(column), [None, 1, 2, None, 4])
+
+  def test_type_mismatch(self):
+    with self.assertRaises(TypeError):
+      absl_example.sum_arrow_doubles(absl_example.make_arrow_strings(['a']))
+    with self.assertRaises(TypeError):
+      absl_example.sum_arrow_doubles([1.0, 2.0])
+
+  def test_pyarrow(self):
+    try:
+      import pyarrow  # pylint: disable=g-import-not-at-top
+    except ImportError:
+      self.skipTest('pyarrow is not installed.')
+    self.assertEqual(
+        pyarrow.array(absl_example.make_arrow_doubles(3)).to_pylist(),
+        [0.0, 0.5, 1.0])
+    self.assertEqual(
+        pyarrow.array(absl_example.make_arrow_statusor_int64s(4)).to_pylist(),
+        [None, 1, 2, None])
+    self.assertEqual(
+        absl_example.sum_arrow_doubles(pyarrow.array([1.0, 2.5])), 3.5)
+    self.assertEqual(
+        absl_example.arrow_strings(pyarrow.array(['x', 'yz']).slice(1)),
+        ['yz'])
+
+
 class AbslNodeHashMapTest(absltest.TestCase):
 
   def test_return_map(self):
@@ -574,6 +1067,425 @@ class AbslBTreeMapTest(absltest.TestCase):
     self.assertTrue(absl_example.check_btree_map(dict(expected), expected))
 
 
+class AbslContainerBindTest(absltest.TestCase):
+
+  def test_map_is_mutable_mapping(self):
+    m = absl_example.StringToDoubleMap()
+    self.assertIsInstance(m, collections.abc.MutableMapping)
+    self.assertEmpty(m)
+    self.assertFalse(m)
+
+  def test_map_item_access(self):
+    m = absl_example.StringToDoubleMap()
+    m['a'] = 1.5
+    m['b'] = 2.5
+    self.assertLen(m, 2)
+    self.assertEqual(m['a'], 1.5)
+    self.assertEqual(m[b'b'], 2.5)
+    self.assertIn('a', m)
+    self.assertIn(b'a', m)
+    self.assertNotIn('c', m)
+    self.assertNotIn(1, m)
+    with self.assertRaises(KeyError):
+      m['c']  # pylint: disable=pointless-statement
+    del m['a']
+    self.assertNotIn('a', m)
+    with self.assertRaises(KeyError):
+      del m['a']
+    self.assertEqual(dict(m.items()), {'b': 2.5})
+
+  def test_map_get_pop(self):
+    m = absl_example.StringToDoubleMap()
+    m['a'] = 1.0
+    self.assertEqual(m.get('a'), 1.0)
+    self.assertIsNone(m.get('x'))
+    self.assertEqual(m.get(b'x', 7.0), 7.0)
+    self.assertEqual(m.pop('x', 8.0), 8.0)
+    with self.assertRaises(KeyError):
+      m.pop('x')
+    self.assertEqual(m.pop(b'a'), 1.0)
+    self.assertEmpty(m)
+
+  def test_map_clear_reserve(self):
+    m = absl_example.make_opaque_map(10)
+    m.reserve(100)
+    self.assertLen(m, 10)
+    m.clear()
+    self.assertEmpty(m)
+
+  def test_map_passed_by_reference(self):
+    m = absl_example.make_opaque_map(4)
+    self.assertEqual(absl_example.sum_opaque_map_values(m), 6)
+    absl_example.scale_opaque_map_values(2, m)
+    self.assertEqual(m['key3'], 6)
+    self.assertEqual(absl_example.sum_opaque_map_values(m), 12)
+
+  def test_map_rejects_dict(self):
+    with self.assertRaises(TypeError):
+      absl_example.sum_opaque_map_values({'a': 1.0})
+
+  def test_node_hash_map(self):
+    m = absl_example.Int64ToStringMap()
+    self.assertIsInstance(m, collections.abc.MutableMapping)
+    m[1] = 'one'
+    m[2] = 'two'
+    self.assertEqual(m[1], 'one')
+    self.assertEqual(sorted(m), [1, 2])
+    self.assertEqual(m.get(3, 'three'), 'three')
+    self.assertEqual(m.pop(2), 'two')
+    self.assertLen(m, 1)
+
+  def test_map_update(self):
+    m = absl_example.StringToDoubleMap()
+    m.update({'a': 1.0, 'b': 2.0})
+    m.update([('b', 3.0), ['c', 4.0]])
+    m.update(d=5.0)
+    m.update()
+    self.assertEqual(dict(m), {'a': 1.0, 'b': 3.0, 'c': 4.0, 'd': 5.0})
+    with self.assertRaises(TypeError):
+      m.update({'e': 'not a double'})
+
+  def test_map_setdefault_popitem(self):
+    m = absl_example.StringToDoubleMap()
+    self.assertEqual(m.setdefault('a', 1.0), 1.0)
+    self.assertEqual(m.setdefault('a', 2.0), 1.0)
+    self.assertEqual(m['a'], 1.0)
+    self.assertEqual(m.popitem(), ('a', 1.0))
+    with self.assertRaises(KeyError):
+      m.popitem()
+
+  def test_map_eq(self):
+    m = absl_example.make_opaque_map(3)
+    self.assertEqual(m, {'key0': 0.0, 'key1': 1.0, 'key2': 2.0})
+    self.assertEqual(m, absl_example.make_opaque_map(3))
+    self.assertNotEqual(m, absl_example.make_opaque_map(2))
+    self.assertNotEqual(m, {'key0': 0.0, 'key1': 1.0, 'key2': 7.0})
+    self.assertNotEqual(m, [('key0', 0.0), ('key1', 1.0), ('key2', 2.0)])
+    with self.assertRaises(TypeError):
+      hash(m)
+
+  def test_map_views(self):
+    m = absl_example.make_opaque_map(2)
+    self.assertLen(m.keys(), 2)
+    self.assertIn('key1', m.keys())
+    self.assertEqual(sorted(m.values()), [0.0, 1.0])
+    self.assertIn(('key1', 1.0), m.items())
+    self.assertEqual(m.keys() | {'x'}, {'key0', 'key1', 'x'})
+
+  def test_flat_map_returns_copies(self):
+    m = absl_example.StringToValueMap()
+    m['a'] = absl_example.OpaqueValue(1)
+    value = m['a']
+    self.assertIsNot(m['a'], m['a'])
+    # Rehashes the map: value must not reference the moved item.
+    for i in range(100):
+      m[str(i)] = absl_example.OpaqueValue(i)
+    self.assertEqual(value.value, 1)
+    value.value = 2
+    self.assertEqual(m['a'].value, 1)
+    self.assertEqual(m.get('a').value, 1)
+    self.assertEqual([v.value for k, v in m.items() if k == 'a'], [1])
+
+  def test_node_map_returns_references(self):
+    m = absl_example.Int64ToValueMap()
+    m[1] = absl_example.OpaqueValue(1)
+    m[1].value = 2
+    self.assertEqual(m[1].value, 2)
+    m.get(1).value = 3
+    self.assertEqual(m.setdefault(1).value, 3)
+
+  def test_set(self):
+    s = absl_example.StringSet(['a', 'b'])
+    self.assertIsInstance(s, collections.abc.MutableSet)
+    self.assertLen(s, 2)
+    self.assertIn('a', s)
+    self.assertIn(b'b', s)
+    self.assertNotIn('c', s)
+    self.assertNotIn(3, s)
+    s.add('c')
+    self.assertEqual(sorted(s), ['a', 'b', 'c'])
+    self.assertTrue(absl_example.opaque_set_contains(s, 'c'))
+    s.discard('a')
+    s.discard(b'x')
+    with self.assertRaises(KeyError):
+      s.remove('a')
+    s.remove(b'b')
+    self.assertEqual(list(s), ['c'])
+    s.clear()
+    self.assertFalse(s)
+
+  def test_set_comparisons(self):
+    s = absl_example.StringSet(['a', 'b'])
+    self.assertEqual(s, {'a', 'b'})
+    self.assertEqual(s, absl_example.StringSet(['b', 'a']))
+    self.assertNotEqual(s, {'a'})
+    self.assertNotEqual(s, ['a', 'b'])
+    self.assertLessEqual(s, {'a', 'b'})
+    self.assertLess(s, {'a', 'b', 'c'})
+    self.assertFalse(s < {'a', 'b'})
+    self.assertGreaterEqual(s, frozenset(['a']))
+    self.assertGreater(s, {'a'})
+    self.assertFalse(s > {'a', 'c'})
+    self.assertTrue(s.isdisjoint(['c', 1]))
+    self.assertFalse(s.isdisjoint(iter(['c', 'a'])))
+    with self.assertRaises(TypeError):
+      hash(s)
+
+  def test_set_operators(self):
+    s = absl_example.StringSet(['a', 'b'])
+    union = s | ['c']
+    self.assertIsInstance(union, absl_example.StringSet)
+    self.assertEqual(union, {'a', 'b', 'c'})
+    self.assertEqual(['c'] | s, {'a', 'b', 'c'})
+    self.assertEqual(s & {'b', 'c', 1}, {'b'})
+    self.assertEqual({'b', 'c'} & s, {'b'})
+    self.assertEqual(s - ['b'], {'a'})
+    self.assertEqual({'b', 'c'} - s, {'c'})
+    self.assertEqual(s ^ iter(['b', 'c']), {'a', 'c'})
+    self.assertEqual({'b', 'c'} ^ s, {'a', 'c'})
+    self.assertEqual(s, {'a', 'b'})
+    with self.assertRaises(TypeError):
+      s | 1  # pylint: disable=pointless-statement
+
+  def test_set_in_place_operators(self):
+    s = absl_example.StringSet(['a', 'b'])
+    t = s
+    s |= ['c']
+    self.assertIs(s, t)
+    self.assertEqual(s, {'a', 'b', 'c'})
+    s &= iter(['a', 'c', 'd'])
+    self.assertEqual(s, {'a', 'c'})
+    s -= ['a', 1]
+    self.assertEqual(s, {'c'})
+    s ^= ['c', 'd', 'd']
+    self.assertEqual(s, {'d'})
+    s ^= s
+    self.assertEqual(s, set())
+    s |= ['e']
+    s -= s
+    self.assertIs(s, t)
+    self.assertFalse(s)
+
+  def test_set_pop(self):
+    s = absl_example.StringSet(['a'])
+    self.assertEqual(s.pop(), 'a')
+    with self.assertRaises(KeyError):
+      s.pop()
+
+
+class AbslBTreeSetTest(absltest.TestCase):
+
+  def test_return_set(self):
+    self.assertEqual({1, 3, 5}, absl_example.make_btree_set([5, 3, 1, 3]))
+
+  def test_pass_set(self):
+    expected = [10, 20, 30, 40]
+    self.assertTrue(absl_example.check_btree_set(set(expected), expected))
+    self.assertTrue(
+        absl_example.check_btree_set(frozenset(expected), expected))
+
+  def test_pass_list_fails(self):
+    with self.assertRaises(TypeError):
+      absl_example.check_btree_set([1, 2], [1, 2])
+
+
+class AbslBTreeMultisetTest(absltest.TestCase):
+
+  def test_return_sorted_list(self):
+    self.assertEqual(
+        [1, 3, 3, 5], absl_example.make_btree_multiset([5, 3, 1, 3]))
+
+  def test_pass_sequence(self):
+    self.assertTrue(
+        absl_example.check_btree_multiset([1, 3, 3, 5], [3, 5, 3, 1]))
+    self.assertTrue(
+        absl_example.check_btree_multiset((5, 3, 3, 1), [3, 5, 3, 1]))
+
+  def test_pass_set(self):
+    self.assertTrue(absl_example.check_btree_multiset({1, 2}, [2, 1]))
+
+
+class AbslBTreeMultimapTest(absltest.TestCase):
+
+  def test_return_list_of_pairs(self):
+    self.assertEqual(
+        [(1, 'a'), (2, 'b'), (2, 'c')],
+        absl_example.make_btree_multimap([(2, 'b'), (1, 'a'), (2, 'c')]))
+
+  def test_pass_sequence_of_pairs(self):
+    pairs = [(1, 'a'), (2, 'b'), (2, 'c')]
+    self.assertTrue(absl_example.check_btree_multimap(pairs, pairs))
+    self.assertTrue(
+        absl_example.check_btree_multimap([[1, 'a'], [2, 'b'], [2, 'c']],
+                                          pairs))
+
+  def test_pass_dict(self):
+    self.assertTrue(
+        absl_example.check_btree_multimap({1: 'a', 2: 'b'},
+                                          [(1, 'a'), (2, 'b')]))
+
+
+class AbslInlinedVectorTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(
+      ('list', [0.5, 1.5, 2.0]),
+      ('tuple', (0.5, 1.5, 2.0)),
+      ('user_list', collections.UserList([0.5, 1.5, 2.0])),
+      ('numpy', np.array([0.5, 1.5, 2.0])),
+      ('array', array.array('d', [0.5, 1.5, 2.0])),
+      ('memoryview', memoryview(array.array('d', [0.5, 1.5, 2.0]))),
+      ('converted_ints', [1, 1, 2]),
+      ('converted_numpy_ints', np.array([1, 1, 2], dtype=np.int64)),
+  )
+  def test_load(self, values):
+    self.assertEqual(absl_example.sum_inlined_vector(values), 4.0)
+
+  def test_load_empty(self):
+    self.assertEqual(absl_example.sum_inlined_vector([]), 0.0)
+    self.assertEqual(absl_example.sum_inlined_vector(np.zeros(0)), 0.0)
+
+  @parameterized.parameters(1, 4)
+  def test_load_within_inline_capacity_does_not_allocate(self, size):
+    self.assertTrue(absl_example.inlined_vector_is_inline([0.5] * size))
+    self.assertTrue(absl_example.inlined_vector_is_inline(np.ones(size)))
+
+  def test_load_beyond_inline_capacity(self):
+    self.assertFalse(absl_example.inlined_vector_is_inline([0.5] * 5))
+    self.assertFalse(absl_example.inlined_vector_is_inline(np.ones(5)))
+    self.assertEqual(absl_example.sum_inlined_vector(np.ones(100)), 100.0)
+
+  @parameterized.named_parameters(
+      ('str', 'ab'),
+      ('bytes', b'ab'),
+      ('set', {0.5}),
+      ('items', [0.5, 'x']),
+  )
+  def test_load_fails(self, values):
+    with self.assertRaises(TypeError):
+      absl_example.sum_inlined_vector(values)
+
+  def test_load_strings(self):
+    self.assertEqual(
+        absl_example.join_inlined_strings(['a', b'b', 'c']), 'a,b,c')
+
+  def test_cast(self):
+    self.assertEqual(absl_example.make_inlined_vector(3), [0.5, 1.5, 2.5])
+    self.assertEqual(absl_example.make_inlined_vector(6), [
+        0.5, 1.5, 2.5, 3.5, 4.5, 5.5])
+
+
+class AbslFixedArrayTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(
+      ('list', [1, 2, 3]),
+      ('tuple', (1, 2, 3)),
+      ('numpy', np.array([1, 2, 3], dtype=np.int64)),
+      ('converted_numpy_int32', np.array([1, 2, 3], dtype=np.int32)),
+      ('range', range(1, 4)),
+  )
+  def test_load(self, values):
+    self.assertEqual(absl_example.sum_fixed_array(values), 6)
+
+  @parameterized.parameters(1, 4)
+  def test_load_within_inline_capacity_does_not_allocate(self, size):
+    self.assertTrue(absl_example.fixed_array_is_inline([1] * size))
+    self.assertTrue(
+        absl_example.fixed_array_is_inline(np.ones(size, dtype=np.int64)))
+
+  def test_load_beyond_inline_capacity(self):
+    self.assertFalse(absl_example.fixed_array_is_inline([1] * 5))
+    self.assertEqual(
+        absl_example.sum_fixed_array(np.ones(100, dtype=np.int64)), 100)
+
+  def test_load_float_fails(self):
+    with self.assertRaises(TypeError):
+      absl_example.sum_fixed_array([1.5])
+
+  def test_cast(self):
+    self.assertEqual(absl_example.make_fixed_array(0), [])
+    self.assertEqual(absl_example.make_fixed_array(5), [0, 1, 2, 3, 4])
+
+
+@absltest.skipIf(sys.version_info < (3, 9),
+                 'Buffer slots of heap types require Python 3.9.')
+class AbslArrayViewTest(absltest.TestCase):
+
+  def test_reference_internal_is_read_only_view(self):
+    holder = absl_example.ArrayHolder()
+    values = holder.values
+    self.assertIsInstance(values, memoryview)
+    self.assertTrue(values.readonly)
+    self.assertEqual(values.format, 'd')
+    self.assertEqual(values.tolist(), [0.5, 1.5])
+    with self.assertRaises(TypeError):
+      values[0] = 2.5
+
+  def test_view_keeps_parent_alive(self):
+    counts = absl_example.ArrayHolder().counts
+    self.assertEqual(counts.tolist(), [0, 0, 0])
+    np.testing.assert_array_equal(np.asarray(counts), [0, 0, 0])
+
+  def test_mutable_reference_is_writable_view(self):
+    holder = absl_example.ArrayHolder()
+    counts = holder.mutable_counts()
+    self.assertFalse(counts.readonly)
+    counts[1] = 7
+    np.asarray(counts)[2] = 9
+    self.assertEqual(holder.counts.tolist(), [0, 7, 9])
+
+
+class AbslBTreeMapBindTest(absltest.TestCase):
+
+  def test_is_ordered_mutable_mapping(self):
+    m = absl_example.StringToIntBtreeMap()
+    self.assertIsInstance(m, collections.abc.MutableMapping)
+    for key in ['c', 'a', 'b']:
+      m[key] = ord(key)
+    self.assertEqual(list(m), ['a', 'b', 'c'])
+    self.assertEqual(list(reversed(m)), ['c', 'b', 'a'])
+    self.assertEqual(m[b'b'], ord('b'))
+    self.assertIn(b'c', m)
+    self.assertEqual(m, {'a': 97, 'b': 98, 'c': 99})
+    self.assertEqual(list(m.items()), [('a', 97), ('b', 98), ('c', 99)])
+    self.assertEqual(m.popitem(), ('a', 97))
+
+  def test_irange(self):
+    m = absl_example.make_opaque_btree_map(5)  # key0 ... key4
+    self.assertEqual(list(m.irange('key1', 'key3')), ['key1', 'key2'])
+    self.assertEqual(list(m.irange(lo='key3')), ['key3', 'key4'])
+    self.assertEqual(list(m.irange(hi='key1')), ['key0'])
+    self.assertEqual(
+        list(m.irange('key1', 'key3', reverse=True)), ['key2', 'key1'])
+    self.assertEqual(list(m.irange('key3', 'key1')), [])
+    self.assertEqual(list(m.irange('z')), [])
+    self.assertLen(list(m.irange()), 5)
+
+  def test_bounds(self):
+    m = absl_example.make_opaque_btree_map(3)
+    self.assertEqual(m.lower_bound('key1'), 'key1')
+    self.assertEqual(m.upper_bound('key1'), 'key2')
+    self.assertEqual(m.lower_bound('a'), 'key0')
+    self.assertIsNone(m.upper_bound('key2'))
+
+  def test_items_range(self):
+    m = absl_example.make_opaque_btree_map(4)
+    self.assertEqual(
+        list(m.items_range('key1', 'key3')), [('key1', 1), ('key2', 2)])
+    self.assertEqual(list(m.items_range(hi='key1')), [('key0', 0)])
+    self.assertEqual(list(m.items_range('key3')), [('key3', 3)])
+    self.assertEqual(
+        list(m.items_range('key1', 'key3', reverse=True)),
+        [('key2', 2), ('key1', 1)])
+    self.assertEqual(list(m.items_range('key3', 'key1')), [])
+    self.assertLen(list(m.items_range()), 4)
+
+  def test_get_pop(self):
+    m = absl_example.make_opaque_btree_map(2)
+    self.assertEqual(m.get('key1'), 1)
+    self.assertEqual(m.pop(b'key0'), 0)
+    self.assertEqual(list(m), ['key1'])
+
+
 class AbslOptionalTest(absltest.TestCase):
 
   def test_pass_default_nullopt(self):
@@ -627,6 +1539,59 @@ class AbslVariantTest(absltest.TestCase):
   def test_return_none(self):
     self.assertIsNone(absl_example.make_variant())
 
+  def test_wide_variant_dispatch(self):
+    cases = [
+        (1, 0),
+        (1.5, 1),
+        ('s', 2),
+        (b's', 2),
+        (datetime.datetime(2024, 1, 1, tzinfo=datetime.timezone.utc), 3),
+        (datetime.date(2024, 1, 1), 3),
+        (datetime.timedelta(seconds=1), 4),
+        ([1.5, 2.5], 5),
+    ]
+    for _ in range(3):  # Later rounds dispatch through the per-type cache.
+      for value, expected_index in cases:
+        with self.subTest(value=value):
+          self.assertEqual(
+              absl_example.wide_variant_index(value), expected_index)
+
+  def test_wide_variant_no_match(self):
+    for _ in range(2):
+      with self.assertRaises(TypeError):
+        absl_example.wide_variant_index(None)
+
+  def test_std_variant_type_cached(self):
+
+    class FloatNamespace(types.SimpleNamespace):
+
+      def __float__(self):
+        return 1.5
+
+    cases = [
+        (datetime.timedelta(seconds=1), 0),
+        (1.5, 1),
+        (FloatNamespace(), 1),
+        # Same type as the previous object, but loads as a timedelta.
+        (FloatNamespace(days=1, seconds=0, microseconds=0), 0),
+        (FloatNamespace(), 1),
+    ]
+    for _ in range(2):
+      for value, expected_index in cases:
+        with self.subTest(value=value):
+          self.assertEqual(
+              absl_example.std_duration_or_double_index(value), expected_index)
+
+  def test_value_dependent_int_alternatives(self):
+    for value, expected_index in [(5, 0), (300, 1), (5, 0), (-200, 1),
+                                  (-5, 0)]:
+      self.assertEqual(absl_example.int_variant_index(value), expected_index)
+
+  def test_value_dependent_sequence_alternatives(self):
+    for value, expected_index in [([1.5], 1), ([1], 0), ([2.5], 1), ([], 0)]:
+      self.assertEqual(
+          absl_example.vector_variant_index(value), expected_index)
+
 
 if __name__ == '__main__':
   absltest.main()
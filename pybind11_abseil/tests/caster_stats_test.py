@@ -0,0 +1,151 @@
+# Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for the pybind11_abseil.stats module."""
+
+import json
+import threading
+
+from absl.testing import absltest
+import numpy as np
+
+from pybind11_abseil import stats
+from pybind11_abseil import status
+from pybind11_abseil.tests import absl_example
+from pybind11_abseil.tests import status_example
+
+
+class AbslStatusCapsule:
+
+  def as_absl_Status(self):  # pylint: disable=invalid-name
+    return status_example.make_absl_status_capsule(False)
+
+
+class StatsTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    stats.reset()
+
+  def test_snapshot_layout(self):
+    snapshot = stats.snapshot()
+    for caster in ('span', 'cord', 'hash_map', 'hash_set', 'btree_map',
+                   'btree_set', 'array', 'status', 'statusor'):
+      self.assertCountEqual(
+          snapshot[caster],
+          (
+              'calls',
+              'fast_path',
+              'fallback',
+              'elements',
+              'bytes_copied',
+              'capsule',
+              'as_absl_status',
+          ),
+      )
+    self.assertIn('NOT_FOUND', snapshot['status_not_ok'])
+    self.assertIn('OTHER', snapshot['status_not_ok'])
+
+  def test_reset(self):
+    absl_example.check_span([1, 2], [1, 2])
+    stats.reset()
+    snapshot = stats.snapshot()
+    self.assertEqual(snapshot['span']['calls'], 0)
+    self.assertEqual(snapshot['status_not_ok']['CANCELLED'], 0)
+
+  def test_span(self):
+    if not stats.enabled():
+      self.skipTest('Built without PYBIND11_ABSEIL_ENABLE_CASTER_STATS.')
+    values = [1, 2, 3]
+    self.assertTrue(
+        absl_example.check_span(np.array(values, dtype=np.int32), values)
+    )
+    self.assertTrue(absl_example.check_span(values, values))
+    span = stats.snapshot()['span']
+    self.assertEqual(span['calls'], 2)
+    self.assertEqual(span['fast_path'], 1)
+    self.assertEqual(span['fallback'], 1)
+    self.assertEqual(span['elements'], 6)
+    self.assertEqual(span['bytes_copied'], 3 * np.dtype(np.int32).itemsize)
+
+  def test_btree_multi_containers(self):
+    if not stats.enabled():
+      self.skipTest('Built without PYBIND11_ABSEIL_ENABLE_CASTER_STATS.')
+    self.assertTrue(absl_example.check_btree_multiset([2, 1, 2], [1, 2, 2]))
+    self.assertTrue(
+        absl_example.check_btree_multimap(
+            [(1, 'a'), (1, 'b')], [(1, 'a'), (1, 'b')]
+        )
+    )
+    self.assertTrue(absl_example.check_btree_multimap({1: 'a'}, [(1, 'a')]))
+    snapshot = stats.snapshot()
+    self.assertEqual(snapshot['btree_set']['calls'], 1)
+    self.assertEqual(snapshot['btree_set']['elements'], 3)
+    self.assertEqual(snapshot['btree_map']['calls'], 2)
+    self.assertEqual(snapshot['btree_map']['elements'], 3)
+
+  def test_status_capsule_and_as_absl_status(self):
+    if not stats.enabled():
+      self.skipTest('Built without PYBIND11_ABSEIL_ENABLE_CASTER_STATS.')
+    capsule = status_example.make_absl_status_capsule(False)
+    for _ in range(2):
+      status_example.extract_code_message(capsule)
+    status_example.extract_code_message(AbslStatusCapsule())
+    snapshot = stats.snapshot()['status']
+    self.assertEqual(snapshot['capsule'], 2)
+    self.assertEqual(snapshot['as_absl_status'], 1)
+    self.assertEqual(snapshot['fallback'], 3)
+
+  def test_status_not_ok(self):
+    if not stats.enabled():
+      self.skipTest('Built without PYBIND11_ABSEIL_ENABLE_CASTER_STATS.')
+    for _ in range(2):
+      with self.assertRaises(status.StatusNotOk):
+        status_example.return_status(status.StatusCode.CANCELLED, 'test')
+    self.assertEqual(stats.snapshot()['status_not_ok']['CANCELLED'], 2)
+
+  def test_counts_exited_threads(self):
+    if not stats.enabled():
+      self.skipTest('Built without PYBIND11_ABSEIL_ENABLE_CASTER_STATS.')
+    thread = threading.Thread(
+        target=absl_example.check_span, args=([1, 2], [1, 2])
+    )
+    thread.start()
+    thread.join()
+    self.assertEqual(stats.snapshot()['span']['calls'], 1)
+
+
+class BoundaryTracerTest(absltest.TestCase):
+
+  def test_one_track_per_thread_across_modules(self):
+    stats.clear_trace()
+    stats.start_tracing()
+    try:
+
+      def work():
+        status_example.instrumented_noop()
+        absl_example.instrumented_noop()
+        status_example.instrumented_noop()
+
+      thread = threading.Thread(target=work)
+      thread.start()
+      thread.join()
+    finally:
+      stats.stop_tracing()
+    events = json.loads(stats.trace_json())['traceEvents']
+    stats.clear_trace()
+    spans = [
+        e
+        for e in events
+        if e['ph'] == 'X'
+        and e['name'] in ('status_example.noop', 'absl_example.noop')
+    ]
+    self.assertLen(spans, 6)  # exec and result spans.
+    self.assertLen({e['tid'] for e in spans}, 1)
+    thread_names = [e for e in events if e['ph'] == 'M']
+    self.assertLen(thread_names, len({e['tid'] for e in thread_names}))
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -1,13 +1,25 @@
+#include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "pybind11_abseil/cancellation_token.h"
+#include "pybind11_abseil/instrumented_binding.h"
+#include "pybind11_abseil/py_batched_source.h"
 #include "pybind11_abseil/status_casters.h"
+#include "pybind11_abseil/statusor_stream.h"
 
 namespace pybind11 {
 namespace test {
@@ -113,6 +125,58 @@ absl::StatusOr<int> CallGetRedirectToPython(IntGetter* ptr, int i) {
       "Function parameter should not be nullptr.");
 }
 
+// The number of records pulled by the count_to() streams so far.
+std::atomic<int> pulled_count{0};
+
+// A stream of 0, 1, ..., size - 1 that fails at fail_at (if not negative),
+// pulling each record in delay_ms.
+std::unique_ptr<google::StatusOrStream<int>> CountTo(
+    int size, int fail_at, std::size_t batch_size,
+    std::size_t max_pending_batches, int delay_ms) {
+  google::StatusOrStreamOptions options;
+  options.batch_size = batch_size;
+  options.max_pending_batches = max_pending_batches;
+  return google::MakeStatusOrStream<int>(
+      [next = 0, size, fail_at,
+       delay_ms]() mutable -> absl::StatusOr<std::optional<int>> {
+        if (delay_ms > 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        }
+        if (next == fail_at) {
+          return absl::InvalidArgumentError("Failed at " +
+                                            std::to_string(fail_at));
+        }
+        if (next >= size) return std::nullopt;
+        ++pulled_count;
+        return next++;
+      },
+      options);
+}
+
+// The sum of the first count (all if negative) items of source.
+absl::StatusOr<int> SumBatched(google::PyBatchedSource<int> source,
+                               int count = -1) {
+  int sum = 0;
+  for (int i = 0; count < 0 || i < count; ++i) {
+    absl::StatusOr<absl::optional<int>> item = source();
+    if (!item.ok()) return item.status();
+    if (!item->has_value()) break;
+    sum += **item;
+  }
+  return sum;
+}
+
+// A status held by C++ only (see hold_status()).
+absl::Status* held_status = new absl::Status();
+
+// Polls token every millisecond until it is cancelled.
+absl::Status WaitUntilCancelled(const google::CancellationToken& token) {
+  while (!token.cancelled()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return token.status();
+}
+
 PYBIND11_MODULE(status_example, m) {
   m.attr("PYBIND11_HAS_RETURN_VALUE_POLICY_CLIF_AUTOMATIC") =
 #if defined(PYBIND11_HAS_RETURN_VALUE_POLICY_CLIF_AUTOMATIC)
@@ -164,6 +228,10 @@ PYBIND11_MODULE(status_example, m) {
            arg("text") = "")
       .def("make_failure_status_or",
            google::DoNotThrowStatus(&TestClass::MakeFailureStatusOr),
+           arg("code"), arg("text") = "")
+      .def("instrumented_make_status_const",
+           google::Instrumented("TestClass.make_status_const",
+                                &TestClass::MakeStatusConst),
            arg("code"), arg("text") = "");
 
   // absl::Status bindings
@@ -228,6 +296,93 @@ PYBIND11_MODULE(status_example, m) {
     return cast(absl::OkStatus());
   });
 
+  google::bind_statusor_stream<int>(m, "IntStream");
+  m.def("count_to", &CountTo, arg("size"), arg("fail_at") = -1,
+        arg("batch_size") = 256, arg("max_pending_batches") = 4,
+        arg("delay_ms") = 0);
+  m.def("pulled_count", []() { return pulled_count.load(); });
+
+  m.def("sum_batched", &SumBatched, arg("source"), arg("count") = -1,
+        call_guard<gil_scoped_release>());
+  m.def(
+      "sum_batched_with_batch_size",
+      [](handle iterable, std::size_t batch_size, int count) {
+        google::PyBatchedSource<int> source(iterable, batch_size);
+        gil_scoped_release release;
+        return SumBatched(std::move(source), count);
+      },
+      arg("iterable"), arg("batch_size"), arg("count") = -1);
+  // Pulls the first item of iterable, then destroys the source, holding the
+  // items pulled ahead, without the GIL.
+  m.def(
+      "pull_first_and_drop_source",
+      [](handle iterable) {
+        absl::optional<google::PyBatchedSource<object>> source;
+        source.emplace(iterable);
+        absl::StatusOr<absl::optional<object>> first = (*source)();
+        {
+          gil_scoped_release release;
+          source.reset();
+        }
+        return first.ok() && first->has_value();
+      },
+      arg("iterable"));
+
+  m.def(
+      "hold_status",
+      [](const absl::Status& status) { *held_status = status; },
+      arg("status"));
+  m.def(
+      "drop_held_status_on_thread",
+      []() {
+        std::thread([]() { *held_status = absl::OkStatus(); }).join();
+      },
+      call_guard<gil_scoped_release>());
+
+  m.def("wait_until_cancelled", &WaitUntilCancelled, arg("timeout") = none(),
+        call_guard<gil_scoped_release>());
+  m.def("cancelled_status", []() {
+    google::CancellationToken token;
+    token.Cancel();
+    return token.status();
+  });
+
+  // Bindings wrapped with Instrumented().
+  m.def("instrumented_return_status",
+        google::Instrumented("status_example.return_status", &ReturnStatus),
+        arg("code"), arg("text") = "");
+  m.def("instrumented_make_status",
+        google::Instrumented("status_example.make_status",
+                             google::DoNotThrowStatus(&ReturnStatus)),
+        arg("code"), arg("text") = "");
+  m.def("instrumented_return_value_status_or",
+        google::Instrumented("status_example.return_value_status_or",
+                             &ReturnValueStatusOr),
+        arg("value"));
+  m.def("instrumented_noop",
+        google::Instrumented("status_example.noop", []() {}));
+  m.def("instrumented_throw",
+        google::Instrumented("status_example.throw", [](int) -> int {
+          throw std::runtime_error("instrumented_throw");
+        }));
+  // Overloads: a call to the second loads the first argument of the first.
+  m.def("instrumented_overloaded",
+        google::Instrumented("status_example.overloaded_ints",
+                             [](int a, int b) { return a + b; }),
+        arg("a"), arg("b"));
+  m.def("instrumented_overloaded",
+        google::Instrumented(
+            "status_example.overloaded_int_str",
+            [](int a, const std::string& b) { return std::to_string(a) + b; }),
+        arg("a"), arg("b"));
+  m.def("instrumented_call_status_callback",
+        google::Instrumented(
+            "status_example.call_status_callback",
+            [](const std::function<absl::Status()>& callback) {
+              return callback();
+            }),
+        arg("callback"), call_guard<gil_scoped_release>());
+
 #if defined(PYBIND11_HAS_RETURN_VALUE_POLICY_CLIF_AUTOMATIC)
   m.def(
       "return_ok_status_direct", []() { return absl::OkStatus(); },
@@ -1,5 +1,16 @@
+import asyncio
+import datetime
+import json
+import os
+import signal
+import sys
+import threading
+import time
+import weakref
+
 from absl.testing import absltest
 from absl.testing import parameterized
+from pybind11_abseil import stats
 from pybind11_abseil import status
 from pybind11_abseil.tests import status_example
 
@@ -130,6 +141,17 @@ class StatusTest(parameterized.TestCase):
     # result_1 and 2 reference the same value, so they should always be equal.
     self.assertEqual(result_1.code(), result_2.code())
 
+  def test_status_ref_replaced_from_cpp(self):
+    ref = status_example.make_status_ref(status.StatusCode.CANCELLED, 'aaaa')
+    self.assertEqual(ref.message(), 'aaaa')
+    hash(ref)
+    # Same code and message size, possibly at the address of the old message.
+    status_example.make_status_ref(status.StatusCode.CANCELLED, 'bbbb')
+    self.assertEqual(ref.message(), 'bbbb')
+    self.assertEqual(
+        hash(ref), hash(status.Status(status.StatusCode.CANCELLED, 'bbbb'))
+    )
+
   def test_make_status_ptr(self):
     result_1 = status_example.make_status_ptr(status.StatusCode.OK)
     self.assertEqual(result_1.code(), status.StatusCode.OK)
@@ -240,6 +262,25 @@ class IntGetter(status_example.IntGetter):
     return i
 
 
+class PayloadReleaseTest(absltest.TestCase):
+
+  def test_payload_released_after_dropped_without_gil(self):
+    payload = b'\x08' * 4096
+    st = status.Status(status.StatusCode.CANCELLED, '')
+    st.SetPayload('Url', payload)
+    status_example.hold_status(st)
+    del st
+    refcount = sys.getrefcount(payload)
+    # The C++ thread does not acquire the GIL: the buffer is released by a
+    # pending call, run by the main thread.
+    status_example.drop_held_status_on_thread()
+    for _ in range(1000):
+      if sys.getrefcount(payload) < refcount:
+        break
+      time.sleep(0.001)
+    self.assertLess(sys.getrefcount(payload), refcount)
+
+
 class StatusOrTest(absltest.TestCase):
 
   def test_return_value_status_or_return_type_from_doc(self):
@@ -324,5 +365,453 @@ class StatusOrTest(absltest.TestCase):
       status_example.call_get_redirect_to_python(int_getter, 100)
 
 
+class StatusOrStreamTest(absltest.TestCase):
+
+  def test_iterate(self):
+    self.assertEqual(list(status_example.count_to(1000)), list(range(1000)))
+
+  def test_iterate_small_batches(self):
+    stream = status_example.count_to(100, batch_size=3, max_pending_batches=1)
+    self.assertEqual(list(stream), list(range(100)))
+
+  def test_empty(self):
+    self.assertEmpty(list(status_example.count_to(0)))
+
+  def test_not_ok_at_failing_record(self):
+    stream = status_example.count_to(100, fail_at=42, batch_size=10)
+    records = []
+    with self.assertRaises(status.StatusNotOk) as cm:
+      for record in stream:
+        records.append(record)
+    self.assertEqual(records, list(range(42)))
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.INVALID_ARGUMENT)
+    self.assertEqual(cm.exception.status.message(), 'Failed at 42')
+    self.assertEmpty(list(stream))
+
+  def test_backpressure(self):
+    pulled = status_example.pulled_count()
+    stream = status_example.count_to(
+        1000000, batch_size=10, max_pending_batches=2)
+    self.assertEqual(next(stream), 0)
+    time.sleep(0.2)
+    # The batch handed over, 2 pending batches and the one being filled.
+    self.assertLessEqual(status_example.pulled_count() - pulled, 40)
+    stream.close()
+
+  def test_close(self):
+    stream = status_example.count_to(1000000, batch_size=10)
+    self.assertEqual(next(stream), 0)
+    stream.close()
+    pulled = status_example.pulled_count()
+    records = list(stream)
+    self.assertLessEqual(len(records), 60)
+    self.assertEqual(records, list(range(1, len(records) + 1)))
+    self.assertEqual(status_example.pulled_count(), pulled)
+
+  def test_async_iterate(self):
+    async def collect():
+      return [r async for r in status_example.count_to(1000, batch_size=7)]
+
+    self.assertEqual(asyncio.run(collect()), list(range(1000)))
+
+  def test_async_not_ok(self):
+    async def collect(records):
+      async for record in status_example.count_to(10, fail_at=5):
+        records.append(record)
+
+    records = []
+    with self.assertRaises(status.StatusNotOk) as cm:
+      asyncio.run(collect(records))
+    self.assertEqual(records, list(range(5)))
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.INVALID_ARGUMENT)
+
+  def test_async_close_while_awaiting(self):
+    async def collect():
+      stream = status_example.count_to(10, batch_size=1, delay_ms=300)
+      # Closes the stream while `async for` awaits the first record.
+      asyncio.get_running_loop().call_later(0.05, stream.close)
+      return [r async for r in stream]
+
+    self.assertEmpty(asyncio.run(asyncio.wait_for(collect(), timeout=10)))
+
+  def test_async_concurrent_anext_raises(self):
+    async def race():
+      stream = status_example.count_to(10, batch_size=1, delay_ms=100)
+      first = stream.__anext__()
+      with self.assertRaises(RuntimeError):
+        stream.__anext__()
+      self.assertEqual(await first, 0)
+      self.assertEqual(await stream.__anext__(), 1)
+      stream.close()
+
+    asyncio.run(race())
+
+
+class PyBatchedSourceTest(absltest.TestCase):
+
+  def _counting(self, items):
+    self.pulled = 0
+    for item in items:
+      self.pulled += 1
+      yield item
+
+  def test_sum(self):
+    self.assertEqual(status_example.sum_batched(range(1000)), 499500)
+    self.assertEqual(status_example.sum_batched([1, 2, 3]), 6)
+    self.assertEqual(status_example.sum_batched(iter((1, 2))), 3)
+
+  def test_empty(self):
+    self.assertEqual(status_example.sum_batched([]), 0)
+
+  def test_not_iterable(self):
+    with self.assertRaises(TypeError):
+      status_example.sum_batched(1)
+
+  def test_pulls_batches(self):
+    items = self._counting(range(100))
+    self.assertEqual(
+        status_example.sum_batched_with_batch_size(items, 8, count=1), 0)
+    self.assertEqual(self.pulled, 8)
+    items = self._counting(range(100))
+    self.assertEqual(
+        status_example.sum_batched_with_batch_size(items, 8, count=9), 36)
+    self.assertEqual(self.pulled, 16)
+
+  def test_batch_sizes(self):
+    for batch_size in (0, 1, 3, 1000):
+      self.assertEqual(
+          status_example.sum_batched_with_batch_size(range(10), batch_size),
+          45)
+
+  def test_status_not_ok_from_iterator(self):
+    def items():
+      yield 1
+      raise status.StatusNotOk(
+          status.Status(status.StatusCode.NOT_FOUND, 'no more'))
+
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.sum_batched(items())
+    self.assertEqual(cm.exception.status.code(), status.StatusCode.NOT_FOUND)
+    self.assertEqual(cm.exception.status.message(), 'no more')
+
+  def test_exception_from_iterator(self):
+    def items():
+      yield 1
+      raise ValueError('bad item')
+
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.sum_batched(items())
+    self.assertEqual(cm.exception.status.code(), status.StatusCode.OUT_OF_RANGE)
+    self.assertIn('bad item', cm.exception.status.message())
+
+  def test_items_before_exception(self):
+    def items():
+      yield 1
+      yield 2
+      raise ValueError('bad item')
+
+    self.assertEqual(status_example.sum_batched(items(), count=2), 3)
+
+  def test_conversion_error(self):
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.sum_batched([1, 'two', 3])
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.INVALID_ARGUMENT)
+
+  def test_items_pulled_ahead_released(self):
+    class Item:
+      pass
+
+    refs = []
+
+    def items():
+      for _ in range(10):
+        item = Item()
+        refs.append(weakref.ref(item))
+        yield item
+
+    # The first batch ends the iteration: the source holds the other items,
+    # but no iterator anymore.
+    self.assertTrue(status_example.pull_first_and_drop_source(items()))
+    self.assertLen(refs, 10)
+    self.assertEqual([ref() for ref in refs], [None] * 10)
+
+
+class CancellationTokenTest(absltest.TestCase):
+
+  def test_cancel(self):
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.cancelled_status()
+    self.assertEqual(cm.exception.status.code(), status.StatusCode.CANCELLED)
+
+  def test_timeout(self):
+    start = time.monotonic()
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.wait_until_cancelled(
+          timeout=datetime.timedelta(milliseconds=50))
+    self.assertGreaterEqual(time.monotonic() - start, 0.05)
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.DEADLINE_EXCEEDED)
+
+  def test_timeout_seconds(self):
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.wait_until_cancelled(timeout=0.01)
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.DEADLINE_EXCEEDED)
+
+  def test_deadline(self):
+    deadline = datetime.datetime.now(
+        datetime.timezone.utc) + datetime.timedelta(milliseconds=20)
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.wait_until_cancelled(timeout=deadline)
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.DEADLINE_EXCEEDED)
+
+  def test_past_deadline(self):
+    deadline = datetime.datetime(2000, 1, 1, tzinfo=datetime.timezone.utc)
+    with self.assertRaises(status.StatusNotOk) as cm:
+      status_example.wait_until_cancelled(timeout=deadline)
+    self.assertEqual(cm.exception.status.code(),
+                     status.StatusCode.DEADLINE_EXCEEDED)
+
+  def test_concurrent_timeouts(self):
+    errors = []
+
+    def wait(seconds):
+      try:
+        status_example.wait_until_cancelled(timeout=seconds)
+      except status.StatusNotOk as e:
+        errors.append(e.status.code())
+
+    threads = [
+        threading.Thread(target=wait, args=(0.01 * (i % 5),))
+        for i in range(20)
+    ]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertEqual(errors, [status.StatusCode.DEADLINE_EXCEEDED] * 20)
+
+  @absltest.skipIf(sys.platform == 'win32', 'SIGINT is not watched.')
+  def test_sigint(self):
+    timer = threading.Timer(0.05, os.kill, (os.getpid(), signal.SIGINT))
+    timer.start()
+    try:
+      with self.assertRaises(KeyboardInterrupt):
+        try:
+          status_example.wait_until_cancelled()
+        except status.StatusNotOk as e:
+          self.assertEqual(e.status.code(), status.StatusCode.CANCELLED)
+          # The pending SIGINT is handled at the latest here.
+          time.sleep(1)
+    finally:
+      timer.join()
+
+  @absltest.skipIf(sys.platform == 'win32', 'SIGINT is not watched.')
+  def test_sigint_handler_installed_once(self):
+    with self.assertRaises(status.StatusNotOk):
+      status_example.wait_until_cancelled(timeout=0.001)
+    handler = signal.getsignal(signal.SIGINT)
+    for _ in range(100):
+      with self.assertRaises(status.StatusNotOk):
+        status_example.wait_until_cancelled(timeout=0.001)
+    self.assertIs(signal.getsignal(signal.SIGINT), handler)
+    self.test_sigint()
+
+  @absltest.skipIf(not hasattr(os, 'fork'), 'Requires fork().')
+  def test_timeout_after_fork(self):
+    # Starts the deadline watcher thread in the parent.
+    self.test_timeout()
+    pid = os.fork()
+    if pid == 0:
+      code = 1
+      try:
+        # Fails instead of hanging if the deadline is not watched.
+        signal.alarm(10)
+        status_example.wait_until_cancelled(timeout=0.01)
+      except status.StatusNotOk as e:
+        if e.status.code() == status.StatusCode.DEADLINE_EXCEEDED:
+          code = 0
+      finally:
+        os._exit(code)
+    _, wait_status = os.waitpid(pid, 0)
+    self.assertTrue(os.WIFEXITED(wait_status))
+    self.assertEqual(os.WEXITSTATUS(wait_status), 0)
+
+
+class InstrumentedBindingTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    stats.reset_latencies()
+
+  def _latency(self, name):
+    return stats.latency_snapshot()[name]
+
+  def test_signature_is_unchanged(self):
+    self.assertEqual(
+        docstring_signature(status_example.instrumented_return_value_status_or),
+        'instrumented_return_value_status_or(value: int) -> int',
+    )
+
+  def test_status_outcomes(self):
+    self.assertIsNone(
+        status_example.instrumented_return_status(status.StatusCode.OK)
+    )
+    for _ in range(2):
+      with self.assertRaises(status.StatusNotOk):
+        status_example.instrumented_return_status(
+            status.StatusCode.NOT_FOUND, 'missing'
+        )
+    latency = self._latency('status_example.return_status')
+    self.assertEqual(latency['calls'], 3)
+    self.assertEqual(latency['outcomes'], {'OK': 1, 'NOT_FOUND': 2})
+    for phase in ('args', 'exec', 'result'):
+      self.assertEqual(latency[phase]['count'], 3)
+      self.assertLessEqual(latency[phase]['p50_ns'], latency[phase]['p99_ns'])
+      self.assertEqual(sum(n for _, n in latency[phase]['buckets']), 3)
+
+  def test_no_throw_status(self):
+    st = status_example.instrumented_make_status(status.StatusCode.CANCELLED)
+    self.assertEqual(st.code(), status.StatusCode.CANCELLED)
+    latency = self._latency('status_example.make_status')
+    self.assertEqual(latency['outcomes'], {'CANCELLED': 1})
+
+  def test_status_or(self):
+    self.assertEqual(status_example.instrumented_return_value_status_or(5), 5)
+    latency = self._latency('status_example.return_value_status_or')
+    self.assertEqual(latency['outcomes'], {'OK': 1})
+
+  def test_method(self):
+    tc = status_example.TestClass()
+    with self.assertRaises(status.StatusNotOk):
+      tc.instrumented_make_status_const(status.StatusCode.ABORTED)
+    latency = self._latency('TestClass.make_status_const')
+    self.assertEqual(latency['outcomes'], {'ABORTED': 1})
+
+  def test_no_arguments(self):
+    self.assertIsNone(status_example.instrumented_noop())
+    latency = self._latency('status_example.noop')
+    self.assertEqual(latency['calls'], 1)
+    self.assertEqual(latency['args']['count'], 0)
+    self.assertEqual(latency['exec']['count'], 1)
+    self.assertEqual(latency['result']['count'], 1)
+
+  def test_nested_call_during_argument_conversion(self):
+    sleep_s = 0.02
+
+    class SlowIndex:
+
+      def __index__(self):
+        time.sleep(sleep_s)
+        # Converts its own arguments while the outer call converts its own.
+        status_example.instrumented_make_status(status.StatusCode.OK)
+        return 5
+
+    self.assertEqual(
+        status_example.instrumented_return_value_status_or(SlowIndex()), 5
+    )
+    outer = self._latency('status_example.return_value_status_or')
+    self.assertEqual(outer['args']['count'], 1)
+    # The outer args phase includes the sleep (histogram error < 12.5%).
+    self.assertGreaterEqual(outer['args']['p50_ns'], sleep_s * 0.5e9)
+    inner = self._latency('status_example.make_status')
+    self.assertEqual(inner['calls'], 1)
+    self.assertLess(inner['args']['p50_ns'], sleep_s * 0.5e9)
+
+  def test_overloads(self):
+    self.assertEqual(status_example.instrumented_overloaded(1, 2), 3)
+    self.assertEqual(status_example.instrumented_overloaded(1, 'x'), '1x')
+    ints = self._latency('status_example.overloaded_ints')
+    int_str = self._latency('status_example.overloaded_int_str')
+    self.assertEqual(ints['calls'], 1)
+    self.assertEqual(ints['args']['count'], 1)
+    self.assertEqual(int_str['calls'], 1)
+    self.assertEqual(int_str['args']['count'], 1)
+
+  def test_cpp_exception(self):
+    with self.assertRaises(RuntimeError):
+      status_example.instrumented_throw(1)
+    latency = self._latency('status_example.throw')
+    self.assertEqual(latency['outcomes'], {'EXCEPTION': 1})
+
+  def test_failed_argument_conversion_is_not_recorded(self):
+    with self.assertRaises(TypeError):
+      status_example.instrumented_return_value_status_or('not an int')
+    latency = self._latency('status_example.return_value_status_or')
+    self.assertEqual(latency['calls'], 0)
+
+
+class BoundaryTracerTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    stats.clear_trace()
+    stats.start_tracing()
+
+  def tearDown(self):
+    stats.stop_tracing()
+    stats.clear_trace()
+    super().tearDown()
+
+  def _spans(self, name):
+    trace = json.loads(stats.trace_json())
+    return [
+        e
+        for e in trace['traceEvents']
+        if e['ph'] == 'X' and e['name'] == name
+    ]
+
+  def test_multithreaded_callbacks(self):
+    num_threads = 4
+    num_calls = 50
+    barrier = threading.Barrier(num_threads)
+
+    def work():
+      barrier.wait()
+      for _ in range(num_calls):
+        self.assertIsNone(
+            status_example.instrumented_call_status_callback(
+                status.Status.OkStatus
+            )
+        )
+
+    threads = [threading.Thread(target=work) for _ in range(num_threads)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    stats.stop_tracing()
+
+    spans = self._spans('status_example.call_status_callback')
+    for phase in ('args', 'exec', 'result'):
+      phase_spans = [e for e in spans if e['cat'] == phase]
+      self.assertLen(phase_spans, num_threads * num_calls)
+      self.assertLen({e['tid'] for e in phase_spans}, num_threads)
+    for e in spans:
+      self.assertGreaterEqual(e['dur'], 0)
+
+  def test_ring_buffer_keeps_latest_spans(self):
+    stats.stop_tracing()
+    stats.clear_trace()
+    stats.start_tracing(events_per_thread=8)
+    thread = threading.Thread(
+        target=lambda: [status_example.instrumented_noop() for _ in range(10)]
+    )
+    thread.start()
+    thread.join()
+    # 2 spans per call (no args span): only the last 8 are kept.
+    self.assertLen(self._spans('status_example.noop'), 8)
+
+  def test_not_recorded_when_stopped(self):
+    stats.stop_tracing()
+    self.assertFalse(stats.tracing())
+    status_example.instrumented_noop()
+    self.assertEmpty(self._spans('status_example.noop'))
+
+
 if __name__ == '__main__':
   absltest.main()
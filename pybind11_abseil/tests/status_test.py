@@ -1,4 +1,7 @@
+import builtins
+import gc
 import pickle
+import weakref
 
 from absl.testing import absltest
 from absl.testing import parameterized
@@ -108,6 +111,108 @@ class StatusTest(parameterized.TestCase):
     self.assertFalse(st.ErasePayload('UrlNeverExisted'))
     self.assertEqual(st.AllPayloads(), ())
 
+  @parameterized.parameters(10, 1 << 20)
+  def test_get_payload(self, payload_size):
+    st = status.Status(status.StatusCode.CANCELLED, '')
+    payload = b'\x03' * payload_size
+    st.SetPayload('Url', payload)
+    view = st.get_payload('Url')
+    self.assertIsInstance(view, memoryview)
+    self.assertTrue(view.readonly)
+    self.assertEqual(view, payload)
+    self.assertIsNone(st.get_payload('UrlNeverExisted'))
+    # The view is independent of the status.
+    self.assertTrue(st.ErasePayload('Url'))
+    del st
+    self.assertEqual(view.tobytes(), payload)
+
+  def test_set_payload_buffers(self):
+    st = status.Status(status.StatusCode.CANCELLED, '')
+    payload = bytearray(b'\x04' * 4096)
+    st.SetPayload('Url0', payload)
+    st.SetPayload('Url1', memoryview(b'\x05' * 4096))
+    # Mutable buffers are copied.
+    payload[0] = 0
+    self.assertEqual(st.get_payload('Url0'), b'\x04' * 4096)
+    self.assertEqual(st.get_payload('Url1'), b'\x05' * 4096)
+    with self.assertRaises(TypeError):
+      st.SetPayload('Url2', 1)
+
+  def test_set_payload_read_only_views_of_mutable_buffers(self):
+    st = status.Status(status.StatusCode.CANCELLED, '')
+    payload = bytearray(b'\x07' * 4096)
+    st.SetPayload('Url', memoryview(payload).toreadonly())
+    # Read-only, but mutable through payload: copied.
+    payload[0] = 0
+    self.assertEqual(st.get_payload('Url'), b'\x07' * 4096)
+
+  def test_payloads(self):
+    st = status.Status(status.StatusCode.CANCELLED, '')
+    self.assertEqual(list(st.payloads()), [])
+    st.SetPayload('Url1', 'Payload1')
+    st.SetPayload('Url0', b'\x06' * 4096)
+    payloads = {url: view for url, view in st.payloads()}
+    self.assertEqual(set(payloads), {b'Url0', b'Url1'})
+    self.assertIsInstance(payloads[b'Url0'], memoryview)
+    self.assertEqual(payloads[b'Url0'], b'\x06' * 4096)
+    self.assertEqual(payloads[b'Url1'], b'Payload1')
+
+  def test_payloads_iterates_lazily_over_a_snapshot(self):
+    st = status.Status(status.StatusCode.CANCELLED, '')
+    st.SetPayload('Url0', b'\x06' * 4096)
+    st.SetPayload('Url1', 'Payload1')
+    payloads = st.payloads()
+    self.assertIs(iter(payloads), payloads)
+    url, view = next(payloads)
+    # The status is modified while iterating: the iterator does not see it.
+    st.ErasePayload('Url0')
+    st.ErasePayload('Url1')
+    st.SetPayload('Url2', 'Payload2')
+    rest = list(payloads)
+    self.assertLen(rest, 1)
+    self.assertEqual(
+        dict([(url, bytes(view))] + [(u, bytes(v)) for u, v in rest]),
+        {b'Url0': b'\x06' * 4096, b'Url1': b'Payload1'})
+    self.assertEqual(list(payloads), [])
+
+  def test_accessors(self):
+    st = status.Status(status.StatusCode.NOT_FOUND, 'Gone')
+    self.assertEqual(st.message(), 'Gone')
+    self.assertIs(st.code(), status.StatusCode.NOT_FOUND)
+    self.assertEqual(st.__hash__(), hash(st))
+
+  def test_accessors_follow_update(self):
+    st = status.Status(status.StatusCode.OK, '')
+    self.assertEqual(st.message(), '')
+    ok_hash = hash(st)
+    st.update(status.Status(status.StatusCode.ABORTED, 'Abrtd'))
+    self.assertEqual(st.message(), 'Abrtd')
+    self.assertEqual(st.code(), status.StatusCode.ABORTED)
+    self.assertEqual(st.raw_code(), 10)
+    self.assertNotEqual(hash(st), ok_hash)
+
+  def test_accessors_follow_repeated_updates(self):
+    for code in (status.StatusCode.ABORTED, status.StatusCode.CANCELLED):
+      st = status.Status(status.StatusCode.OK, '')
+      self.assertEqual(st.message(), '')
+      self.assertIs(st.code(), status.StatusCode.OK)
+      st.update(status.Status(code, 'same'))
+      self.assertEqual(st.message(), 'same')
+      self.assertIs(st.code(), code)
+      self.assertEqual(hash(st), hash(status.Status(code, 'same')))
+
+  def test_accessors_of_subclass(self):
+
+    class Derived(status.Status):
+      pass
+
+    st = Derived(status.StatusCode.INTERNAL, 'Intrnl')
+    self.assertEqual(st.message(), 'Intrnl')
+    self.assertEqual(st.code_int(), 13)
+    self.assertEqual(
+        hash(st), hash(status.Status(status.StatusCode.INTERNAL, 'Intrnl'))
+    )
+
   def test_eq_and_hash(self):
     s0 = status.Status(status.StatusCode.CANCELLED, 'A')
     sb = status.Status(status.StatusCode.CANCELLED, 'A')
@@ -176,6 +281,43 @@ class StatusTest(parameterized.TestCase):
     self.assertEqual(deser, orig)
     self.assertIs(deser.__class__, orig.__class__)
 
+  @parameterized.parameters(10, 1 << 20)
+  def test_pickle_protocol_5_in_band(self, payload_size):
+    orig = status.Status(status.StatusCode.CANCELLED, 'Cucumber.')
+    orig.SetPayload('Url0', b'\x00' * payload_size)
+    orig.SetPayload('Url1', 'Payload1')
+    deser = pickle.loads(pickle.dumps(orig, protocol=5))
+    self.assertEqual(deser, orig)
+    self.assertEqual(deser.AllPayloads(), orig.AllPayloads())
+
+  @parameterized.parameters(10, 1 << 20)
+  def test_pickle_protocol_5_out_of_band(self, payload_size):
+    orig = status.Status(status.StatusCode.CANCELLED, 'Cucumber.')
+    orig.SetPayload('Url0', b'\x01' * payload_size)
+    orig.SetPayload('Url1', 'Payload1')
+    buffers = []
+    ser = pickle.dumps(orig, protocol=5, buffer_callback=buffers.append)
+    # The message and the payloads.
+    self.assertLen(buffers, 3)
+    self.assertLess(len(ser), 200)
+    deser = pickle.loads(ser, buffers=buffers)
+    self.assertEqual(deser, orig)
+    self.assertEqual(deser.AllPayloads(), orig.AllPayloads())
+    # The buffers are referenced, not copied: they may be released.
+    del buffers
+    self.assertEqual(
+        dict(deser.AllPayloads())[b'Url0'], b'\x01' * payload_size)
+
+  def test_pickle_protocol_5_out_of_band_as_bytes(self):
+    orig = status.Status(status.StatusCode.DATA_LOSS, 'Tomato.')
+    orig.SetPayload('Url', b'\x02' * 4096)
+    buffers = []
+    ser = pickle.dumps(orig, protocol=5, buffer_callback=buffers.append)
+    # E.g. buffers received from another process.
+    deser = pickle.loads(ser, buffers=[bytes(buf.raw()) for buf in buffers])
+    self.assertEqual(deser, orig)
+    self.assertEqual(deser.AllPayloads(), ((b'Url', b'\x02' * 4096),))
+
   def test_init_from_serialized_exception_unexpected_len_state(self):
     with self.assertRaisesRegex(
         ValueError, r'Unexpected len\(state\) == 4'
@@ -259,6 +401,121 @@ class StatusNotOkTest(absltest.TestCase):
     self.assertEqual(deser, orig)
     self.assertIs(deser.__class__, orig.__class__)
 
+  def test_exception_attributes(self):
+    e = status.BuildStatusNotOk(status.StatusCode.NOT_FOUND, 'Gone')
+    self.assertIsInstance(e, Exception)
+    self.assertEqual(e.args, ('Gone [NOT_FOUND]',))
+    self.assertEqual(status.StatusNotOk.__module__, status.__name__)
+    self.assertIsNone(status.StatusNotOk.__hash__)
+
+  def test_subclass(self):
+
+    class Derived(status.StatusNotOk):
+
+      def __str__(self):
+        return 'derived'
+
+    e = Derived(status.Status(status.StatusCode.ABORTED, 'Abrtd'))
+    self.assertEqual(e.code, int(status.StatusCode.ABORTED))
+    self.assertEqual(e.args, ('derived',))
+    with self.assertRaises(status.StatusNotOk):
+      raise e
+
+
+  def test_weakref(self):
+    e = status.BuildStatusNotOk(status.StatusCode.NOT_FOUND, 'Gone')
+    ref = weakref.ref(e)
+    self.assertIs(ref(), e)
+    del e
+    gc.collect()
+    self.assertIsNone(ref())
+
+  def test_private_status_attribute(self):
+    st = status.Status(status.StatusCode.ABORTED, 'Abrtd')
+    e = status.StatusNotOk(st)
+    self.assertIs(e._status, st)  # pylint: disable=protected-access
+
+    class SetsStatus(status.StatusNotOk):
+
+      def __init__(self, st):  # pylint: disable=super-init-not-called
+        self._status = st
+
+    e = SetsStatus(st)
+    self.assertIs(e.status, st)
+    self.assertEqual(e.code, int(status.StatusCode.ABORTED))
+
+
+class BatchTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    self.error = status.Status(status.StatusCode.NOT_FOUND, 'Nf')
+    self.capsule_error = NotACapsule(
+        status.Status(status.StatusCode.ABORTED, 'Ab').as_absl_Status())
+    self.results = [
+        1, self.error, 'two', status.Status.OkStatus(), None,
+        self.capsule_error, [3]
+    ]
+
+  def test_ok_mask(self):
+    self.assertEqual(
+        status.ok_mask(self.results), b'\x01\x00\x01\x01\x01\x00\x01')
+    self.assertEqual(
+        list(status.ok_mask(self.results)),
+        [int(status.is_ok(r)) for r in self.results])
+    self.assertEqual(status.ok_mask(()), b'')
+    self.assertEqual(status.ok_mask(iter([self.error])), b'\x00')
+
+  def test_partition(self):
+    values, indices, statuses = status.partition(self.results)
+    self.assertEqual(values, [1, 'two', status.Status.OkStatus(), None, [3]])
+    self.assertEqual(indices, [1, 5])
+    self.assertLen(statuses, 2)
+    self.assertIs(statuses[0], self.error)
+    self.assertIs(statuses[1], self.capsule_error)
+
+  def test_raise_if_any_ok(self):
+    self.assertIsNone(status.raise_if_any([1, status.Status.OkStatus()]))
+    self.assertIsNone(status.raise_if_any([]))
+
+  def test_raise_if_any(self):
+    exception_group = getattr(builtins, 'ExceptionGroup', None)
+    if exception_group is None:
+      with self.assertRaises(status.StatusNotOk) as ctx:
+        status.raise_if_any(self.results)
+      self.assertIs(ctx.exception.status, self.error)
+      return
+    with self.assertRaises(exception_group) as ctx:
+      status.raise_if_any(self.results)
+    self.assertEqual(
+        str(ctx.exception), '2 of 7 results are not ok (2 sub-exceptions)')
+    errors = ctx.exception.exceptions
+    self.assertLen(errors, 2)
+    self.assertIsInstance(errors[0], status.StatusNotOk)
+    self.assertIs(errors[0].status, self.error)
+    self.assertEqual(errors[1].status.code(), status.StatusCode.ABORTED)
+    self.assertEqual(errors[1].message, 'Ab')
+
+  def test_not_a_sequence(self):
+    with self.assertRaises(TypeError):
+      status.ok_mask(1)
+
+
+class StatusFactoryTest(absltest.TestCase):
+
+  def test_factory_is_created_once(self):
+    self.assertIs(status.not_found_error, status.not_found_error)
+    self.assertEqual(status.not_found_error.__name__, 'not_found_error')
+
+  def test_dir(self):
+    names = dir(status)
+    self.assertIn('unknown_error', names)
+    self.assertIn('StatusNotOk', names)
+
+  def test_unknown_attribute(self):
+    with self.assertRaises(AttributeError):
+      status.no_such_error  # pylint: disable=pointless-statement
+
 
 if __name__ == '__main__':
   absltest.main()
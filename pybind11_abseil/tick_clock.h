@@ -0,0 +1,77 @@
+// Copyright (c) 2024 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// The clock used by instrumented_binding.h and boundary_tracer.h: cheap to
+// read, monotonic, and converted to nanoseconds only when reporting.
+
+#ifndef PYBIND11_ABSEIL_TICK_CLOCK_H_
+#define PYBIND11_ABSEIL_TICK_CLOCK_H_
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+
+namespace pybind11 {
+namespace google {
+namespace internal {
+
+inline uint64_t SteadyClockNanos() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// The timestamp counter on x86 (invariant on all recent CPUs) and the virtual
+// counter on aarch64, else steady_clock.
+inline uint64_t CpuTicks() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return SteadyClockNanos();
+#endif
+}
+
+// Converts CpuTicks() to nanoseconds, calibrated against steady_clock over the
+// lifetime of the object.
+class TickCalibration {
+ public:
+  TickCalibration()
+      : start_ticks_(CpuTicks()), start_nanos_(SteadyClockNanos()) {}
+
+  double NanosPerTick() const {
+    uint64_t ticks = CpuTicks() - start_ticks_;
+    uint64_t nanos = SteadyClockNanos() - start_nanos_;
+    if (ticks == 0 || nanos == 0) return 1.0;
+    return static_cast<double>(nanos) / static_cast<double>(ticks);
+  }
+
+  // Nanoseconds between the creation of this object and ticks.
+  double NanosSinceStart(uint64_t ticks, double nanos_per_tick) const {
+    return (static_cast<double>(ticks) - static_cast<double>(start_ticks_)) *
+           nanos_per_tick;
+  }
+
+ private:
+  const uint64_t start_ticks_;
+  const uint64_t start_nanos_;
+};
+
+}  // namespace internal
+}  // namespace google
+}  // namespace pybind11
+
+#endif  // PYBIND11_ABSEIL_TICK_CLOCK_H_
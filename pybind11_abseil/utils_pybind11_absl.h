@@ -6,6 +6,8 @@
 
 #include <pybind11/pybind11.h>
 
+#include <exception>
+
 #include "absl/strings/string_view.h"
 
 namespace pybind11 {
@@ -15,6 +17,23 @@ namespace google {
 // `UnicodeDecodeError`.
 str decode_utf8_replace(absl::string_view s);
 
+// For functions called directly by the python C API (type slots, PyMethodDef
+// methods): runs body and returns its result, or sets the python error for a
+// C++ exception thrown by body and returns error_result.
+template <typename Body, typename Result>
+Result CallAndSetPyErr(Body&& body, Result error_result) {
+  try {
+    return body();
+  } catch (error_already_set& e) {
+    e.restore();
+  } catch (builtin_exception& e) {
+    e.set_error();
+  } catch (const std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+  }
+  return error_result;
+}
+
 }  // namespace google
 }  // namespace pybind11
 